@@ -4,9 +4,12 @@
 #include "engine/scene.h"
 #include "engine/misc.h"
 #include "oglwrap/smart_enums.h"
+#include "engine/debug/gl_memory.h"
 
 AfterEffects::AfterEffects(GameObject *parent, Skybox* skybox)
     : Behaviour(parent)
+    , tex_memory_("after effects", "framebuffer",
+                  engine::debug::MemoryTracker::Category::kGpuTexture)
     , uScreenSize_(prog_, "uScreenSize")
     , s_uSunPos_(prog_, "s_uSunPos")
     , uZNear_(prog_, "uZNear")
@@ -56,12 +59,15 @@ void AfterEffects::screenResized(size_t w, size_t h) {
 
   gl::Bind(color_tex_);
   color_tex_.upload(gl::kRgb, width_, height_, gl::kRgb, gl::kFloat, nullptr);
+  size_t tex_size = engine::debug::BoundTexture2DSize();
   gl::Unbind(color_tex_);
 
   gl::Bind(depth_tex_);
   depth_tex_.upload(gl::kDepthComponent, width_, height_,
                     gl::kDepthComponent, gl::kFloat, nullptr);
+  tex_size += engine::debug::BoundTexture2DSize();
   gl::Unbind(depth_tex_);
+  tex_memory_.resize(tex_size);
 }
 
 void AfterEffects::update() {
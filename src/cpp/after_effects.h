@@ -12,6 +12,7 @@
 
 #include "engine/behaviour.h"
 #include "engine/shader_manager.h"
+#include "engine/debug/memory_tracker.h"
 
 #include "./skybox.h"
 
@@ -26,6 +27,7 @@ class AfterEffects : public engine::Behaviour {
 
   gl::Framebuffer fbo_;
   gl::Texture2D color_tex_, depth_tex_;
+  engine::debug::MemoryTracker::Allocation tex_memory_;
   gl::LazyUniform<glm::vec2> uScreenSize_;
   gl::LazyUniform<glm::vec3> s_uSunPos_;
   gl::LazyUniform<float> uZNear_, uZFar_;
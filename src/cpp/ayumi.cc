@@ -3,100 +3,162 @@
 #include "./ayumi.h"
 
 #include <string>
+#include <vector>
 #include "engine/oglwrap_config.h"
 #include <GLFW/glfw3.h>
 
+#include "engine/input.h"
 #include "engine/scene.h"
+#include "engine/game_engine.h"
 
 using engine::AnimParams;
 
-engine::ShaderFile* Ayumi::loadVertexShader(engine::ShaderManager* manager) {
-  gl::ShaderSource vs_src("ayumi.vert");
-  vs_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
-  vs_src.insertMacroValue("BONE_NUM", mesh_.getNumBones());
-  return manager->publish("ayumi.vert", vs_src);
-}
+namespace {
 
-engine::ShaderFile* Ayumi::loadShadowVertexShader(
-    engine::ShaderManager* manager) {
-  gl::ShaderSource shadow_vs_src("ayumi_shadow.vert");
-  shadow_vs_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
-  shadow_vs_src.insertMacroValue("BONE_NUM", mesh_.getNumBones());
-  return manager->publish("ayumi_shadow.vert", shadow_vs_src);
-}
+const std::string kModelDir = "src/resources/models/ayumi/";
+const unsigned kMeshFlags =
+    aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs;
 
-Ayumi::Ayumi(engine::GameObject* parent)
-    : engine::Behaviour(parent)
-    , mesh_("src/resources/models/ayumi/ayumi.dae",
-            aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs)
-    , anim_(mesh_.getAnimData())
-    , prog_(loadVertexShader(scene_->shader_manager()),
-            scene_->shader_manager()->get("ayumi.frag"))
-    , shadow_prog_(loadShadowVertexShader(scene_->shader_manager()),
-                   scene_->shader_manager()->get("shadow.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uCameraMatrix_(prog_, "uCameraMatrix")
-    , uModelMatrix_(prog_, "uModelMatrix")
-    , uBones_(prog_, "uBones")
-    , shadow_uMCP_(shadow_prog_, "uMCP")
-    , shadow_uBones_(shadow_prog_, "uBones")
-    , attack2_(false)
-    , attack3_(false)
-    , was_left_click_(false)
-    , charmove_(nullptr)
-    , bsphere_(mesh_.bSphere()) {
-  gl::Use(prog_);
-
-  mesh_.setupPositions(prog_ | "aPosition");
-  mesh_.setupTexCoords(prog_ | "aTexCoord");
-  mesh_.setupNormals(prog_ | "aNormal");
-  gl::LazyVertexAttrib boneIDs(prog_, "aBoneIDs", false);
-  gl::LazyVertexAttrib weights(prog_, "aWeights", false);
-  mesh_.setupBones(boneIDs, weights, false);
-
-  mesh_.setupDiffuseTextures(1);
-  mesh_.setupSpecularTextures(2);
-  gl::UniformSampler(prog_, "uDiffuseTexture").set(1);
-  gl::UniformSampler(prog_, "uSpecularTexture").set(2);
-
-  prog_.validate();
+struct AnimationAsset {
+  const char* file;
+  const char* name;
+  gl::Bitfield<engine::AnimFlag> flags;
+  float speed;
+};
 
+// The animations, in the order of their imports (the mesh is the first).
+std::vector<AnimationAsset> Animations() {
   using engine::AnimFlag;
+  return {
+    {"ayumi_idle.dae", "Stand", {AnimFlag::Repeat, AnimFlag::Interruptable},
+     1.0f},
+    {"ayumi_walk.dae", "Walk", {AnimFlag::Repeat, AnimFlag::Interruptable},
+     1.0f},
+    {"ayumi_walk.dae", "MoonWalk", {AnimFlag::Repeat, AnimFlag::Mirrored,
+                                    AnimFlag::Interruptable}, 1.0f},
+    {"ayumi_run.dae", "Run", {AnimFlag::Repeat, AnimFlag::Interruptable},
+     1.0f},
+    {"ayumi_jump_rise.dae", "JumpRise",
+     {AnimFlag::MirroredRepeat, AnimFlag::Interruptable}, 0.5f},
+    {"ayumi_jump_fall.dae", "JumpFall",
+     {AnimFlag::MirroredRepeat, AnimFlag::Interruptable}, 0.5f},
+    {"ayumi_flip.dae", "Flip", AnimFlag::None, 1.5f},
+    {"ayumi_attack.dae", "Attack", AnimFlag::None, 2.5f},
+    {"ayumi_attack2.dae", "Attack2", AnimFlag::None, 1.4f},
+    {"ayumi_attack3.dae", "Attack3", AnimFlag::None, 3.0f},
+    {"ayumi_attack_chain0.dae", "Attack_Chain0", AnimFlag::None, 0.9f}
+  };
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_idle.dae", "Stand",
-                     {AnimFlag::Repeat, AnimFlag::Interruptable});
-
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_walk.dae", "Walk",
-                     {AnimFlag::Repeat, AnimFlag::Interruptable});
-
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_walk.dae", "MoonWalk",
-                     {AnimFlag::Repeat, AnimFlag::Mirrored,
-                     AnimFlag::Interruptable});
-
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_run.dae", "Run",
-                     {AnimFlag::Repeat, AnimFlag::Interruptable});
+// Every Ayumi has the same bones, so they can share the shaders
+engine::ShaderFile* BonesShader(engine::ShaderManager* manager,
+                                const std::string& filename,
+                                engine::AnimatedMeshRenderer* mesh) {
+  if (engine::ShaderFile* shader = manager->find(filename)) {
+    return shader;
+  }
+  gl::ShaderSource src(filename);
+  src.insertMacroValue("BONE_ATTRIB_NUM", mesh->getBoneAttribNum());
+  src.insertMacroValue("BONE_NUM", mesh->getNumBones());
+  return manager->publish(filename, src);
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_jump_rise.dae", "JumpRise",
-                     {AnimFlag::MirroredRepeat, AnimFlag::Interruptable}, 0.5f);
+}  // namespace
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_jump_fall.dae", "JumpFall",
-                     {AnimFlag::MirroredRepeat, AnimFlag::Interruptable}, 0.5f);
+std::unique_ptr<engine::ImportGraph> Ayumi::ImportAssets() {
+  auto assets = engine::make_unique<engine::ImportGraph>();
+  assets->addMesh(kModelDir + "ayumi.dae", kMeshFlags);
+  for (const AnimationAsset& animation : Animations()) {
+    assets->addAnimation(kModelDir + animation.file);
+  }
+  return assets;
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_flip.dae", "Flip",
-                     AnimFlag::None, 1.5f);
+std::shared_ptr<engine::ShaderProgram> Ayumi::LoadProgram(
+    engine::ShaderManager* manager, engine::AnimatedMeshRenderer* mesh) {
+  return engine::GameEngine::asset_cache()->get<engine::ShaderProgram>(
+      "ayumi.vert|ayumi.frag", [manager, mesh]() {
+    auto prog = engine::make_unique<engine::ShaderProgram>(
+        BonesShader(manager, "ayumi.vert", mesh), manager->get("ayumi.frag"));
+    gl::Use(*prog);
+    gl::UniformSampler(*prog, "uDiffuseTexture").set(1);
+    gl::UniformSampler(*prog, "uSpecularTexture").set(2);
+    prog->validate();
+    return prog;
+  });
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_attack.dae", "Attack",
-                     AnimFlag::None, 2.5f);
+std::shared_ptr<engine::ShaderProgram> Ayumi::LoadShadowProgram(
+    engine::ShaderManager* manager, engine::AnimatedMeshRenderer* mesh) {
+  return engine::GameEngine::asset_cache()->get<engine::ShaderProgram>(
+      "ayumi_shadow.vert|shadow.frag", [manager, mesh]() {
+    return engine::make_unique<engine::ShaderProgram>(
+        BonesShader(manager, "ayumi_shadow.vert", mesh),
+        manager->get("shadow.frag"));
+  });
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_attack2.dae", "Attack2",
-                     AnimFlag::None, 1.4f);
+std::shared_ptr<engine::AnimatedMeshRenderer> Ayumi::LoadMesh(
+    engine::ShaderManager* manager, engine::ImportGraph* assets) {
+  return engine::GameEngine::asset_cache()->get<engine::AnimatedMeshRenderer>(
+      engine::ModelKey(kModelDir + "ayumi.dae", kMeshFlags),
+      [manager, assets]() {
+    // The mesh and the animations are imported in parallel, while the mesh's
+    // GL resources are set up.
+    std::unique_ptr<engine::ImportGraph> own_assets;
+    engine::ImportGraph* imports = assets;
+    if (!imports) {
+      own_assets = ImportAssets();
+      imports = own_assets.get();
+    }
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_attack3.dae", "Attack3",
-                     AnimFlag::None, 3.0f);
+    auto mesh = engine::make_unique<engine::AnimatedMeshRenderer>(
+        imports->get(0));
+    std::shared_ptr<engine::ShaderProgram> prog =
+        LoadProgram(manager, mesh.get());
+    gl::Use(*prog);
+
+    mesh->setupPositions(*prog | "aPosition");
+    mesh->setupTexCoords(*prog | "aTexCoord");
+    mesh->setupNormals(*prog | "aNormal");
+    gl::LazyVertexAttrib boneIDs(*prog, "aBoneIDs", false);
+    gl::LazyVertexAttrib weights(*prog, "aWeights", false);
+    mesh->setupBones(boneIDs, weights, false);
+
+    mesh->setupDiffuseTextures(1);
+    mesh->setupSpecularTextures(2);
+
+    // The imports of the animations are done by now, or they are imported here
+    std::vector<AnimationAsset> animations = Animations();
+    for (size_t i = 0; i < animations.size(); ++i) {
+      const AnimationAsset& animation = animations[i];
+      mesh->addAnimation(imports->getAnimation(i + 1), animation.name,
+                         animation.flags, animation.speed);
+    }
+    return mesh;
+  });
+}
 
-  mesh_.addAnimation("src/resources/models/ayumi/ayumi_attack_chain0.dae", "Attack_Chain0",
-                     AnimFlag::None, 0.9f);
+Ayumi::Ayumi(engine::GameObject* parent)
+    : Ayumi(parent, nullptr) {}
 
+Ayumi::Ayumi(engine::GameObject* parent, engine::ImportGraph* assets)
+    : engine::Behaviour(parent)
+    , mesh_(LoadMesh(scene_->shader_manager(), assets))
+    , anim_(mesh_->getAnimData())
+    , prog_(LoadProgram(scene_->shader_manager(), mesh_.get()))
+    , shadow_prog_(LoadShadowProgram(scene_->shader_manager(), mesh_.get()))
+    , uProjectionMatrix_(*prog_, "uProjectionMatrix")
+    , uCameraMatrix_(*prog_, "uCameraMatrix")
+    , uModelMatrix_(*prog_, "uModelMatrix")
+    , uBones_(*prog_, "uBones")
+    , shadow_uMCP_(*shadow_prog_, "uMCP")
+    , shadow_uBones_(*shadow_prog_, "uBones")
+    , attack2_(false)
+    , attack3_(false)
+    , was_left_click_(false)
+    , charmove_(nullptr)
+    , bsphere_(mesh_->bSphere()) {
   anim_.setDefaultAnimation("Stand", 0.3f);
   anim_.forceAnimToDefault(0);
 
@@ -105,7 +167,7 @@ Ayumi::Ayumi(engine::GameObject* parent)
 }
 
 engine::AnimatedMeshRenderer& Ayumi::getMesh() {
-  return mesh_;
+  return *mesh_;
 }
 
 engine::Animation& Ayumi::getAnimation() {
@@ -115,7 +177,7 @@ engine::Animation& Ayumi::getAnimation() {
 void Ayumi::update() {
   float time = scene_->game_time().current;
 
-  std::string curr_anim = anim_.getCurrentAnimation();
+  const std::string& curr_anim = anim_.getCurrentAnimation();
 
   using engine::AnimParams;
 
@@ -146,7 +208,7 @@ void Ayumi::update() {
     }
   } else {
     if (charmove_->isWalking()) {
-      if (glfwGetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE) {
+      if (!engine::Input::key_pressed(GLFW_KEY_LEFT_SHIFT)) {
         anim_.setCurrentAnimation(AnimParams("Run", 0.3f), time);
       } else {
         anim_.setCurrentAnimation(AnimParams("Walk", 0.3f), time);
@@ -156,43 +218,44 @@ void Ayumi::update() {
     }
   }
 
-  mesh_.updateBoneInfo(anim_, time);
+  mesh_->updateBoneInfo(anim_, time);
+  mesh_->copyBoneInfo(&bones_);
 }
 
 void Ayumi::shadowRender() {
-  gl::Use(shadow_prog_);
+  gl::Use(*shadow_prog_);
   shadow_uMCP_ =
     scene_->shadow()->modelCamProjMat(bsphere_, transform()->matrix(),
-                                     mesh_.worldTransform());
-  mesh_.uploadBoneInfo(shadow_uBones_);
+                                     mesh_->worldTransform());
+  engine::AnimatedMeshRenderer::UploadBoneInfo(bones_, shadow_uBones_);
 
   gl::CullFace(gl::kFront);
   gl::FrontFace(gl::kCcw);
   gl::TemporaryEnable cullface{gl::kCullFace};
-  mesh_.disableTextures();
+  mesh_->disableTextures();
 
-  mesh_.render();
+  mesh_->render();
 
-  mesh_.enableTextures();
+  mesh_->enableTextures();
   gl::CullFace(gl::kBack);
 
   scene_->shadow()->push();
 }
 
 void Ayumi::render() {
-  gl::Use(prog_);
-  prog_.update();
+  gl::Use(*prog_);
+  prog_->update();
   const auto& cam = *scene_->camera();
   uCameraMatrix_ = cam.cameraMatrix();
   uProjectionMatrix_ = cam.projectionMatrix();
-  uModelMatrix_ = transform()->matrix() * mesh_.worldTransform();
+  uModelMatrix_ = transform()->matrix() * mesh_->worldTransform();
 
-  mesh_.uploadBoneInfo(uBones_);
+  engine::AnimatedMeshRenderer::UploadBoneInfo(bones_, uBones_);
 
   gl::FrontFace(gl::kCcw);
   gl::TemporaryEnable cullface{gl::kCullFace};
 
-  mesh_.render();
+  mesh_->render();
 }
 
 bool Ayumi::canJump() {
@@ -205,14 +268,14 @@ bool Ayumi::canFlip() {
 
 AnimParams Ayumi::animationEndedCallback(const std::string& current_anim) {
   if (current_anim == "Attack") {
-    if (attack2_ || glfwGetMouseButton(scene_->window(), GLFW_MOUSE_BUTTON_LEFT)
-          == GLFW_PRESS) {
+    if (attack2_ ||
+        engine::Input::mouse_button_pressed(GLFW_MOUSE_BUTTON_LEFT)) {
       return AnimParams("Attack2", 0.1f);
     }
   } else if (current_anim == "Attack2") {
     attack2_ = false;
-    if (attack3_ || glfwGetMouseButton(scene_->window(), GLFW_MOUSE_BUTTON_LEFT)
-          == GLFW_PRESS) {
+    if (attack3_ ||
+        engine::Input::mouse_button_pressed(GLFW_MOUSE_BUTTON_LEFT)) {
       return AnimParams("Attack3", 0.05f);
     }
   } else if (current_anim == "Attack3") {
@@ -240,7 +303,7 @@ AnimParams Ayumi::animationEndedCallback(const std::string& current_anim) {
     } else {
       params.transition_time = 0.3f;
     }
-    if (glfwGetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE) {
+    if (!engine::Input::key_pressed(GLFW_KEY_LEFT_SHIFT)) {
       params.name = "Run";
       return params;
     } else {
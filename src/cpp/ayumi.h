@@ -3,7 +3,11 @@
 #ifndef LOD_INCLUDE_AYUMI_H_
 #define LOD_INCLUDE_AYUMI_H_
 
+#include <memory>
+#include <vector>
+
 #include "engine/behaviour.h"
+#include "engine/import_graph.h"
 #include "engine/shader_manager.h"
 #include "engine/mesh/animated_mesh_renderer.h"
 
@@ -14,11 +18,17 @@
 class Ayumi : public engine::Behaviour {
  public:
   explicit Ayumi(GameObject* parent);
+  // Uses assets that ImportAssets() has started (i.e. on a loading thread),
+  // if the mesh isn't in the AssetCache yet. More Ayumis can share them.
+  Ayumi(GameObject* parent, engine::ImportGraph* assets);
   virtual ~Ayumi() {}
 
   engine::AnimatedMeshRenderer& getMesh();
   engine::Animation& getAnimation();
 
+  // Starts importing the mesh and the animations on the thread pool.
+  static std::unique_ptr<engine::ImportGraph> ImportAssets();
+
   void charmove(CharacterMovement* charmove) {
     if (!charmove) return;
     charmove_ = charmove;
@@ -27,9 +37,12 @@ class Ayumi : public engine::Behaviour {
   }
 
  private:
-  engine::AnimatedMeshRenderer mesh_;
+  // Every Ayumi shares the mesh and the programs (see AssetCache), so the
+  // pose of this one is kept in bones_.
+  std::shared_ptr<engine::AnimatedMeshRenderer> mesh_;
   engine::Animation anim_;
-  engine::ShaderProgram prog_, shadow_prog_;
+  std::shared_ptr<engine::ShaderProgram> prog_, shadow_prog_;
+  std::vector<glm::mat4> bones_;
 
   gl::LazyUniform<glm::mat4> uProjectionMatrix_, uCameraMatrix_,
                              uModelMatrix_, uBones_,
@@ -44,8 +57,15 @@ class Ayumi : public engine::Behaviour {
   CharacterMovement::CanDoCallback canFlip;
   engine::Animation::AnimationEndedCallback animationEndedCallback;
 
-  engine::ShaderFile* loadVertexShader(engine::ShaderManager* manager);
-  engine::ShaderFile* loadShadowVertexShader(engine::ShaderManager* manager);
+  // The mesh, with its animations, set up for the programs. It's imported
+  // here if assets is nullptr.
+  static std::shared_ptr<engine::AnimatedMeshRenderer> LoadMesh(
+      engine::ShaderManager* manager, engine::ImportGraph* assets);
+  // The shaders depend on the number of the mesh's bones.
+  static std::shared_ptr<engine::ShaderProgram> LoadProgram(
+      engine::ShaderManager* manager, engine::AnimatedMeshRenderer* mesh);
+  static std::shared_ptr<engine::ShaderProgram> LoadShadowProgram(
+      engine::ShaderManager* manager, engine::AnimatedMeshRenderer* mesh);
 
   virtual void update() override;
   virtual void shadowRender() override;
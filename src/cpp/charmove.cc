@@ -3,6 +3,7 @@
 #include "./charmove.h"
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include "engine/input.h"
 #include "engine/game_engine.h"
 
 CharacterMovement::CharacterMovement(engine::GameObject *parent,
@@ -21,6 +22,8 @@ CharacterMovement::CharacterMovement(engine::GameObject *parent,
   , flip_(false)
   , can_flip_(true)
   , transition_(false)
+  , prev_time_(0)
+  , prev_height_time_(0)
   , anim_(nullptr)
   , camera_(nullptr)
   , can_jump_functor_(nullptr)
@@ -50,15 +53,14 @@ void CharacterMovement::update() {
   const engine::Camera& cam = *camera_;
   glm::vec2 character_offset = anim_->offsetSinceLastFrame();
 
-  static float prevTime = 0;
-  float dt =  time - prevTime;
-  prevTime = time;
+  float dt =  time - prev_time_;
+  prev_time_ = time;
 
   glm::ivec2 moveDir;  // up and right is positive
-  bool w = glfwGetKey(scene_->window(), GLFW_KEY_W) == GLFW_PRESS;
-  bool a = glfwGetKey(scene_->window(), GLFW_KEY_A) == GLFW_PRESS;
-  bool s = glfwGetKey(scene_->window(), GLFW_KEY_S) == GLFW_PRESS;
-  bool d = glfwGetKey(scene_->window(), GLFW_KEY_D) == GLFW_PRESS;
+  bool w = engine::Input::key_pressed(GLFW_KEY_W);
+  bool a = engine::Input::key_pressed(GLFW_KEY_A);
+  bool s = engine::Input::key_pressed(GLFW_KEY_S);
+  bool d = engine::Input::key_pressed(GLFW_KEY_D);
 
   if (w && !s) {
     moveDir.y = 1;
@@ -72,12 +74,11 @@ void CharacterMovement::update() {
     moveDir.x = -1;
   }
 
-  static glm::ivec2 lastMoveDir;
   bool lastWalking = walking_;
   walking_ = moveDir.x || moveDir.y;
   transition_ = transition_ || (walking_ != lastWalking) ||
-                               (lastMoveDir != moveDir);
-  lastMoveDir = moveDir;
+                               (last_move_dir_ != moveDir);
+  last_move_dir_ = moveDir;
 
   if (walking_) {
     glm::vec3 fwd = cam.transform()->forward();
@@ -135,9 +136,8 @@ void CharacterMovement::keyAction(int key, int scancode, int action, int mods) {
 void CharacterMovement::updateHeight(float time) {
   glm::vec3 local_pos = transform_.local_pos();
 
-  static float prevTime = 0;
-  float diff_time = time - prevTime;
-  prevTime = time;
+  float diff_time = time - prev_height_time_;
+  prev_height_time_ = time;
 
   while (diff_time > 0) {
     float time_step = 0.01f;
@@ -48,6 +48,9 @@ class CharacterMovement : public engine::Behaviour {
 
   bool walking_, jumping_, flip_, can_flip_, transition_;
 
+  float prev_time_, prev_height_time_;
+  glm::ivec2 last_move_dir_;
+
   engine::Animation *anim_;
   engine::Camera *camera_;
 
@@ -0,0 +1,41 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <vector>
+#include "./asset_cache.h"
+
+namespace engine {
+
+void AssetCache::collect() {
+  // The assets are freed after the unlock, as their destructors might use
+  // the cache. Freeing an asset can leave the assets that it has held unused,
+  // so it is repeated until nothing is freed.
+  std::vector<std::shared_ptr<void>> unused;
+  do {
+    unused.clear();
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+      if (iter->second.retention == Retention::kScene &&
+          iter->second.asset.use_count() == 1) {
+        unused.push_back(std::move(iter->second.asset));
+        iter = entries_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  } while (!unused.empty());
+}
+
+void AssetCache::clear() {
+  std::map<Key, Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    entries.swap(entries_);
+  }
+}
+
+size_t AssetCache::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return entries_.size();
+}
+
+}  // namespace engine
@@ -0,0 +1,93 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ASSET_CACHE_H_
+#define ENGINE_ASSET_CACHE_H_
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <utility>
+#include <typeindex>
+
+namespace engine {
+
+// Shares the resources (meshes, textures, height maps, fonts, programs...)
+// that are loaded with the same parameters between the objects and the
+// scenes. An asset is identified by its type, and a key that has to contain
+// everything that the loading depends on (i.e. the path and the flags).
+// The handles are shared_ptrs: an asset lives while anything uses it, and
+// after that as long as its retention says.
+// It is thread safe, but the assets that need the context have to be loaded
+// on the main thread.
+class AssetCache {
+ public:
+  enum class Retention {
+    // Freed at the first scene switch that finds it unused. The new scene is
+    // built while the old one is alive, so what both use isn't loaded again.
+    kScene,
+    // Kept until the engine shuts down.
+    kForever
+  };
+
+  AssetCache() = default;
+
+  // Returns the asset, or calls load (that returns a unique_ptr or a
+  // shared_ptr to it) if it isn't in the cache. The cache isn't locked while
+  // loading, so a loader can use the cache too. If two threads load the same
+  // asset at once, the one that finishes first is shared.
+  template <typename T, typename Loader>
+  std::shared_ptr<T> get(const std::string& key, Loader load,
+                         Retention retention = Retention::kScene) {
+    Key full_key{std::type_index{typeid(T)}, key};
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      auto iter = entries_.find(full_key);
+      if (iter != entries_.end()) {
+        if (retention == Retention::kForever) {
+          iter->second.retention = retention;
+        }
+        return std::static_pointer_cast<T>(iter->second.asset);
+      }
+    }
+
+    std::shared_ptr<T> asset{load()};
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto inserted = entries_.emplace(full_key, Entry{asset, retention});
+    return std::static_pointer_cast<T>(inserted.first->second.asset);
+  }
+
+  // Returns nullptr if the asset isn't in the cache.
+  template <typename T>
+  std::shared_ptr<T> find(const std::string& key) const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto iter = entries_.find(Key{std::type_index{typeid(T)}, key});
+    if (iter == entries_.end()) { return nullptr; }
+    return std::static_pointer_cast<T>(iter->second.asset);
+  }
+
+  // Frees the kScene assets that nothing else uses.
+  void collect();
+
+  // Drops every asset. The handles that are still alive keep theirs.
+  void clear();
+
+  size_t size() const;
+
+ private:
+  using Key = std::pair<std::type_index, std::string>;
+  struct Entry {
+    std::shared_ptr<void> asset;
+    Retention retention;
+  };
+
+  std::map<Key, Entry> entries_;
+  mutable std::mutex mutex_;
+
+  AssetCache(const AssetCache&) = delete;
+  AssetCache& operator=(const AssetCache&) = delete;
+};
+
+}  // namespace engine
+
+#endif
@@ -1,6 +1,7 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include "./behaviour.h"
+#include "./debug/profiler.h"
 
 #define _TRY(YourCode) \
   try { \
@@ -15,6 +16,7 @@ void Behaviour::updateAll() {
   internalUpdate();
   for (auto& component : sorted_components_) {
     if (component == this) {
+      ENGINE_PROFILE_OBJECT();
       _TRY(update());
     } else {
       component->updateAll();
@@ -72,14 +74,4 @@ void Behaviour::mouseMovedAll(double xpos, double ypos) {
   }
 }
 
-void Behaviour::collisionAll(const GameObject* other) {
-  for (auto& component : sorted_components_) {
-    if (component == this) {
-      _TRY(collision(other));
-    } else {
-      component->collisionAll(other);
-    }
-  }
-}
-
 }  // namespace engine
@@ -3,7 +3,9 @@
 #ifndef ENGINE_BEHAVIOUR_H_
 #define ENGINE_BEHAVIOUR_H_
 
+#include <vector>
 #include "./game_object.h"
+#include "./physics/contact_event.h"
 
 namespace engine {
 
@@ -30,9 +32,9 @@ class Behaviour : public GameObject {
   virtual void mouseButtonPressedAll(int button, int action, int mods) override;
   virtual void mouseMovedAll(double xpos, double ypos) override;
 
-  // experimental
-  virtual void collision(const GameObject* other) {}
-  virtual void collisionAll(const GameObject* other) override;
+  // Called once per frame with the batch of contact events of the rigid
+  // bodies this behaviour subscribed for (see physics::ContactEventQueue).
+  virtual void contacts(const std::vector<physics::ContactEvent>& events) {}
 };
 
 }  // namespace engine
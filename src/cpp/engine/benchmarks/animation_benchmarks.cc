@@ -0,0 +1,72 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <string>
+
+#include "./benchmark.h"
+#include "../mesh/animated_mesh_renderer.h"
+
+namespace {
+
+using engine::AnimFlag;
+using engine::AnimParams;
+using engine::Animation;
+using engine::AnimatedMeshRenderer;
+using engine::benchmarks::DoNotOptimize;
+
+const std::string kModelDir = "src/resources/models/ayumi/";
+
+// Ayumi's mesh, with two of her animations, loaded like Ayumi does it (but
+// without the GL objects).
+AnimatedMeshRenderer& TestMesh() {
+  static AnimatedMeshRenderer* mesh = [] {
+    auto mesh = new AnimatedMeshRenderer{kModelDir + "ayumi.dae",
+        aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs};
+    mesh->addAnimation(kModelDir + "ayumi_idle.dae", "Stand",
+                       {AnimFlag::Repeat, AnimFlag::Interruptable});
+    mesh->addAnimation(kModelDir + "ayumi_walk.dae", "Walk",
+                       {AnimFlag::Repeat, AnimFlag::Interruptable});
+    return mesh;
+  }();
+  return *mesh;
+}
+
+ENGINE_BENCHMARK("animation/update_bone_info") {
+  AnimatedMeshRenderer& mesh = TestMesh();
+  static Animation anim{mesh.getAnimData()};
+  static bool initialized = false;
+  if (!initialized) {
+    anim.setDefaultAnimation("Stand", 0.3f);
+    anim.forceAnimToDefault(0);
+    initialized = true;
+  }
+
+  // 60 fps, well after the transition into the default animation
+  static float time = 1.0f;
+  for (size_t i = 0; i < iterations; ++i) {
+    time += 1.0f / 60.0f;
+    mesh.updateBoneInfo(anim, time);
+  }
+  DoNotOptimize(time);
+}
+
+ENGINE_BENCHMARK("animation/update_bone_info_in_transition") {
+  AnimatedMeshRenderer& mesh = TestMesh();
+  static Animation anim{mesh.getAnimData()};
+  static bool initialized = false;
+  if (!initialized) {
+    anim.setDefaultAnimation("Stand", 0.3f);
+    anim.forceAnimToDefault(0);
+    anim.forceCurrentAnimation(AnimParams("Walk", 1e9f), 0);
+    initialized = true;
+  }
+
+  // The transition never ends, so both animations are sampled every time
+  static float time = 1.0f;
+  for (size_t i = 0; i < iterations; ++i) {
+    time += 1.0f / 60.0f;
+    mesh.updateBoneInfo(anim, time);
+  }
+  DoNotOptimize(time);
+}
+
+}  // namespace
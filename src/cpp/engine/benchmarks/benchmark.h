@@ -0,0 +1,87 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BENCHMARKS_BENCHMARK_H_
+#define ENGINE_BENCHMARKS_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+
+namespace engine {
+namespace benchmarks {
+
+// Keeps the compiler from optimizing away a computed value.
+template<typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+// A benchmark body runs the measured operation 'iterations' times.
+using BenchmarkFunction = std::function<void(size_t iterations)>;
+
+struct Benchmark {
+  std::string name;
+  BenchmarkFunction function;
+};
+
+inline std::vector<Benchmark>& Registry() {
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+struct Registrar {
+  Registrar(const std::string& name, BenchmarkFunction function) {
+    Registry().push_back(Benchmark{name, function});
+  }
+};
+
+// Runs a benchmark with a doubling iteration count, until one run takes at
+// least min_seconds, and writes the result as a line of JSON to stdout.
+inline void Run(const Benchmark& benchmark, double min_seconds) {
+  using Clock = std::chrono::steady_clock;
+
+  benchmark.function(1);  // warm up (and let the lazy setups run)
+
+  size_t iterations = 1;
+  double seconds = 0;
+  while (true) {
+    Clock::time_point start = Clock::now();
+    benchmark.function(iterations);
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds >= min_seconds || iterations >= (size_t(1) << 40)) { break; }
+
+    // Aim for 1.5 times the minimum time, but don't grow too fast
+    size_t estimate = seconds > 0 ?
+        iterations * (1.5 * min_seconds / seconds) : iterations * 10;
+    iterations = std::max(iterations + 1, std::min(estimate, iterations * 10));
+  }
+
+  std::printf("{\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.2f}\n",
+              benchmark.name.c_str(), iterations, seconds * 1e9 / iterations);
+  std::fflush(stdout);
+}
+
+}  // namespace benchmarks
+}  // namespace engine
+
+#define ENGINE_BENCHMARK_CONCAT2(a, b) a##b
+#define ENGINE_BENCHMARK_CONCAT(a, b) ENGINE_BENCHMARK_CONCAT2(a, b)
+
+// Registers a benchmark, the body gets 'size_t iterations' as its parameter.
+#define ENGINE_BENCHMARK(name) \
+  static void ENGINE_BENCHMARK_CONCAT(Benchmark_, __LINE__)(size_t); \
+  static ::engine::benchmarks::Registrar \
+      ENGINE_BENCHMARK_CONCAT(benchmark_registrar_, __LINE__){ \
+          name, ENGINE_BENCHMARK_CONCAT(Benchmark_, __LINE__)}; \
+  static void ENGINE_BENCHMARK_CONCAT(Benchmark_, __LINE__)(size_t iterations)
+
+#endif
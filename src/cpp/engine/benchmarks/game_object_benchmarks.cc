@@ -0,0 +1,101 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <vector>
+
+#include "./benchmark.h"
+#include "../behaviour.h"
+
+namespace {
+
+using engine::Behaviour;
+using engine::GameObject;
+using engine::benchmarks::DoNotOptimize;
+
+// A behaviour that does barely anything, so that the traversal is measured.
+class Counter : public Behaviour {
+ public:
+  explicit Counter(GameObject* parent) : Behaviour(parent) {}
+
+  static size_t updates, renders;
+
+ private:
+  virtual void update() override { ++updates; }
+  virtual void render() override { ++renders; }
+};
+
+size_t Counter::updates = 0;
+size_t Counter::renders = 0;
+
+// Adds 'fan_out' children to the object, and recursively to them, 'depth'
+// levels deep.
+void AddChildren(GameObject* object, int depth, int fan_out,
+                 std::vector<const GameObject*>* leaves) {
+  if (depth == 0) {
+    leaves->push_back(object);
+    return;
+  }
+  for (int i = 0; i < fan_out; ++i) {
+    AddChildren(object->addComponent<Counter>(), depth - 1, fan_out, leaves);
+  }
+}
+
+// A scene graph of 4 + 16 + 64 + 256 + 1024 objects, with no scene and no
+// window behind it.
+struct TestTree {
+  Behaviour root{nullptr};
+  std::vector<const GameObject*> leaves;
+
+  TestTree() {
+    AddChildren(&root, 5, 4, &leaves);
+    root.updateAll();  // sorts the components that were just added
+  }
+};
+
+TestTree& GetTestTree() {
+  static TestTree tree;
+  return tree;
+}
+
+ENGINE_BENCHMARK("game_object/update_all_1364") {
+  Behaviour& root = GetTestTree().root;
+  for (size_t i = 0; i < iterations; ++i) {
+    root.updateAll();
+  }
+  DoNotOptimize(Counter::updates);
+}
+
+ENGINE_BENCHMARK("game_object/render_all_1364") {
+  Behaviour& root = GetTestTree().root;
+  for (size_t i = 0; i < iterations; ++i) {
+    root.renderAll();
+  }
+  DoNotOptimize(Counter::renders);
+}
+
+ENGINE_BENCHMARK("game_object/world_pos_of_leaves_1024") {
+  const std::vector<const GameObject*>& leaves = GetTestTree().leaves;
+  for (size_t i = 0; i < iterations; ++i) {
+    glm::vec3 sum;
+    for (const GameObject* leaf : leaves) {
+      sum += leaf->transform()->pos();
+    }
+    DoNotOptimize(sum);
+  }
+}
+
+// Spawning and destroying objects, like the actor pools and dropCubes() do.
+ENGINE_BENCHMARK("game_object/add_remove_1024") {
+  static Behaviour root{nullptr};
+  std::vector<GameObject*> children(1024);
+  for (size_t i = 0; i < iterations; ++i) {
+    for (GameObject*& child : children) {
+      child = root.addComponent<Counter>();
+    }
+    root.updateAll();
+    root.removeComponents(children.begin(), children.end());
+    root.updateAll();
+  }
+  DoNotOptimize(Counter::updates);
+}
+
+}  // namespace
@@ -0,0 +1,41 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Runs the engine's microbenchmarks without a window or a GL context.
+// Usage: LoD_bench [--min_time=<seconds>] [name filter]
+// Every benchmark whose name contains the filter is run, and its result is
+// written to stdout as a line of JSON.
+
+#include <string>
+#include <cstdlib>
+#include <iostream>
+
+#include "./benchmark.h"
+
+int main(int argc, char* argv[]) {
+  using namespace engine::benchmarks;
+
+  double min_seconds = 0.5;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    const std::string min_time_flag = "--min_time=";
+    if (arg.compare(0, min_time_flag.size(), min_time_flag) == 0) {
+      min_seconds = std::atof(arg.c_str() + min_time_flag.size());
+    } else {
+      filter = arg;
+    }
+  }
+
+  int failed = 0;
+  for (const Benchmark& benchmark : Registry()) {
+    if (benchmark.name.find(filter) == std::string::npos) { continue; }
+    try {
+      Run(benchmark, min_seconds);
+    } catch (const std::exception& ex) {
+      std::cerr << benchmark.name << " failed: " << ex.what() << std::endl;
+      ++failed;
+    }
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <vector>
+#include <memory>
+
+#include "./benchmark.h"
+#include "./test_frustum.h"
+#include "../transform.h"
+#include "../collision/bounding_box.h"
+
+namespace {
+
+using engine::Transform;
+using engine::BoundingBox;
+using engine::benchmarks::DoNotOptimize;
+using engine::benchmarks::TestFrustum;
+
+// A chain of transforms, like a deep game object hierarchy.
+struct TransformChain {
+  std::vector<std::unique_ptr<Transform>> transforms;
+
+  explicit TransformChain(size_t depth) {
+    for (size_t i = 0; i < depth; ++i) {
+      Transform* parent = i ? transforms.back().get() : nullptr;
+      transforms.emplace_back(new Transform{parent});
+      transforms.back()->set_local_pos(glm::vec3(1, 2, 3));
+      transforms.back()->set_local_rot(
+          glm::quat(glm::vec3(0.1f, 0.2f * i, 0.3f)));
+      transforms.back()->set_local_scale(glm::vec3(1.01f));
+    }
+  }
+
+  Transform& leaf() { return *transforms.back(); }
+};
+
+ENGINE_BENCHMARK("transform/pos_depth_8") {
+  static TransformChain chain{8};
+  for (size_t i = 0; i < iterations; ++i) {
+    DoNotOptimize(chain.leaf().pos());
+  }
+}
+
+ENGINE_BENCHMARK("transform/rot_depth_8") {
+  static TransformChain chain{8};
+  for (size_t i = 0; i < iterations; ++i) {
+    DoNotOptimize(chain.leaf().rot());
+  }
+}
+
+ENGINE_BENCHMARK("transform/local_to_world_matrix_depth_8") {
+  static TransformChain chain{8};
+  for (size_t i = 0; i < iterations; ++i) {
+    DoNotOptimize(chain.leaf().localToWorldMatrix());
+  }
+}
+
+ENGINE_BENCHMARK("transform/set_pos_depth_8") {
+  static TransformChain chain{8};
+  for (size_t i = 0; i < iterations; ++i) {
+    chain.leaf().set_pos(glm::vec3(i % 16, 0, 0));
+    DoNotOptimize(chain.leaf().local_pos());
+  }
+}
+
+// Boxes scattered around the camera, in front of and behind it.
+std::vector<BoundingBox> MakeBoxes(size_t count) {
+  std::vector<BoundingBox> boxes;
+  boxes.reserve(count);
+  unsigned seed = 12345;
+  auto random = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 16) & 0x7fff) / float(0x7fff);
+  };
+  for (size_t i = 0; i < count; ++i) {
+    glm::vec3 center{random()*2000 - 1000, random()*100, random()*2000 - 1000};
+    glm::vec3 extent{1 + random()*10, 1 + random()*10, 1 + random()*10};
+    boxes.emplace_back(center - extent, center + extent);
+  }
+  return boxes;
+}
+
+ENGINE_BENCHMARK("bounding_box/frustum_cull_1024") {
+  static Frustum frustum = TestFrustum(glm::vec3(0), glm::vec3(0, 0, -1));
+  static std::vector<BoundingBox> boxes = MakeBoxes(1024);
+  for (size_t i = 0; i < iterations; ++i) {
+    size_t visible = 0;
+    for (const BoundingBox& box : boxes) {
+      visible += box.collidesWithFrustum(frustum);
+    }
+    DoNotOptimize(visible);
+  }
+}
+
+ENGINE_BENCHMARK("bounding_box/sphere_test_1024") {
+  static std::vector<BoundingBox> boxes = MakeBoxes(1024);
+  for (size_t i = 0; i < iterations; ++i) {
+    size_t colliding = 0;
+    for (const BoundingBox& box : boxes) {
+      colliding += box.collidesWithSphere(glm::vec3(0, 0, -100), 500);
+    }
+    DoNotOptimize(colliding);
+  }
+}
+
+}  // namespace
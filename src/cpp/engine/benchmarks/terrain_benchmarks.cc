@@ -0,0 +1,85 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cmath>
+#include <vector>
+
+#include "./benchmark.h"
+#include "./test_frustum.h"
+#include "../height_map.h"
+#include "../cdlod/quad_tree.h"
+
+namespace {
+
+using engine::HeightMap;
+using engine::cdlod::QuadTree;
+using engine::benchmarks::DoNotOptimize;
+using engine::benchmarks::TestFrustum;
+
+const int kMapSize = 2048;
+
+// Rolling hills, so that the min-max of the areas (and so the quadtree's
+// bounding boxes) vary like on a real terrain.
+std::vector<unsigned char> RollingHills() {
+  std::vector<unsigned char> heights(kMapSize * kMapSize);
+  for (int y = 0; y < kMapSize; ++y) {
+    for (int x = 0; x < kMapSize; ++x) {
+      heights[y*kMapSize + x] = 127.5 + 64 * std::sin(x * 0.01) +
+                                63 * std::cos(y * 0.013);
+    }
+  }
+  return heights;
+}
+
+const HeightMap<unsigned char>& TestHeightMap() {
+  static HeightMap<unsigned char> height_map{kMapSize, kMapSize,
+                                             RollingHills()};
+  return height_map;
+}
+
+ENGINE_BENCHMARK("height_map/height_at_int") {
+  const HeightMap<unsigned char>& height_map = TestHeightMap();
+  double sum = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    sum += height_map.heightAt(int(i * 7 % kMapSize), int(i * 13 % kMapSize));
+  }
+  DoNotOptimize(sum);
+}
+
+ENGINE_BENCHMARK("height_map/height_at_interpolated") {
+  const HeightMap<unsigned char>& height_map = TestHeightMap();
+  double sum = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    sum += height_map.heightAt(i * 7 % (kMapSize-1) + 0.25,
+                               i * 13 % (kMapSize-1) + 0.75);
+  }
+  DoNotOptimize(sum);
+}
+
+ENGINE_BENCHMARK("height_map/min_max_of_area_128") {
+  const HeightMap<unsigned char>& height_map = TestHeightMap();
+  for (size_t i = 0; i < iterations; ++i) {
+    DoNotOptimize(height_map.getMinMaxOfArea(
+        64 + i * 128 % (kMapSize-128), 64 + i * 384 % (kMapSize-128),
+        128, 128));
+  }
+}
+
+ENGINE_BENCHMARK("quad_tree/build_2048") {
+  const HeightMap<unsigned char>& height_map = TestHeightMap();
+  for (size_t i = 0; i < iterations; ++i) {
+    QuadTree tree{height_map};
+    DoNotOptimize(tree.node_dimension());
+  }
+}
+
+ENGINE_BENCHMARK("quad_tree/select_nodes_2048") {
+  static QuadTree tree{TestHeightMap()};
+  for (size_t i = 0; i < iterations; ++i) {
+    // Walk across the terrain, so the selection changes
+    glm::vec3 cam_pos(i % kMapSize, 200, i % kMapSize);
+    Frustum frustum = TestFrustum(cam_pos, cam_pos + glm::vec3(1, -0.2, 1));
+    DoNotOptimize(tree.selectNodes(cam_pos, frustum).size());
+  }
+}
+
+}  // namespace
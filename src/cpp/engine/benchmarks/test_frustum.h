@@ -0,0 +1,40 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BENCHMARKS_TEST_FRUSTUM_H_
+#define ENGINE_BENCHMARKS_TEST_FRUSTUM_H_
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../transform.h"
+#include "../collision/frustum.h"
+
+namespace engine {
+namespace benchmarks {
+
+// The frustum of a 60 degree, 16:9 camera at 'eye' looking at 'target',
+// with the same planes as the ones that Camera computes.
+inline Frustum TestFrustum(const glm::vec3& eye, const glm::vec3& target) {
+  glm::mat4 proj = glm::perspective<float>(float(M_PI) / 3, 16.0f / 9.0f,
+                                           0.5f, 3000.0f);
+  glm::mat4 m = proj * glm::lookAt(eye, target, glm::vec3(0, 1, 0));
+
+  // m[i][j] is the j-th row
+  Frustum frustum;
+  for (int i = 0; i < 2; ++i) {
+    frustum.planes[2*i] = Plane{m[0][3] + m[0][i], m[1][3] + m[1][i],
+                                m[2][3] + m[2][i], m[3][3] + m[3][i]};
+    frustum.planes[2*i + 1] = Plane{m[0][3] - m[0][i], m[1][3] - m[1][i],
+                                    m[2][3] - m[2][i], m[3][3] - m[3][i]};
+  }
+  frustum.planes[4] = Plane{m[0][2], m[1][2], m[2][2], m[3][2]};
+  frustum.planes[5] = Plane{m[0][3] - m[0][2], m[1][3] - m[1][2],
+                            m[2][3] - m[2][2], m[3][3] - m[3][2]};
+  return frustum;
+}
+
+}  // namespace benchmarks
+}  // namespace engine
+
+#endif
@@ -0,0 +1,132 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BINARY_STREAM_H_
+#define ENGINE_BINARY_STREAM_H_
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace engine {
+
+// Writes the file through a temporary one (path + ".tmp"), that is renamed
+// to the path when it is complete, so a crash or a reader on another thread
+// never sees a half written file. write(std::ofstream&) writes the content.
+// Returns false if the file can't be written.
+template <typename Write>
+bool WriteFileAtomically(const std::string& path, Write write) {
+  std::string temp_path = path + ".tmp";
+  std::ofstream file{temp_path, std::ios::binary};
+  write(file);
+  file.close();
+  if (!file) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    // Windows doesn't replace an existing file
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Builds the engine's binary files (the cooked assets) item by item. Every
+// item is padded to 4 bytes, so if the file is loaded 4 bytes aligned (i.e.
+// it is mapped), its arrays can be used in place.
+class BinaryWriter {
+ public:
+  static size_t Padded(size_t size) { return (size + 3) & ~size_t(3); }
+
+  void data(const void* data, size_t size) {
+    if (size) { buffer_.append(static_cast<const char*>(data), size); }
+    buffer_.append(Padded(size) - size, '\0');
+  }
+
+  template <typename T>
+  void value(const T& value) { data(&value, sizeof(T)); }
+
+  template <typename T>
+  void array(const T* values, size_t count) {
+    data(values, count * sizeof(T));
+  }
+
+  void string(const char* str, size_t length) {
+    value(std::uint32_t(length));
+    data(str, length);
+  }
+
+  void string(const std::string& str) { string(str.data(), str.size()); }
+
+  const std::string& buffer() const { return buffer_; }
+
+  // Returns false if the file can't be written (see WriteFileAtomically).
+  bool save(const std::string& path) const {
+    return WriteFileAtomically(path, [this](std::ofstream& file) {
+      file.write(buffer_.data(), buffer_.size());
+    });
+  }
+
+ private:
+  std::string buffer_;
+};
+
+// Reads the items of a BinaryWriter. Throws std::runtime_error if the data
+// ends early.
+class BinaryReader {
+ public:
+  BinaryReader(unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T value() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  // An array that is used in place.
+  template <typename T>
+  T* array(size_t count) {
+    return reinterpret_cast<T*>(take(count * sizeof(T)));
+  }
+
+  // The number of the elements of an array, that can't be more than the
+  // bytes left, so a corrupt file can't make huge allocations.
+  std::uint32_t count() {
+    auto count = value<std::uint32_t>();
+    if (count > size_ - offset_) {
+      throw std::runtime_error("invalid element count");
+    }
+    return count;
+  }
+
+  std::string string() {
+    std::uint32_t length = count();
+    return std::string(array<char>(length), length);
+  }
+
+  bool done() const { return offset_ == size_; }
+
+ private:
+  unsigned char* data_;
+  size_t size_, offset_ = 0;
+
+  unsigned char* take(size_t size) {
+    if (BinaryWriter::Padded(size) > size_ - offset_) {
+      throw std::runtime_error("the file is truncated");
+    }
+    unsigned char* data = data_ + offset_;
+    offset_ += BinaryWriter::Padded(size);
+    return data;
+  }
+};
+
+}  // namespace engine
+
+#endif
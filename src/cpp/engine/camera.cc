@@ -1,14 +1,13 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include "./camera.h"
+#include "./input.h"
 #include "./scene.h"
 
 namespace engine {
 
 void FreeFlyCamera::update() {
-  glm::dvec2 cursor_pos;
-  GLFWwindow* window = scene_->window();
-  glfwGetCursorPos(window, &cursor_pos.x, &cursor_pos.y);
+  glm::dvec2 cursor_pos = Input::cursor_pos();
   static glm::dvec2 prev_cursor_pos;
   glm::dvec2 diff = cursor_pos - prev_cursor_pos;
   prev_cursor_pos = cursor_pos;
@@ -44,16 +43,16 @@ void FreeFlyCamera::update() {
   // Update the position
   float ds = dt * speed_per_sec_;
   glm::vec3 local_pos = transform()->local_pos();
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+  if (Input::key_pressed(GLFW_KEY_W)) {
     local_pos += transform()->forward() * ds;
   }
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+  if (Input::key_pressed(GLFW_KEY_S)) {
     local_pos -= transform()->forward() * ds;
   }
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+  if (Input::key_pressed(GLFW_KEY_D)) {
     local_pos += transform()->right() * ds;
   }
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+  if (Input::key_pressed(GLFW_KEY_A)) {
     local_pos -= transform()->right() * ds;
   }
   transform()->set_local_pos(local_pos);
@@ -63,9 +62,7 @@ void FreeFlyCamera::update() {
 
 void ThirdPersonalCamera::update() {
   static glm::dvec2 prev_cursor_pos;
-  glm::dvec2 cursor_pos;
-  GLFWwindow* window = scene_->window();
-  glfwGetCursorPos(window, &cursor_pos.x, &cursor_pos.y);
+  glm::dvec2 cursor_pos = Input::cursor_pos();
   glm::dvec2 diff = cursor_pos - prev_cursor_pos;
   prev_cursor_pos = cursor_pos;
 
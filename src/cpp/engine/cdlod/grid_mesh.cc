@@ -6,7 +6,12 @@
 namespace engine {
 namespace cdlod {
 
-GridMesh::GridMesh(GLubyte dimension) : dimension_(dimension) { }
+GridMesh::GridMesh(GLubyte dimension)
+    : dimension_(dimension)
+    , memory_("terrain", "grid mesh",
+              debug::MemoryTracker::Category::kGpuBuffer)
+    , render_data_memory_("terrain", "grid mesh render data",
+                          debug::MemoryTracker::Category::kGpuBuffer) { }
 
 GLushort GridMesh::indexOf(int x, int y) {
   x += dimension_/2;
@@ -48,6 +53,8 @@ void GridMesh::setupPositions(gl::VertexAttrib attrib) {
 
   gl::Bind(aIndices_);
   aIndices_.data(indices);
+  memory_.resize(positions.size() * sizeof(svec2) +
+                 indices.size() * sizeof(GLushort));
   gl::Unbind(vao_);
 }
 
@@ -63,15 +70,7 @@ void GridMesh::setupRenderData(gl::VertexAttrib attrib) {
 #endif
 }
 
-void GridMesh::addToRenderList(const glm::vec4& render_data) {
-  render_data_.push_back(render_data);
-}
-
-void GridMesh::clearRenderList() {
-  render_data_.erase(render_data_.begin(), render_data_.end());
-}
-
-void GridMesh::render() {
+void GridMesh::render(const RenderList& render_list) {
 #if defined(glDrawElementsInstanced) && defined(glVertexAttribDivisor)
   if (glVertexAttribDivisor) {
     using gl::PrimType;
@@ -79,23 +78,27 @@ void GridMesh::render() {
 
     gl::Bind(vao_);
     gl::Bind(aRenderData_);
-    aRenderData_.data(render_data_);
+    aRenderData_.data(render_list.size() * sizeof(glm::vec4),
+                      render_list.data());
 
     gl::DrawElementsInstanced(PrimType::kTriangleStrip,
                               index_count_,
                               IndexType::kUnsignedShort,
-                              render_data_.size());   // instance count
+                              render_list.size());   // instance count
+
+    render_data_memory_.resize(render_list.size() * sizeof(glm::vec4));
     gl::Unbind(vao_);
   }
 #endif
 }
 
-void GridMesh::render(gl::UniformObject<glm::vec4> uRenderData) const {
+void GridMesh::render(const RenderList& render_list,
+                      gl::UniformObject<glm::vec4> uRenderData) const {
   using gl::PrimType;
   using gl::IndexType;
 
   gl::Bind(vao_);
-  for(auto& data : render_data_) {
+  for(auto& data : render_list) {
     uRenderData = data;
     gl::DrawElements(PrimType::kTriangleStrip,
                     index_count_,
@@ -7,6 +7,8 @@
 #include "../../oglwrap/buffer.h"
 #include "../../oglwrap/vertex_attrib.h"
 #include "../../oglwrap/uniform.h"
+#include "../frame_arena.h"
+#include "../debug/memory_tracker.h"
 
 namespace engine {
 
@@ -35,7 +37,7 @@ class GridMesh {
   gl::IndexBuffer aIndices_;
   gl::ArrayBuffer aPositions_, aRenderData_;
   int index_count_, dimension_;
-  std::vector<glm::vec4> render_data_; // xy: offset, z: scale, w: level
+  debug::MemoryTracker::Allocation memory_, render_data_memory_;
 
   GLushort indexOf(int x, int y);
 
@@ -44,15 +46,16 @@ class GridMesh {
   void setupPositions(gl::VertexAttrib attrib);
   void setupRenderData(gl::VertexAttrib attrib);
 
-  // xy: offset, z: scale, w: level
-  void addToRenderList(const glm::vec4& render_data);
-  void clearRenderList();
+  // The instances to render, xy: offset, z: scale, w: level. It is rebuilt
+  // every frame, so it lives in the frame arena.
+  using RenderList = FrameVector<glm::vec4>;
 
   // render with vertex attrib divisor
-  void render();
+  void render(const RenderList& render_list);
 
   // render with uniforms
-  void render(gl::UniformObject<glm::vec4> uRenderData) const;
+  void render(const RenderList& render_list,
+              gl::UniformObject<glm::vec4> uRenderData) const;
 
   int dimension() const {return dimension_;}
 };
@@ -29,35 +29,38 @@ class QuadGridMesh {
     mesh_.setupRenderData(attrib);
   }
 
+  using RenderList = GridMesh::RenderList;
+
   // Adds a subquad to the render list.
   // tl = top left, br = bottom right
   void addToRenderList(float offset_x, float offset_y, float scale, float level,
-                       bool tl, bool tr, bool bl, bool br) {
+                       bool tl, bool tr, bool bl, bool br,
+                       RenderList* render_list) const {
     glm::vec4 render_data(offset_x, offset_y, scale, level);
     float dim4 = scale * mesh_.dimension()/2; // our dimension / 4
-    if(tl) { mesh_.addToRenderList(render_data + glm::vec4(-dim4, dim4, 0, 0)); }
-    if(tr) { mesh_.addToRenderList(render_data + glm::vec4(dim4, dim4, 0, 0)); }
-    if(bl) { mesh_.addToRenderList(render_data + glm::vec4(-dim4, -dim4, 0, 0)); }
-    if(br) { mesh_.addToRenderList(render_data + glm::vec4(dim4, -dim4, 0, 0)); }
+    RenderList& list = *render_list;
+    if(tl) { list.push_back(render_data + glm::vec4(-dim4, dim4, 0, 0)); }
+    if(tr) { list.push_back(render_data + glm::vec4(dim4, dim4, 0, 0)); }
+    if(bl) { list.push_back(render_data + glm::vec4(-dim4, -dim4, 0, 0)); }
+    if(br) { list.push_back(render_data + glm::vec4(dim4, -dim4, 0, 0)); }
   }
 
   // Adds all four subquads
-  void addToRenderList(float offset_x, float offset_y, float scale, float level) {
-    addToRenderList(offset_x, offset_y, scale, level, true, true, true, true);
-  }
-
-  void clearRenderList() {
-    mesh_.clearRenderList();
+  void addToRenderList(float offset_x, float offset_y, float scale, float level,
+                       RenderList* render_list) const {
+    addToRenderList(offset_x, offset_y, scale, level, true, true, true, true,
+                    render_list);
   }
 
   // render with vertex attrib divisor
-  void render() {
-    mesh_.render();
+  void render(const RenderList& render_list) {
+    mesh_.render(render_list);
   }
 
   // render with uniforms
-  void render(gl::UniformObject<glm::vec4> uRenderData) const {
-    mesh_.render(uRenderData);
+  void render(const RenderList& render_list,
+              gl::UniformObject<glm::vec4> uRenderData) const {
+    mesh_.render(render_list, uRenderData);
   }
 };
 
@@ -69,8 +69,7 @@ void QuadTree::Node::countMinMaxOfArea(const HeightMapInterface& hmap,
 
 void QuadTree::Node::selectNodes(const glm::vec3& cam_pos,
                                  const Frustum& frustum,
-                                 QuadGridMesh& grid_mesh,
-                                 int node_dimension) {
+                                 SelectedNodes* selected_nodes) {
   float scale = 1 << level;
   float lod_range = scale * 128;
 
@@ -78,7 +77,8 @@ void QuadTree::Node::selectNodes(const glm::vec3& cam_pos,
 
   // if we can cover the whole area or if we are a leaf
   if (!bbox.collidesWithSphere(cam_pos, lod_range) || level == 0) {
-    grid_mesh.addToRenderList(x, z, scale, level);
+    selected_nodes->push_back(
+        SelectedNode{x, z, scale, level, true, true, true, true});
   } else {
     bool btl = tl->collidesWithSphere(cam_pos, lod_range);
     bool btr = tr->collidesWithSphere(cam_pos, lod_range);
@@ -87,20 +87,21 @@ void QuadTree::Node::selectNodes(const glm::vec3& cam_pos,
 
     // Ask childs to render what we can't
     if (btl) {
-      tl->selectNodes(cam_pos, frustum, grid_mesh, node_dimension);
+      tl->selectNodes(cam_pos, frustum, selected_nodes);
     }
     if (btr) {
-      tr->selectNodes(cam_pos, frustum, grid_mesh, node_dimension);
+      tr->selectNodes(cam_pos, frustum, selected_nodes);
     }
     if (bbl) {
-      bl->selectNodes(cam_pos, frustum, grid_mesh, node_dimension);
+      bl->selectNodes(cam_pos, frustum, selected_nodes);
     }
     if (bbr) {
-      br->selectNodes(cam_pos, frustum, grid_mesh, node_dimension);
+      br->selectNodes(cam_pos, frustum, selected_nodes);
     }
 
     // Render, what the childs didn't do
-    grid_mesh.addToRenderList(x, z, scale, level, !btl, !btr, !bbl, !bbr);
+    selected_nodes->push_back(
+        SelectedNode{x, z, scale, level, !btl, !btr, !bbl, !bbr});
   }
 }
 
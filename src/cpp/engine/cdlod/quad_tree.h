@@ -4,7 +4,10 @@
 #define ENGINE_CDLOD_QUAD_TREE_H_
 
 #include <memory>
+#include <vector>
 #include "./quad_grid_mesh.h"
+#include "../misc.h"
+#include "../frame_arena.h"
 #include "../camera.h"
 #include "../collision/bounding_box.h"
 #include "../height_map_interface.h"
@@ -13,7 +16,22 @@ namespace engine {
 namespace cdlod {
 
 class QuadTree {
-  QuadGridMesh mesh_;
+ public:
+  // A node that has been selected for rendering, with the subquads that it
+  // has to render (the rest are rendered by its children).
+  struct SelectedNode {
+    GLshort x, z;
+    float scale;
+    GLubyte level;
+    bool tl, tr, bl, br;
+  };
+  // It is selected every frame, so it lives in the frame arena.
+  using SelectedNodes = FrameVector<SelectedNode>;
+
+ private:
+  // It is only created at the first use of GL, so that the tree can be built
+  // and queried without a context.
+  std::unique_ptr<QuadGridMesh> mesh_;
   GLubyte node_dimension_;
 
   struct Node {
@@ -43,14 +61,31 @@ class QuadTree {
     }
 
     void selectNodes(const glm::vec3& cam_pos, const Frustum& frustum,
-                     QuadGridMesh& grid_mesh, int node_dimension);
+                     SelectedNodes* selected_nodes);
   };
 
   Node root_;
 
+  QuadGridMesh& mesh() {
+    if (!mesh_) {
+      mesh_ = make_unique<QuadGridMesh>(node_dimension_);
+    }
+    return *mesh_;
+  }
+
+  QuadGridMesh::RenderList renderList(const engine::Camera& cam) {
+    QuadGridMesh::RenderList render_list;
+    for (const SelectedNode& node :
+         selectNodes(cam.transform()->pos(), cam.frustum())) {
+      mesh().addToRenderList(node.x, node.z, node.scale, node.level,
+                             node.tl, node.tr, node.bl, node.br, &render_list);
+    }
+    return render_list;
+  }
+
  public:
   QuadTree(const HeightMapInterface& hmap, int node_dimension = 128)
-      : mesh_(node_dimension), node_dimension_(node_dimension)
+      : node_dimension_(node_dimension)
       , root_(hmap.w()/2, hmap.h()/2,
         std::max(log2(std::max(hmap.w(), hmap.h())) - log2(node_dimension), 0.0),
         node_dimension, true) {
@@ -63,29 +98,33 @@ class QuadTree {
   }
 
   void setupPositions(gl::VertexAttrib attrib) {
-    mesh_.setupPositions(attrib);
+    mesh().setupPositions(attrib);
   }
 
   // Uses vertex attrib divisor!
   void setupRenderData(gl::VertexAttrib attrib) {
-    mesh_.setupRenderData(attrib);
+    mesh().setupRenderData(attrib);
+  }
+
+  // Selects the nodes to render (it doesn't use GL). The result is only
+  // valid until the end of the frame.
+  SelectedNodes selectNodes(const glm::vec3& cam_pos, const Frustum& frustum) {
+    SelectedNodes selected_nodes;
+    root_.selectNodes(cam_pos, frustum, &selected_nodes);
+    return selected_nodes;
   }
 
   // render with vertex attrib divisor
   void render(const engine::Camera& cam) {
-    mesh_.clearRenderList();
-    root_.selectNodes(cam.transform()->pos(), cam.frustum(),
-                      mesh_, node_dimension_);
-    mesh_.render();
+    QuadGridMesh::RenderList render_list = renderList(cam);
+    mesh().render(render_list);
   }
 
   // render with uniforms
   void render(const engine::Camera& cam,
               const gl::UniformObject<glm::vec4>& uRenderData) {
-    mesh_.clearRenderList();
-    root_.selectNodes(cam.transform()->pos(), cam.frustum(),
-                      mesh_, node_dimension_);
-    mesh_.render(uRenderData);
+    QuadGridMesh::RenderList render_list = renderList(cam);
+    mesh().render(render_list, uRenderData);
   }
 };
 
@@ -2,6 +2,7 @@
 
 #include "./terrain_mesh.h"
 #include "../../oglwrap/smart_enums.h"
+#include "../debug/gl_memory.h"
 
 namespace engine {
 namespace cdlod {
@@ -46,6 +47,9 @@ void TerrainMesh::setup(const gl::Program& program, int tex_unit) {
 
   gl::BindToTexUnit(height_map_tex_, tex_unit);
   height_map_.upload(height_map_tex_);
+  height_map_tex_memory_ = debug::MemoryTracker::Allocation{"terrain",
+      "height map", debug::MemoryTracker::Category::kGpuTexture,
+      debug::BoundTexture2DSize()};
   height_map_tex_.minFilter(gl::kLinear);
   height_map_tex_.magFilter(gl::kLinear);
   gl::Unbind(height_map_tex_);
@@ -12,6 +12,7 @@
 
 #include "./quad_tree.h"
 #include "../shader_manager.h"
+#include "../debug/memory_tracker.h"
 
 namespace engine {
 
@@ -28,6 +29,7 @@ class TerrainMesh {
  private:
   QuadTree mesh_;
   gl::Texture2D height_map_tex_;
+  debug::MemoryTracker::Allocation height_map_tex_memory_;
   std::unique_ptr<gl::LazyUniform<glm::vec4>> uRenderData_;
   std::unique_ptr<gl::LazyUniform<glm::vec3>> uCamPos_;
   const HeightMapInterface& height_map_;
@@ -0,0 +1,25 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./clock.h"
+#include "./oglwrap_config.h"
+#include <GLFW/glfw3.h>
+
+namespace engine {
+
+bool Clock::simulated_ = false;
+double Clock::simulated_time_ = 0;
+double Clock::simulated_dt_ = 0;
+constexpr double Clock::kSimulatedStartTime;
+
+double Clock::now() {
+  return simulated_ ? simulated_time_ : glfwGetTime();
+}
+
+void Clock::Simulate() {
+  if (!simulated_) {
+    simulated_time_ = kSimulatedStartTime;
+    simulated_ = true;
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,37 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_CLOCK_H_
+#define ENGINE_CLOCK_H_
+
+namespace engine {
+
+// The time source of the Timers. By default it is GLFW's wall clock, but it
+// can be switched to a simulated clock, which only advances when it's told to.
+// With that every frame has the same dt, and the physics is stepped in sync
+// with the frames (see GameEngine::deterministic), so the runs are
+// reproducible.
+// Main thread only.
+class Clock {
+ public:
+  // In seconds.
+  static double now();
+
+  static bool simulated() { return simulated_; }
+  // Switches to the simulated clock. It always starts from the same time, so
+  // that the times (and their rounding) are the same in every run.
+  static void Simulate();
+  static void Advance(double dt) { simulated_time_ += dt; simulated_dt_ = dt; }
+  // The step of the last Advance.
+  static double simulated_dt() { return simulated_dt_; }
+
+ private:
+  // Not zero, because the Timers treat zero as an unset time.
+  static constexpr double kSimulatedStartTime = 1.0;
+
+  static bool simulated_;
+  static double simulated_time_, simulated_dt_;
+};
+
+}  // namespace engine
+
+#endif
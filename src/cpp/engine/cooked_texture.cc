@@ -0,0 +1,386 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./cooked_texture.h"
+#include "./binary_stream.h"
+#include "./debug/profiler.h"
+
+namespace engine {
+
+namespace {
+
+// The DDS container, with the DX10 extension header
+struct DdsHeader {
+  char magic[4];
+  std::uint32_t size, flags, height, width, linear_size, depth, mip_map_count;
+  std::uint32_t reserved1[11];
+  struct PixelFormat {
+    std::uint32_t size, flags, four_cc, rgb_bit_count;
+    std::uint32_t r_mask, g_mask, b_mask, a_mask;
+  } pixel_format;
+  std::uint32_t caps, caps2, caps3, caps4, reserved2;
+  std::uint32_t dxgi_format, resource_dimension, misc_flag, array_size;
+  std::uint32_t misc_flags2;
+};
+
+static_assert(sizeof(DdsHeader) == 148, "DdsHeader isn't packed");
+
+const char kDdsMagic[4] = {'D', 'D', 'S', ' '};
+const std::uint32_t kDdsHeaderSize = 124, kDdsPixelFormatSize = 32;
+// caps | height | width | pixel format | mip map count | linear size
+const std::uint32_t kDdsFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+const std::uint32_t kDdsFourCCFlag = 0x4;
+const std::uint32_t kDdsFourCCDx10 = '0' << 24 | '1' << 16 | 'X' << 8 | 'D';
+// complex | texture | mipmap
+const std::uint32_t kDdsCaps = 0x8 | 0x1000 | 0x400000;
+const std::uint32_t kDdsTexture2D = 3;
+
+enum DxgiFormat : std::uint32_t {
+  kBC1 = 71, kBC1Srgb = 72, kBC3 = 77, kBC3Srgb = 78
+};
+
+DxgiFormat FormatOf(bool srgb, bool alpha) {
+  if (alpha) {
+    return srgb ? kBC3Srgb : kBC3;
+  } else {
+    return srgb ? kBC1Srgb : kBC1;
+  }
+}
+
+size_t BlockSize(bool alpha) { return alpha ? 16 : 8; }
+
+size_t CompressedSize(int w, int h, bool alpha) {
+  return size_t((w + 3) / 4) * ((h + 3) / 4) * BlockSize(alpha);
+}
+
+// A level of the mipmap chain, in linear space
+struct LinearImage {
+  int w, h;
+  std::vector<std::array<float, 4>> pixels;
+};
+
+float SrgbToLinear(float value) {
+  return value <= 0.04045f ? value / 12.92f
+                           : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float value) {
+  return value <= 0.0031308f ? value * 12.92f
+                             : 1.055f * std::pow(value, 1 / 2.4f) - 0.055f;
+}
+
+unsigned char ToByte(float value) {
+  return static_cast<unsigned char>(
+      std::round(std::min(std::max(value, 0.0f), 1.0f) * 255));
+}
+
+// Box filters the image to half its size (a 2x2 average, the odd edges are
+// clamped).
+LinearImage Downsample(const LinearImage& image, ThreadPool* thread_pool) {
+  LinearImage half;
+  half.w = std::max(image.w / 2, 1);
+  half.h = std::max(image.h / 2, 1);
+  half.pixels.resize(size_t(half.w) * half.h);
+  auto filter_row = [&image, &half](size_t y) {
+    int y0 = std::min(int(2*y), image.h - 1);
+    int y1 = std::min(int(2*y + 1), image.h - 1);
+    for (int x = 0; x < half.w; ++x) {
+      int x0 = std::min(2*x, image.w - 1), x1 = std::min(2*x + 1, image.w - 1);
+      const auto& a = image.pixels[size_t(y0)*image.w + x0];
+      const auto& b = image.pixels[size_t(y0)*image.w + x1];
+      const auto& c = image.pixels[size_t(y1)*image.w + x0];
+      const auto& d = image.pixels[size_t(y1)*image.w + x1];
+      auto& out = half.pixels[y*half.w + x];
+      for (int i = 0; i < 4; ++i) {
+        out[i] = (a[i] + b[i] + c[i] + d[i]) / 4;
+      }
+    }
+  };
+  if (thread_pool) {
+    thread_pool->parallelFor(half.h, filter_row);
+  } else {
+    for (int y = 0; y < half.h; ++y) { filter_row(y); }
+  }
+  return half;
+}
+
+// 5:6:5 bit colors
+std::uint16_t PackColor(const int color[3]) {
+  return ((color[0] * 31 + 127) / 255) << 11 |
+         ((color[1] * 63 + 127) / 255) << 5 |
+         ((color[2] * 31 + 127) / 255);
+}
+
+void UnpackColor(std::uint16_t packed, int color[3]) {
+  int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+  color[0] = r << 3 | r >> 2;
+  color[1] = g << 2 | g >> 4;
+  color[2] = b << 3 | b >> 2;
+}
+
+// The endpoints are the corners of the bounding box of the colors (inset a
+// bit, as the extreme colors are rarely needed exactly), along the diagonal
+// that follows how the channels change together.
+void CompressColorBlock(const unsigned char block[16][4], unsigned char* out) {
+  int mins[3] = {255, 255, 255}, maxes[3] = {0, 0, 0};
+  float mean[3] = {0, 0, 0};
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      mins[c] = std::min(mins[c], int(block[i][c]));
+      maxes[c] = std::max(maxes[c], int(block[i][c]));
+      mean[c] += block[i][c] / 16.0f;
+    }
+  }
+  int main_channel = 0;
+  for (int c = 1; c < 3; ++c) {
+    if (maxes[c] - mins[c] > maxes[main_channel] - mins[main_channel]) {
+      main_channel = c;
+    }
+  }
+  for (int c = 0; c < 3; ++c) {
+    float covariance = 0;
+    for (int i = 0; i < 16; ++i) {
+      covariance += (block[i][c] - mean[c]) *
+                    (block[i][main_channel] - mean[main_channel]);
+    }
+    if (covariance < 0) { std::swap(mins[c], maxes[c]); }
+    int inset = (maxes[c] - mins[c]) / 16;
+    maxes[c] -= inset;
+    mins[c] += inset;
+  }
+
+  std::uint16_t color0 = PackColor(maxes), color1 = PackColor(mins);
+  if (color0 < color1) { std::swap(color0, color1); }
+
+  // Only the four color mode is used (the three color one has transparency)
+  std::uint32_t indices = 0;
+  if (color0 != color1) {
+    int palette[4][3];
+    UnpackColor(color0, palette[0]);
+    UnpackColor(color1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int best = 0, best_distance = 1 << 30;
+      for (int j = 0; j < 4; ++j) {
+        int distance = 0;
+        for (int c = 0; c < 3; ++c) {
+          int diff = block[i][c] - palette[j][c];
+          distance += diff * diff;
+        }
+        if (distance < best_distance) {
+          best = j;
+          best_distance = distance;
+        }
+      }
+      indices |= std::uint32_t(best) << (2*i);
+    }
+  }
+
+  std::memcpy(out, &color0, 2);
+  std::memcpy(out + 2, &color1, 2);
+  std::memcpy(out + 4, &indices, 4);
+}
+
+// The eight alpha values mode, between the smallest and the largest alpha.
+void CompressAlphaBlock(const unsigned char block[16][4], unsigned char* out) {
+  int alpha0 = 0, alpha1 = 255;
+  for (int i = 0; i < 16; ++i) {
+    alpha0 = std::max(alpha0, int(block[i][3]));
+    alpha1 = std::min(alpha1, int(block[i][3]));
+  }
+
+  std::uint64_t indices = 0;
+  if (alpha0 != alpha1) {
+    int palette[8] = {alpha0, alpha1};
+    for (int j = 2; j < 8; ++j) {
+      palette[j] = ((8 - j) * alpha0 + (j - 1) * alpha1) / 7;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int best = 0;
+      for (int j = 1; j < 8; ++j) {
+        if (std::abs(block[i][3] - palette[j]) <
+            std::abs(block[i][3] - palette[best])) {
+          best = j;
+        }
+      }
+      indices |= std::uint64_t(best) << (3*i);
+    }
+  }
+
+  out[0] = alpha0;
+  out[1] = alpha1;
+  for (int i = 0; i < 6; ++i) {
+    out[2 + i] = (indices >> (8*i)) & 0xFF;
+  }
+}
+
+// Compresses a level, the edge blocks are padded by clamping.
+void Compress(const LinearImage& image, bool srgb, bool alpha,
+              unsigned char* out, ThreadPool* thread_pool) {
+  int blocks_w = (image.w + 3) / 4, blocks_h = (image.h + 3) / 4;
+  auto compress_row = [&](size_t block_y) {
+    for (int block_x = 0; block_x < blocks_w; ++block_x) {
+      unsigned char block[16][4];
+      for (int i = 0; i < 16; ++i) {
+        int x = std::min(4*block_x + i % 4, image.w - 1);
+        int y = std::min(int(4*block_y) + i / 4, image.h - 1);
+        const auto& pixel = image.pixels[size_t(y)*image.w + x];
+        for (int c = 0; c < 3; ++c) {
+          block[i][c] = ToByte(srgb ? LinearToSrgb(pixel[c]) : pixel[c]);
+        }
+        block[i][3] = ToByte(pixel[3]);
+      }
+      unsigned char* block_out =
+          out + (block_y * blocks_w + block_x) * BlockSize(alpha);
+      if (alpha) {
+        CompressAlphaBlock(block, block_out);
+        block_out += 8;
+      }
+      CompressColorBlock(block, block_out);
+    }
+  };
+  if (thread_pool) {
+    thread_pool->parallelFor(blocks_h, compress_row);
+  } else {
+    for (int y = 0; y < blocks_h; ++y) { compress_row(y); }
+  }
+}
+
+}  // namespace
+
+CookedTexture::CookedTexture(
+    int w, int h, const std::vector<std::array<unsigned char, 4>>& pixels,
+    bool srgb, bool alpha, ThreadPool* thread_pool)
+    : srgb_(srgb), alpha_(alpha) {
+  ENGINE_PROFILE("cook texture");
+  if (w <= 0 || h <= 0 || pixels.size() != size_t(w) * h) {
+    throw std::invalid_argument("CookedTexture: invalid image size");
+  }
+
+  float to_linear[256];
+  for (int i = 0; i < 256; ++i) {
+    to_linear[i] = srgb ? SrgbToLinear(i / 255.0f) : i / 255.0f;
+  }
+  LinearImage image{w, h, {}};
+  image.pixels.resize(pixels.size());
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    for (int c = 0; c < 3; ++c) {
+      image.pixels[i][c] = to_linear[pixels[i][c]];
+    }
+    image.pixels[i][3] = pixels[i][3] / 255.0f;
+  }
+
+  // The offsets are turned into pointers when the data is complete
+  std::vector<size_t> offsets;
+  while (true) {
+    offsets.push_back(data_.size());
+    levels_.push_back(Level{image.w, image.h, nullptr,
+                            CompressedSize(image.w, image.h, alpha)});
+    data_.resize(data_.size() + levels_.back().size);
+    Compress(image, srgb, alpha, &data_[offsets.back()], thread_pool);
+    if (image.w == 1 && image.h == 1) { break; }
+    image = Downsample(image, thread_pool);
+  }
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    levels_[i].data = data_.data() + offsets[i];
+  }
+}
+
+std::unique_ptr<CookedTexture> CookedTexture::Load(const std::string& path) {
+  ENGINE_PROFILE("load cooked texture");
+  std::unique_ptr<CookedTexture> texture{new CookedTexture};
+  try {
+    texture->file_ = MappedFile{path};
+  } catch (const std::runtime_error&) {
+    return nullptr;
+  }
+
+  try {
+    BinaryReader in{texture->file_.data(), texture->file_.size()};
+    auto header = in.value<DdsHeader>();
+    if (std::memcmp(header.magic, kDdsMagic, sizeof(kDdsMagic)) != 0 ||
+        header.size != kDdsHeaderSize ||
+        header.pixel_format.size != kDdsPixelFormatSize ||
+        header.pixel_format.four_cc != kDdsFourCCDx10 ||
+        header.resource_dimension != kDdsTexture2D ||
+        header.array_size != 1) {
+      throw std::runtime_error("not a 2D DDS texture");
+    }
+    switch (header.dxgi_format) {
+      case kBC1: texture->srgb_ = false; texture->alpha_ = false; break;
+      case kBC1Srgb: texture->srgb_ = true; texture->alpha_ = false; break;
+      case kBC3: texture->srgb_ = false; texture->alpha_ = true; break;
+      case kBC3Srgb: texture->srgb_ = true; texture->alpha_ = true; break;
+      default: throw std::runtime_error("unsupported format");
+    }
+
+    // Only full mipmap chains are written
+    int w = header.width, h = header.height;
+    if (w <= 0 || h <= 0 || header.width > 1 << 16 ||
+        header.height > 1 << 16) {
+      throw std::runtime_error("invalid size");
+    }
+    while (true) {
+      size_t size = CompressedSize(w, h, texture->alpha_);
+      texture->levels_.push_back(
+          Level{w, h, in.array<unsigned char>(size), size});
+      if (w == 1 && h == 1) { break; }
+      w = std::max(w / 2, 1);
+      h = std::max(h / 2, 1);
+    }
+    if (header.mip_map_count != texture->levels_.size() || !in.done()) {
+      throw std::runtime_error("invalid mipmap chain");
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << "Ignoring the invalid cooked texture " << path
+              << " (" << ex.what() << ")" << std::endl;
+    return nullptr;
+  }
+
+  return texture;
+}
+
+bool CookedTexture::save(const std::string& path) const {
+  DdsHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kDdsMagic, sizeof(kDdsMagic));
+  header.size = kDdsHeaderSize;
+  header.flags = kDdsFlags;
+  header.height = h();
+  header.width = w();
+  header.linear_size = levels_[0].size;
+  header.mip_map_count = levels_.size();
+  header.pixel_format.size = kDdsPixelFormatSize;
+  header.pixel_format.flags = kDdsFourCCFlag;
+  header.pixel_format.four_cc = kDdsFourCCDx10;
+  header.caps = kDdsCaps;
+  header.dxgi_format = FormatOf(srgb_, alpha_);
+  header.resource_dimension = kDdsTexture2D;
+  header.array_size = 1;
+
+  BinaryWriter out;
+  out.value(header);
+  for (const Level& level : levels_) {
+    out.array(level.data, level.size);
+  }
+  return out.save(path);
+}
+
+size_t CookedTexture::size() const {
+  size_t size = 0;
+  for (const Level& level : levels_) {
+    size += level.size;
+  }
+  return size;
+}
+
+}  // namespace engine
@@ -0,0 +1,65 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_COOKED_TEXTURE_H_
+#define ENGINE_COOKED_TEXTURE_H_
+
+#include <array>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "./mapped_file.h"
+#include "./thread_pool.h"
+
+namespace engine {
+
+// A texture with its whole mipmap chain, compressed to BC1 (DXT1), or BC3
+// (DXT5) if it has an alpha channel, so it can be uploaded as it is. The
+// mipmaps are filtered in linear space, so sRGB textures don't get darker
+// in the distance. The cooked file is a standard DDS (with the DX10 header,
+// which also stores if the texture is sRGB).
+class CookedTexture {
+ public:
+  struct Level {
+    int w, h;
+    const unsigned char* data;
+    size_t size;
+  };
+
+  // Builds the mipmaps of the pixels (row by row), and compresses them. The
+  // thread pool is used for the work if it's given.
+  CookedTexture(int w, int h,
+                const std::vector<std::array<unsigned char, 4>>& pixels,
+                bool srgb, bool alpha, ThreadPool* thread_pool = nullptr);
+
+  CookedTexture(CookedTexture&&) = default;
+  CookedTexture& operator=(CookedTexture&&) = default;
+
+  // Maps a cooked file. Returns nullptr if it's missing or invalid.
+  static std::unique_ptr<CookedTexture> Load(const std::string& path);
+
+  // Returns false if the file can't be written.
+  bool save(const std::string& path) const;
+
+  int w() const { return levels_[0].w; }
+  int h() const { return levels_[0].h; }
+  bool srgb() const { return srgb_; }
+  bool alpha() const { return alpha_; }
+  // The base level first, down to 1x1.
+  const std::vector<Level>& levels() const { return levels_; }
+  // The compressed size of every level.
+  size_t size() const;
+
+ private:
+  bool srgb_ = false, alpha_ = false;
+  std::vector<Level> levels_;
+  // One of them owns the levels' data
+  std::vector<unsigned char> data_;
+  MappedFile file_;
+
+  CookedTexture() = default;
+};
+
+}  // namespace engine
+
+#endif
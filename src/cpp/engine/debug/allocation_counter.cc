@@ -0,0 +1,59 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <new>
+#include <cstdlib>
+
+#include "./allocation_counter.h"
+
+#if !ENGINE_NO_PROFILER
+
+namespace {
+
+// It's constant initialized, so it's safe to use before main and while a
+// thread is starting.
+thread_local size_t allocations = 0;
+
+void* Allocate(size_t size) {
+  ++allocations;
+  return std::malloc(size ? size : 1);
+}
+
+}  // namespace
+
+namespace engine {
+namespace debug {
+
+size_t AllocationCounter::ThisThread() {
+  return allocations;
+}
+
+}  // namespace debug
+}  // namespace engine
+
+// The array and the sized forms call these by default.
+void* operator new(size_t size) {
+  while (true) {
+    if (void* memory = Allocate(size)) { return memory; }
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) { throw std::bad_alloc{}; }
+    handler();
+  }
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+
+#endif  // !ENGINE_NO_PROFILER
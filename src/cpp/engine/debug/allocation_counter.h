@@ -0,0 +1,31 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_ALLOCATION_COUNTER_H_
+#define ENGINE_DEBUG_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace engine {
+namespace debug {
+
+// Counts the heap allocations (the calls to the global operator new, which
+// allocation_counter.cc replaces) of each thread. A steady state frame should
+// only use the FrameArena, RunHeadless checks it with this. Like the
+// Profiler, it's compiled out with ENGINE_NO_PROFILER, and then the default
+// operator new is used.
+class AllocationCounter {
+ public:
+#if ENGINE_NO_PROFILER
+  static bool enabled() { return false; }
+  static size_t ThisThread() { return 0; }
+#else
+  static bool enabled() { return true; }
+  // The number of allocations that the current thread has made so far.
+  static size_t ThisThread();
+#endif
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
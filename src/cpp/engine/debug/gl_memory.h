@@ -0,0 +1,42 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_GL_MEMORY_H_
+#define ENGINE_DEBUG_GL_MEMORY_H_
+
+#include <cstddef>
+#include <initializer_list>
+#include "../oglwrap_config.h"
+
+namespace engine {
+namespace debug {
+
+// The size of the base level of the texture bound to GL_TEXTURE_2D, in the
+// internal format that the driver has chosen for it.
+inline size_t BoundTexture2DSize() {
+  GLint compressed = GL_FALSE;
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED,
+                           &compressed);
+  if (compressed) {
+    GLint size = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0,
+                             GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+    return size;
+  }
+
+  GLint width = 0, height = 0, bits = 0;
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+  for (GLenum component : {GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE,
+                           GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE,
+                           GL_TEXTURE_DEPTH_SIZE}) {
+    GLint component_bits = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, component, &component_bits);
+    bits += component_bits;
+  }
+  return size_t(width) * height * ((bits + 7) / 8);
+}
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
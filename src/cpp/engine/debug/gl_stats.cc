@@ -0,0 +1,115 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <typeinfo>
+#include <algorithm>
+
+#include "./gl_stats.h"
+#include "./profiler.h"
+#include "../game_object.h"
+
+namespace engine {
+namespace debug {
+
+namespace {
+
+void WriteCsvRow(std::ofstream& csv, size_t frame, const std::string& name,
+                 const GlStats::Counters& counters) {
+  // The demangled names might contain commas
+  csv << frame << ",\"" << name << "\"," << counters.draw_calls << ','
+      << counters.triangles << ',' << counters.buffer_uploads << ','
+      << counters.texture_uploads << ',' << counters.bytes_uploaded << ','
+      << counters.texture_binds << ',' << counters.uniform_sets << ','
+      << counters.program_uses << ',' << counters.state_changes << '\n';
+}
+
+}  // namespace
+
+bool GlStats::enabled_ = false;
+size_t GlStats::frame_count_ = 0;
+GlStats::Counters GlStats::unattributed_;
+GlStats::ObjectCounters* GlStats::current_object_ = nullptr;
+std::unordered_map<int, GlStats::ObjectCounters> GlStats::objects_;
+GlStats::Counters GlStats::last_frame_;
+std::vector<GlStats::ObjectCounters> GlStats::last_frame_objects_;
+std::ofstream GlStats::csv_;
+
+GlStats::Counters& GlStats::Counters::operator+=(const Counters& other) {
+  draw_calls += other.draw_calls;
+  triangles += other.triangles;
+  buffer_uploads += other.buffer_uploads;
+  texture_uploads += other.texture_uploads;
+  bytes_uploaded += other.bytes_uploaded;
+  texture_binds += other.texture_binds;
+  uniform_sets += other.uniform_sets;
+  program_uses += other.program_uses;
+  state_changes += other.state_changes;
+  return *this;
+}
+
+GlStats::ObjectScope::ObjectScope(const GameObject* object)
+    : previous_(current_object_) {
+  if (enabled_ && object) {
+    ObjectCounters& counters = objects_[object->uid()];
+    counters.name = typeid(*object).name();
+    counters.uid = object->uid();
+    current_object_ = &counters;
+  }
+}
+
+void GlStats::EndFrame() {
+  last_frame_ = unattributed_;
+  last_frame_objects_.clear();
+  // No ObjectScope is alive between the frames. The entries of the objects
+  // that didn't issue any command are erased, as they might be dead.
+  for (auto iter = objects_.begin(); iter != objects_.end();) {
+    const Counters& counters = iter->second.counters;
+    if (counters.draw_calls || counters.buffer_uploads ||
+        counters.texture_uploads || counters.texture_binds ||
+        counters.uniform_sets || counters.program_uses ||
+        counters.state_changes) {
+      last_frame_ += counters;
+      last_frame_objects_.push_back(iter->second);
+      iter->second.counters = Counters{};
+      ++iter;
+    } else {
+      iter = objects_.erase(iter);
+    }
+  }
+  unattributed_ = Counters{};
+
+  std::sort(last_frame_objects_.begin(), last_frame_objects_.end(),
+            [](const ObjectCounters& a, const ObjectCounters& b) {
+    return a.counters.draw_calls > b.counters.draw_calls;
+  });
+
+  if (csv_.is_open()) {
+    WriteCsvRow(csv_, frame_count_, "frame", last_frame_);
+    for (const ObjectCounters& object : last_frame_objects_) {
+      WriteCsvRow(csv_, frame_count_,
+                  Profiler::ReadableName(object.name) + " #" +
+                      std::to_string(object.uid),
+                  object.counters);
+    }
+  }
+  ++frame_count_;
+}
+
+bool GlStats::StartCsv(const std::string& path) {
+  StopCsv();
+  csv_.open(path);
+  if (!csv_) { return false; }
+  csv_ << "frame,object,draw_calls,triangles,buffer_uploads,texture_uploads,"
+          "bytes_uploaded,texture_binds,uniform_sets,program_uses,"
+          "state_changes\n";
+  return true;
+}
+
+void GlStats::StopCsv() {
+  if (csv_.is_open()) {
+    csv_.close();
+  }
+  csv_.clear();
+}
+
+}  // namespace debug
+}  // namespace engine
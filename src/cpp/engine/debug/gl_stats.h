@@ -0,0 +1,140 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_GL_STATS_H_
+#define ENGINE_DEBUG_GL_STATS_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <cstddef>
+
+namespace engine {
+
+class GameObject;
+
+namespace debug {
+
+// Counts the GL commands that the engine issues per frame, and attributes
+// them to the GameObject that was rendering. The calls are counted at the GL
+// boundary (see gl_stats_hooks.cc): the GL 1.1 functions are wrapped by the
+// linker, and the ones that GLEW loads are replaced after glewInit, so every
+// real call is counted, whoever makes it. Everything is main thread only
+// (like the GL context), and the counting is a no-op while it is disabled.
+class GlStats {
+ public:
+  struct Counters {
+    size_t draw_calls = 0;
+    size_t triangles = 0;
+    size_t buffer_uploads = 0;
+    size_t texture_uploads = 0;
+    size_t bytes_uploaded = 0;
+    size_t texture_binds = 0;
+    size_t uniform_sets = 0;
+    size_t program_uses = 0;
+    size_t state_changes = 0;
+
+    Counters& operator+=(const Counters& other);
+  };
+
+  struct ObjectCounters {
+    const char* name;  // the mangled type name (see Profiler::ReadableName)
+    int uid;  // the GameObject's uid
+    Counters counters;
+  };
+
+  static bool enabled() { return enabled_; }
+  static void set_enabled(bool value) { enabled_ = value; }
+
+  // Hooks the GL entry points. Has to be called after glewInit.
+  static void InstallHooks();
+
+  // Attributes the commands to a GameObject until its destruction.
+  class ObjectScope {
+   public:
+    explicit ObjectScope(const GameObject* object);
+    ~ObjectScope() { current_object_ = previous_; }
+
+   private:
+    ObjectCounters* previous_;
+
+    ObjectScope(const ObjectScope&) = delete;
+    ObjectScope& operator=(const ObjectScope&) = delete;
+  };
+
+  // Ends the frame, and writes its counters to the csv file, if it's open.
+  static void EndFrame();
+  static const Counters& last_frame() { return last_frame_; }
+  // Ordered by the number of draw calls, descending.
+  static const std::vector<ObjectCounters>& last_frame_objects() {
+    return last_frame_objects_;
+  }
+
+  // Writes a row for every frame, and every object that issued commands in
+  // it, until StopCsv is called. Returns false if the file can't be opened.
+  static bool StartCsv(const std::string& path);
+  static void StopCsv();
+  static bool writing_csv() { return csv_.is_open(); }
+
+ private:
+  static bool enabled_;
+  static size_t frame_count_;
+  static Counters unattributed_;
+  static ObjectCounters* current_object_;
+  static std::unordered_map<int, ObjectCounters> objects_;
+  static Counters last_frame_;
+  static std::vector<ObjectCounters> last_frame_objects_;
+  static std::ofstream csv_;
+
+  static Counters& current() {
+    return current_object_ ? current_object_->counters : unattributed_;
+  }
+
+  // Only the GL hooks count
+  friend struct GlHooks;
+
+  static void DrawCall(size_t triangles) {
+    if (enabled_) {
+      ++current().draw_calls;
+      current().triangles += triangles;
+    }
+  }
+  static void BufferUpload(size_t bytes) {
+    if (enabled_) {
+      ++current().buffer_uploads;
+      current().bytes_uploaded += bytes;
+    }
+  }
+  static void TextureUpload(size_t bytes) {
+    if (enabled_) {
+      ++current().texture_uploads;
+      current().bytes_uploaded += bytes;
+    }
+  }
+  static void TextureBind(size_t count = 1) {
+    if (enabled_) { current().texture_binds += count; }
+  }
+  static void UniformSet(size_t count = 1) {
+    if (enabled_) { current().uniform_sets += count; }
+  }
+  static void ProgramUse() {
+    if (enabled_) { ++current().program_uses; }
+  }
+  static void StateChange(size_t count = 1) {
+    if (enabled_) { current().state_changes += count; }
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+// Attributes the GL commands in the rest of the enclosing scope to this.
+#if ENGINE_NO_PROFILER
+  #define ENGINE_GL_STATS_OBJECT()
+#else
+  #define ENGINE_GL_STATS_OBJECT() \
+    ::engine::debug::GlStats::ObjectScope gl_stats_scope_{ \
+        ::engine::debug::GlStats::enabled() ? this : nullptr}
+#endif
+
+#endif
@@ -0,0 +1,269 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "../oglwrap_config.h"
+#include "./gl_stats.h"
+
+// The GL entry points are hooked at two levels:
+//  - The GL 1.1 functions are exported by libGL, the calls to them are
+//    redirected to the __wrap_ functions below by the linker (--wrap, see
+//    the Makefile), which call the real ones through __real_.
+//  - The newer ones are function pointers that glewInit loads. These are
+//    replaced with counting trampolines that call the original pointer.
+
+namespace engine {
+namespace debug {
+
+struct GlHooks {
+  static size_t Triangles(GLenum mode, size_t count) {
+    switch (mode) {
+      case GL_TRIANGLES: return count / 3;
+      case GL_TRIANGLE_STRIP: case GL_TRIANGLE_FAN:
+        return count > 2 ? count - 2 : 0;
+      default: return 0;
+    }
+  }
+
+  static size_t PixelSize(GLenum format, GLenum type) {
+    size_t components;
+    switch (format) {
+      case GL_RG: components = 2; break;
+      case GL_RGB: case GL_BGR: components = 3; break;
+      case GL_RGBA: case GL_BGRA: components = 4; break;
+      default: components = 1; break;
+    }
+    switch (type) {
+      case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+      case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+        return 2 * components;
+      case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+        return 4 * components;
+      default: return 4;  // the packed formats
+    }
+  }
+
+  static void TextureBind() { GlStats::TextureBind(); }
+  static void StateChange() { GlStats::StateChange(); }
+  static void Draw(GLenum mode, size_t count, size_t instances = 1) {
+    GlStats::DrawCall(Triangles(mode, count) * instances);
+  }
+  static void TextureUpload(GLsizei width, GLsizei height, GLsizei depth,
+                            GLenum format, GLenum type) {
+    GlStats::TextureUpload(size_t(width) * height * depth *
+                           PixelSize(format, type));
+  }
+
+  // The trampolines of the GLEW function pointers. Every hooked function
+  // returns void.
+  template<typename Fn> struct Glew;
+  template<typename... Args> struct Glew<void (GLAPIENTRY *)(Args...)> {
+    using Fn = void (GLAPIENTRY *)(Args...);
+
+    template<Fn* pointer>
+    static Fn& Original() {
+      static Fn original = nullptr;
+      return original;
+    }
+
+    // Calls 'count' with the arguments, before the GL function.
+    template<Fn* pointer, void (*count)(Args...)>
+    static void GLAPIENTRY Counted(Args... args) {
+      if (GlStats::enabled_) { count(args...); }
+      Original<pointer>()(args...);
+    }
+
+    // Increments one of the counters, before the GL function.
+    template<Fn* pointer, size_t GlStats::Counters::* counter>
+    static void GLAPIENTRY Incremented(Args... args) {
+      if (GlStats::enabled_) { ++(GlStats::current().*counter); }
+      Original<pointer>()(args...);
+    }
+
+    // A function that the context doesn't support stays nullptr.
+    static void Install(Fn* pointer, Fn& original, Fn hook) {
+      if (*pointer && !original) {
+        original = *pointer;
+        *pointer = hook;
+      }
+    }
+  };
+
+  static void DrawArraysInstanced(GLenum mode, GLint, GLsizei count,
+                                  GLsizei instances) {
+    Draw(mode, count, instances);
+  }
+  static void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum,
+                                    const void*, GLsizei instances) {
+    Draw(mode, count, instances);
+  }
+  static void DrawRangeElements(GLenum mode, GLuint, GLuint, GLsizei count,
+                                GLenum, const void*) {
+    Draw(mode, count);
+  }
+  static void BufferData(GLenum, GLsizeiptr size, const void* data, GLenum) {
+    GlStats::BufferUpload(data ? size : 0);
+  }
+  static void BufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*) {
+    GlStats::BufferUpload(size);
+  }
+  static void TexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height,
+                         GLsizei depth, GLint, GLenum format, GLenum type,
+                         const void* data) {
+    if (data) { TextureUpload(width, height, depth, format, type); }
+  }
+  static void CompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei,
+                                   GLint, GLsizei size, const void*) {
+    GlStats::TextureUpload(size);
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+using engine::debug::GlHooks;
+using engine::debug::GlStats;
+
+extern "C" {
+
+void GLAPIENTRY __real_glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void GLAPIENTRY __wrap_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+  if (GlStats::enabled()) { GlHooks::Draw(mode, count); }
+  __real_glDrawArrays(mode, first, count);
+}
+
+void GLAPIENTRY __real_glDrawElements(GLenum mode, GLsizei count, GLenum type,
+                                      const void* indices);
+void GLAPIENTRY __wrap_glDrawElements(GLenum mode, GLsizei count, GLenum type,
+                                      const void* indices) {
+  if (GlStats::enabled()) { GlHooks::Draw(mode, count); }
+  __real_glDrawElements(mode, count, type, indices);
+}
+
+void GLAPIENTRY __real_glBindTexture(GLenum target, GLuint texture);
+void GLAPIENTRY __wrap_glBindTexture(GLenum target, GLuint texture) {
+  if (GlStats::enabled()) { GlHooks::TextureBind(); }
+  __real_glBindTexture(target, texture);
+}
+
+void GLAPIENTRY __real_glTexImage2D(GLenum target, GLint level,
+                                    GLint internal_format, GLsizei width,
+                                    GLsizei height, GLint border,
+                                    GLenum format, GLenum type,
+                                    const void* data);
+void GLAPIENTRY __wrap_glTexImage2D(GLenum target, GLint level,
+                                    GLint internal_format, GLsizei width,
+                                    GLsizei height, GLint border,
+                                    GLenum format, GLenum type,
+                                    const void* data) {
+  // Allocating the storage (for a render target) isn't an upload
+  if (GlStats::enabled() && data) {
+    GlHooks::TextureUpload(width, height, 1, format, type);
+  }
+  __real_glTexImage2D(target, level, internal_format, width, height, border,
+                      format, type, data);
+}
+
+void GLAPIENTRY __real_glTexSubImage2D(GLenum target, GLint level,
+                                       GLint xoffset, GLint yoffset,
+                                       GLsizei width, GLsizei height,
+                                       GLenum format, GLenum type,
+                                       const void* data);
+void GLAPIENTRY __wrap_glTexSubImage2D(GLenum target, GLint level,
+                                       GLint xoffset, GLint yoffset,
+                                       GLsizei width, GLsizei height,
+                                       GLenum format, GLenum type,
+                                       const void* data) {
+  if (GlStats::enabled()) {
+    GlHooks::TextureUpload(width, height, 1, format, type);
+  }
+  __real_glTexSubImage2D(target, level, xoffset, yoffset, width, height,
+                         format, type, data);
+}
+
+// The fixed function state changes
+void GLAPIENTRY __real_glEnable(GLenum cap);
+void GLAPIENTRY __wrap_glEnable(GLenum cap) {
+  if (GlStats::enabled()) { GlHooks::StateChange(); }
+  __real_glEnable(cap);
+}
+
+void GLAPIENTRY __real_glDisable(GLenum cap);
+void GLAPIENTRY __wrap_glDisable(GLenum cap) {
+  if (GlStats::enabled()) { GlHooks::StateChange(); }
+  __real_glDisable(cap);
+}
+
+void GLAPIENTRY __real_glBlendFunc(GLenum src, GLenum dst);
+void GLAPIENTRY __wrap_glBlendFunc(GLenum src, GLenum dst) {
+  if (GlStats::enabled()) { GlHooks::StateChange(); }
+  __real_glBlendFunc(src, dst);
+}
+
+void GLAPIENTRY __real_glDepthMask(GLboolean flag);
+void GLAPIENTRY __wrap_glDepthMask(GLboolean flag) {
+  if (GlStats::enabled()) { GlHooks::StateChange(); }
+  __real_glDepthMask(flag);
+}
+
+void GLAPIENTRY __real_glCullFace(GLenum mode);
+void GLAPIENTRY __wrap_glCullFace(GLenum mode) {
+  if (GlStats::enabled()) { GlHooks::StateChange(); }
+  __real_glCullFace(mode);
+}
+
+}  // extern "C"
+
+namespace engine {
+namespace debug {
+
+#define ENGINE_GLEW_HOOK(name, hook) { \
+  using Hook = GlHooks::Glew<decltype(__glew##name)>; \
+  Hook::Install(&__glew##name, Hook::Original<&__glew##name>(), \
+                &Hook::hook); \
+}
+#define ENGINE_GLEW_COUNT(name) \
+  ENGINE_GLEW_HOOK(name, Counted<&__glew##name ENGINE_GLEW_COMMA \
+                                 &GlHooks::name>)
+#define ENGINE_GLEW_INCREMENT(name, counter) \
+  ENGINE_GLEW_HOOK(name, Incremented<&__glew##name ENGINE_GLEW_COMMA \
+                                     &GlStats::Counters::counter>)
+#define ENGINE_GLEW_COMMA ,
+
+void GlStats::InstallHooks() {
+  ENGINE_GLEW_COUNT(DrawArraysInstanced);
+  ENGINE_GLEW_COUNT(DrawElementsInstanced);
+  ENGINE_GLEW_COUNT(DrawRangeElements);
+  ENGINE_GLEW_COUNT(BufferData);
+  ENGINE_GLEW_COUNT(BufferSubData);
+  ENGINE_GLEW_COUNT(TexImage3D);
+  ENGINE_GLEW_COUNT(CompressedTexImage2D);
+
+  ENGINE_GLEW_INCREMENT(UseProgram, program_uses);
+
+  ENGINE_GLEW_INCREMENT(Uniform1i, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform1f, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform2f, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform3f, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform4f, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform1iv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform1fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform2fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform3fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(Uniform4fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(UniformMatrix2fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(UniformMatrix3fv, uniform_sets);
+  ENGINE_GLEW_INCREMENT(UniformMatrix4fv, uniform_sets);
+
+  ENGINE_GLEW_INCREMENT(ActiveTexture, state_changes);
+  ENGINE_GLEW_INCREMENT(BindBuffer, state_changes);
+  ENGINE_GLEW_INCREMENT(BindVertexArray, state_changes);
+  ENGINE_GLEW_INCREMENT(BindFramebuffer, state_changes);
+  ENGINE_GLEW_INCREMENT(BlendFuncSeparate, state_changes);
+}
+
+#undef ENGINE_GLEW_COMMA
+#undef ENGINE_GLEW_INCREMENT
+#undef ENGINE_GLEW_COUNT
+#undef ENGINE_GLEW_HOOK
+
+}  // namespace debug
+}  // namespace engine
@@ -0,0 +1,109 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_GL_STATS_OVERLAY_H_
+#define ENGINE_DEBUG_GL_STATS_OVERLAY_H_
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "../behaviour.h"
+#include "../gui/label.h"
+#include "./gl_stats.h"
+#include "./profiler.h"
+
+namespace engine {
+namespace debug {
+
+// Shows the GL commands of the last frame, in total and per object type.
+// F6 toggles the overlay, F7 starts / stops writing the counters of every
+// frame to gl_stats.csv. The commands are only counted while either is on.
+class GlStatsOverlay : public Behaviour {
+ public:
+  explicit GlStatsOverlay(GameObject* parent) : Behaviour(parent) {
+    for (size_t i = 0; i < labels_.size(); ++i) {
+      labels_[i] = addComponent<gui::Label>(
+          L"", glm::vec2{0.3f, 0.9f - 0.04f*i},
+          gui::Font{"src/resources/fonts/Vera.ttf", 14,
+                    glm::vec4(0, 1, 1, 1)});
+      labels_[i]->set_horizontal_alignment(
+          gui::Font::HorizontalAlignment::kLeft);
+      labels_[i]->set_enabled(false);
+    }
+  }
+
+ private:
+  static constexpr float kRefreshInterval = 0.25f;
+  std::array<gui::Label*, 16> labels_;
+  double time_since_refresh_ = 0;
+  bool visible_ = false;
+
+  virtual void update() override {
+    if (!visible_) { return; }
+
+    time_since_refresh_ += scene_->camera_time().dt;
+    if (time_since_refresh_ < kRefreshInterval) { return; }
+    time_since_refresh_ = 0;
+
+    char line[128];
+    const GlStats::Counters& frame = GlStats::last_frame();
+    std::snprintf(line, sizeof(line), "draws: %zu  triangles: %zu",
+                  frame.draw_calls, frame.triangles);
+    setLine(0, line);
+    std::snprintf(line, sizeof(line),
+                  "uploads: %zu buffers, %zu textures, %.1f KB",
+                  frame.buffer_uploads, frame.texture_uploads,
+                  frame.bytes_uploaded / 1024.0);
+    setLine(1, line);
+    std::snprintf(line, sizeof(line),
+                  "binds: %zu textures, %zu programs  uniforms: %zu  "
+                  "states: %zu", frame.texture_binds, frame.program_uses,
+                  frame.uniform_sets, frame.state_changes);
+    setLine(2, line);
+
+    size_t i = 3;
+    for (const auto& object : GlStats::last_frame_objects()) {
+      if (i == labels_.size()) { break; }
+      std::snprintf(line, sizeof(line),
+                    "%s #%d: %zu draws, %zu tris, %zu binds",
+                    Profiler::ReadableName(object.name).c_str(), object.uid,
+                    object.counters.draw_calls, object.counters.triangles,
+                    object.counters.texture_binds);
+      setLine(i++, line);
+    }
+    for (; i < labels_.size(); ++i) {
+      setLine(i, "");
+    }
+  }
+
+  virtual void keyAction(int key, int scancode, int action, int mods) override {
+    if (action != GLFW_PRESS) { return; }
+    if (key == GLFW_KEY_F6) {
+      visible_ = !visible_;
+      for (gui::Label* label : labels_) {
+        label->set_enabled(visible_);
+      }
+    } else if (key == GLFW_KEY_F7) {
+      if (GlStats::writing_csv()) {
+        GlStats::StopCsv();
+        std::cout << "GL stats written to gl_stats.csv" << std::endl;
+      } else if (GlStats::StartCsv("gl_stats.csv")) {
+        std::cout << "Writing GL stats to gl_stats.csv" << std::endl;
+      } else {
+        std::cerr << "Couldn't open gl_stats.csv" << std::endl;
+      }
+    } else {
+      return;
+    }
+    GlStats::set_enabled(visible_ || GlStats::writing_csv());
+  }
+
+  void setLine(size_t i, const std::string& text) {
+    labels_[i]->set_text(std::wstring(text.begin(), text.end()));
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
@@ -0,0 +1,189 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include "./memory_tracker.h"
+
+namespace engine {
+namespace debug {
+
+using Category = MemoryTracker::Category;
+using Record = MemoryTracker::Record;
+
+struct MemoryTracker::Record {
+  const char* subsystem;
+  std::string owner;
+  Category category;
+  size_t bytes, peak, allocations;
+};
+
+namespace {
+
+const size_t kNumCategories = 3;
+
+const char* CategoryName(Category category) {
+  switch (category) {
+    case Category::kCpu: return "CPU";
+    case Category::kGpuBuffer: return "GPU buffers";
+    case Category::kGpuTexture: return "GPU textures";
+  }
+  return "";
+}
+
+std::string Megabytes(size_t bytes) {
+  char str[32];
+  std::snprintf(str, sizeof(str), "%.2f MB", bytes / (1024.0 * 1024.0));
+  return str;
+}
+
+struct Registry {
+  std::mutex mutex;
+  // The records are kept after their allocations die, for the peaks.
+  std::map<std::tuple<Category, std::string, std::string>, Record> records;
+  size_t totals[kNumCategories] = {0, 0, 0};
+  size_t peaks[kNumCategories] = {0, 0, 0};
+};
+
+// It is never destroyed, as the static objects might hold allocations.
+Registry& GetRegistry() {
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+// Must be called with the registry's mutex held.
+void Resize(Registry& registry, Record* record,
+            size_t old_bytes, size_t new_bytes) {
+  size_t& total = registry.totals[static_cast<size_t>(record->category)];
+  size_t& peak = registry.peaks[static_cast<size_t>(record->category)];
+  record->bytes += new_bytes - old_bytes;
+  record->peak = std::max(record->peak, record->bytes);
+  total += new_bytes - old_bytes;
+  peak = std::max(peak, total);
+}
+
+std::vector<const Record*> SortedRecords(const Registry& registry,
+                                         Category category, bool alive_only) {
+  std::vector<const Record*> records;
+  for (const auto& pair : registry.records) {
+    const Record& record = pair.second;
+    if (record.category == category &&
+        (!alive_only || record.allocations > 0)) {
+      records.push_back(&record);
+    }
+  }
+  std::sort(records.begin(), records.end(),
+            [](const Record* a, const Record* b) {
+    return a->bytes != b->bytes ? a->bytes > b->bytes : a->peak > b->peak;
+  });
+  return records;
+}
+
+}  // namespace
+
+MemoryTracker::Allocation::Allocation(const char* subsystem,
+                                      const std::string& owner,
+                                      Category category, size_t bytes) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  auto key = std::make_tuple(category, std::string{subsystem}, owner);
+  auto iter = registry.records.find(key);
+  if (iter == registry.records.end()) {
+    iter = registry.records.emplace(
+        key, Record{subsystem, owner, category, 0, 0, 0}).first;
+  }
+  record_ = &iter->second;
+  ++record_->allocations;
+  Resize(registry, record_, 0, bytes);
+  bytes_ = bytes;
+}
+
+MemoryTracker::Allocation::Allocation(const Allocation& other)
+    : record_(other.record_), bytes_(other.bytes_) {
+  if (record_) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    ++record_->allocations;
+    Resize(registry, record_, 0, bytes_);
+  }
+}
+
+MemoryTracker::Allocation::Allocation(Allocation&& other)
+    : record_(other.record_), bytes_(other.bytes_) {
+  other.record_ = nullptr;
+  other.bytes_ = 0;
+}
+
+MemoryTracker::Allocation&
+MemoryTracker::Allocation::operator=(Allocation other) {
+  std::swap(record_, other.record_);
+  std::swap(bytes_, other.bytes_);
+  return *this;
+}
+
+MemoryTracker::Allocation::~Allocation() {
+  if (record_) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    Resize(registry, record_, bytes_, 0);
+    --record_->allocations;
+  }
+}
+
+void MemoryTracker::Allocation::resize(size_t bytes) {
+  if (record_) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    Resize(registry, record_, bytes_, bytes);
+  }
+  bytes_ = bytes;
+}
+
+size_t MemoryTracker::total(Category category) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  return registry.totals[static_cast<size_t>(category)];
+}
+
+void MemoryTracker::Report(std::ostream& os) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  os << "Memory usage (current / peak):" << std::endl;
+  for (size_t i = 0; i < kNumCategories; ++i) {
+    Category category = static_cast<Category>(i);
+    os << "  " << CategoryName(category) << ": "
+       << Megabytes(registry.totals[i]) << " / "
+       << Megabytes(registry.peaks[i]) << std::endl;
+    for (const Record* record : SortedRecords(registry, category, false)) {
+      os << "    [" << record->subsystem << "] " << record->owner << ": "
+         << Megabytes(record->bytes) << " / " << Megabytes(record->peak)
+         << std::endl;
+    }
+  }
+}
+
+bool MemoryTracker::ReportAlive(std::ostream& os) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  bool found = false;
+  for (size_t i = 0; i < kNumCategories; ++i) {
+    Category category = static_cast<Category>(i);
+    for (const Record* record : SortedRecords(registry, category, true)) {
+      if (!found) {
+        os << "Memory still allocated:" << std::endl;
+        found = true;
+      }
+      os << "  " << CategoryName(category) << " [" << record->subsystem
+         << "] " << record->owner << ": " << Megabytes(record->bytes)
+         << " in " << record->allocations << " allocation(s)" << std::endl;
+    }
+  }
+  return found;
+}
+
+}  // namespace debug
+}  // namespace engine
@@ -0,0 +1,57 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_MEMORY_TRACKER_H_
+#define ENGINE_DEBUG_MEMORY_TRACKER_H_
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+namespace engine {
+namespace debug {
+
+// Accounts the big allocations of the engine (the CPU copies of the assets,
+// and the GL buffers and textures) by subsystem, owner and category. The
+// owners hold an Allocation for each of their blocks, which is accounted
+// for until its destruction. It is thread safe.
+class MemoryTracker {
+ public:
+  enum class Category { kCpu, kGpuBuffer, kGpuTexture };
+  struct Record;  // the usage of an owner, in a category
+
+  class Allocation {
+   public:
+    Allocation() = default;
+    // The subsystem must have a static lifetime (like a string literal).
+    Allocation(const char* subsystem, const std::string& owner,
+               Category category, size_t bytes = 0);
+    // A copy is a new allocation for the same owner (like copying the data).
+    Allocation(const Allocation& other);
+    Allocation(Allocation&& other);
+    Allocation& operator=(Allocation other);
+    ~Allocation();
+
+    size_t bytes() const { return bytes_; }
+    void resize(size_t bytes);
+    void add(size_t bytes) { resize(bytes_ + bytes); }
+
+   private:
+    Record* record_ = nullptr;
+    size_t bytes_ = 0;
+  };
+
+  static size_t total(Category category);
+
+  // Writes the current and the peak usage of every owner, grouped by
+  // category and subsystem, biggest first.
+  static void Report(std::ostream& os);
+
+  // Writes the allocations that are still alive (after the scene has been
+  // destroyed, these are the leaks). Returns false if there were none.
+  static bool ReportAlive(std::ostream& os);
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
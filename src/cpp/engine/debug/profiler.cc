@@ -0,0 +1,288 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+#ifdef __GNUG__
+  #include <cxxabi.h>
+#endif
+
+#include "./profiler.h"
+#include "../frame_arena.h"
+
+namespace engine {
+namespace debug {
+
+namespace {
+
+// An event in the ring buffer. The fields are atomics (written and read
+// with relaxed ordering, which are plain moves), so the other threads can
+// read a slot while its owner overwrites it without a data race.
+struct EventSlot {
+  std::atomic<const char*> name;
+  std::atomic<std::int64_t> begin, end;
+  std::atomic<unsigned> depth;
+};
+
+// The events of a thread. Only the owner thread writes it, the others can
+// read the first 'count' events, as a seqlock: the owner increments 'begun'
+// before it overwrites a slot, so a reader can drop the slots that were
+// (possibly) overwritten while it copied them.
+struct ThreadLog {
+  std::string name;
+  int id;
+  unsigned depth = 0;
+  std::unique_ptr<EventSlot[]> events;
+  const size_t capacity = Profiler::kEventsPerThread;
+  std::atomic<std::uint64_t> begun{0}, count{0};
+
+  explicit ThreadLog(int id)
+      : name("thread " + std::to_string(id)), id(id)
+      , events(new EventSlot[Profiler::kEventsPerThread]) {}
+};
+
+// The logs are never freed, so that they can be exported after their
+// thread has quit.
+std::mutex logs_mutex;
+std::vector<std::unique_ptr<ThreadLog>> logs;
+// The log is only created when the thread records its first event
+thread_local ThreadLog* current_log = nullptr;
+thread_local const char* current_thread_name = nullptr;
+
+ThreadLog* CurrentLog() {
+  if (!current_log) {
+    std::lock_guard<std::mutex> lock{logs_mutex};
+    logs.emplace_back(new ThreadLog(logs.size()));
+    current_log = logs.back().get();
+    if (current_thread_name) {
+      current_log->name = current_thread_name;
+    }
+  }
+  return current_log;
+}
+
+// Copies the events of a log that ended after 'since'.
+template<typename Container>
+void CopyEvents(const ThreadLog& log, std::int64_t since, Container* out) {
+  const size_t capacity = log.capacity;
+  const auto relaxed = std::memory_order_relaxed;
+  std::uint64_t count = log.count.load(std::memory_order_acquire);
+  std::uint64_t first = count > capacity ? count - capacity : 0;
+  size_t out_begin = out->size();
+  FrameVector<std::uint64_t> indices;
+  for (std::uint64_t i = first; i < count; ++i) {
+    const EventSlot& slot = log.events[i % capacity];
+    Profiler::Event event{slot.name.load(relaxed), slot.begin.load(relaxed),
+                          slot.end.load(relaxed), slot.depth.load(relaxed)};
+    if (event.end >= since) {
+      out->push_back(event);
+      indices.push_back(i);
+    }
+  }
+
+  // If a copied slot has been overwritten meanwhile, the fence makes sure
+  // that we see the owner's increment of 'begun' that preceded it.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  std::uint64_t begun = log.begun.load(relaxed);
+  std::uint64_t valid_from = begun > capacity ? begun - capacity : 0;
+  size_t overwritten =
+      std::lower_bound(indices.begin(), indices.end(), valid_from) -
+      indices.begin();
+  out->erase(out->begin() + out_begin,
+             out->begin() + out_begin + overwritten);
+}
+
+std::string JsonEscape(const std::string& str) {
+  std::string result;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+
+}  // namespace
+
+std::atomic<bool> Profiler::enabled_{false};
+std::atomic<bool> Profiler::object_scopes_{false};
+std::int64_t Profiler::frame_begin_ = 0;
+double Profiler::last_frame_time_ = 0;
+std::vector<double> Profiler::frame_times_;
+size_t Profiler::frame_count_ = 0;
+std::vector<Profiler::ScopeTime> Profiler::last_frame_scopes_;
+
+void Profiler::SetThreadName(const char* name) {
+  current_thread_name = name;
+  if (current_log) {
+    std::lock_guard<std::mutex> lock{logs_mutex};
+    current_log->name = name;
+  }
+}
+
+std::string Profiler::ReadableName(const char* name) {
+#ifdef __GNUG__
+  // Only the type names of the GameObject scopes are mangled
+  bool mangled = std::isdigit(name[0]) ||
+                 (name[0] == 'N' && std::isdigit(name[1]));
+  if (mangled) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+      std::string result{demangled};
+      std::free(demangled);
+      return result;
+    }
+  }
+#endif
+  return name;
+}
+
+std::int64_t Profiler::Now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char* name, std::int64_t begin, std::int64_t end,
+                      unsigned depth) {
+  ThreadLog* log = CurrentLog();
+  const auto relaxed = std::memory_order_relaxed;
+  std::uint64_t count = log->count.load(relaxed);
+  log->begun.store(count + 1, relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  EventSlot& slot = log->events[count % log->capacity];
+  slot.name.store(name, relaxed);
+  slot.begin.store(begin, relaxed);
+  slot.end.store(end, relaxed);
+  slot.depth.store(depth, relaxed);
+  log->count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::EndFrame() {
+  std::int64_t now = Now();
+  if (frame_begin_ != 0) {
+    last_frame_time_ = (now - frame_begin_) / 1e6;
+    if (frame_times_.size() < kFramesKept) {
+      frame_times_.push_back(last_frame_time_);
+    } else {
+      frame_times_[frame_count_ % kFramesKept] = last_frame_time_;
+    }
+    ++frame_count_;
+  }
+
+  last_frame_scopes_.clear();
+  if (enabled_ && frame_begin_ != 0) {
+    FrameVector<Event> events;
+    std::lock_guard<std::mutex> lock{logs_mutex};
+    for (const auto& log : logs) {
+      events.clear();
+      CopyEvents(*log, frame_begin_, &events);
+      // The inner scopes end first, so order them by their beginning
+      std::sort(events.begin(), events.end(),
+                [](const Event& a, const Event& b) {
+        return a.begin < b.begin;
+      });
+
+      size_t first_scope = last_frame_scopes_.size();
+      for (const Event& event : events) {
+        double ms = (std::min(event.end, now) -
+                     std::max(event.begin, frame_begin_)) / 1e6;
+        auto iter = std::find_if(
+            last_frame_scopes_.begin() + first_scope, last_frame_scopes_.end(),
+            [&event](const ScopeTime& scope) {
+          return scope.name == event.name && scope.depth == event.depth;
+        });
+        if (iter != last_frame_scopes_.end()) {
+          iter->ms += ms;
+        } else {
+          last_frame_scopes_.push_back(
+              ScopeTime{event.name, log->name.c_str(), event.depth, ms});
+        }
+      }
+    }
+  }
+
+  frame_begin_ = now;
+}
+
+Profiler::FramePercentiles Profiler::frame_percentiles() {
+  if (frame_times_.empty()) {
+    return FramePercentiles{0, 0, 0, 0};
+  }
+
+  std::vector<double> times = frame_times_;
+  auto percentile = [&times](double p) {
+    auto nth = times.begin() + static_cast<size_t>(p * (times.size() - 1));
+    std::nth_element(times.begin(), nth, times.end());
+    return *nth;
+  };
+  FramePercentiles result;
+  result.p50 = percentile(0.5);
+  result.p90 = percentile(0.9);
+  result.p99 = percentile(0.99);
+  result.max = *std::max_element(times.begin(), times.end());
+  return result;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) {
+  std::ofstream file{path};
+  if (!file) { return false; }
+
+  std::lock_guard<std::mutex> lock{logs_mutex};
+  std::int64_t start = std::numeric_limits<std::int64_t>::max();
+  std::vector<std::vector<Event>> events(logs.size());
+  for (size_t i = 0; i < logs.size(); ++i) {
+    CopyEvents(*logs[i], 0, &events[i]);
+    for (const Event& event : events[i]) {
+      start = std::min(start, event.begin);
+    }
+  }
+
+  file << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (size_t i = 0; i < logs.size(); ++i) {
+    if (!first) { file << ",\n"; }
+    first = false;
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << logs[i]->id << ",\"args\":{\"name\":\""
+         << JsonEscape(logs[i]->name) << "\"}}";
+
+    for (const Event& event : events[i]) {
+      // Chrome expects microseconds
+      file << ",\n{\"name\":\"" << JsonEscape(ReadableName(event.name))
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << logs[i]->id
+           << ",\"ts\":" << (event.begin - start) / 1e3
+           << ",\"dur\":" << (event.end - event.begin) / 1e3 << "}";
+    }
+  }
+  file << "\n]}\n";
+
+  return static_cast<bool>(file);
+}
+
+ScopedTimer::ScopedTimer(const char* name)
+    : name_(name), begin_(0), depth_(nullptr) {
+  if (name && Profiler::enabled_.load(std::memory_order_relaxed)) {
+    depth_ = &CurrentLog()->depth;
+    ++*depth_;
+    begin_ = Profiler::Now();
+  }
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (depth_) {
+    std::int64_t end = Profiler::Now();
+    --*depth_;
+    Profiler::Record(name_, begin_, end, *depth_);
+  }
+}
+
+}  // namespace debug
+}  // namespace engine
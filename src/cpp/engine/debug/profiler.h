@@ -0,0 +1,121 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_PROFILER_H_
+#define ENGINE_DEBUG_PROFILER_H_
+
+#include <atomic>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include <cstdint>
+
+namespace engine {
+namespace debug {
+
+// A low overhead CPU profiler for timed scopes (see ENGINE_PROFILE). Every
+// thread records into its own ring buffer, so the recording needs no locks.
+// The frame times are always recorded, the scopes only when it's enabled.
+class Profiler {
+ public:
+  struct Event {
+    const char* name;  // must have a static lifetime
+    std::int64_t begin, end;  // nanoseconds since the start of the program
+    unsigned depth;
+  };
+
+  // The total time spent in the scopes with the same name
+  // and depth on a thread in the last frame.
+  struct ScopeTime {
+    const char* name;
+    const char* thread;
+    unsigned depth;
+    double ms;
+  };
+
+  // In milliseconds, over the last kFramesKept frames.
+  struct FramePercentiles {
+    double p50, p90, p99, max;
+  };
+
+  static const size_t kEventsPerThread = 1 << 16;
+  static const size_t kFramesKept = 1024;
+
+  static bool enabled() { return enabled_; }
+  static void set_enabled(bool value) { enabled_ = value; }
+
+  // Adds a scope around the callbacks of every GameObject, named after its
+  // type. It is verbose, and it costs a bit more, so it's off by default.
+  static bool object_scopes_enabled() { return enabled_ && object_scopes_; }
+  static void set_object_scopes_enabled(bool value) { object_scopes_ = value; }
+
+  // The name of the calling thread in the overlay and the traces.
+  static void SetThreadName(const char* name);
+
+  // Demangles the type names of the GameObject scopes.
+  static std::string ReadableName(const char* name);
+
+  static std::int64_t Now();
+  static void Record(const char* name, std::int64_t begin, std::int64_t end,
+                     unsigned depth);
+
+  // Main thread only
+  static void EndFrame();
+  static FramePercentiles frame_percentiles();
+  static double last_frame_time() { return last_frame_time_; }
+  static const std::vector<ScopeTime>& last_frame_scopes() {
+    return last_frame_scopes_;
+  }
+
+  // Writes the recorded events of every thread in Chrome's trace event
+  // format (chrome://tracing). Returns false if the file can't be written.
+  static bool WriteChromeTrace(const std::string& path);
+
+ private:
+  static std::atomic<bool> enabled_, object_scopes_;
+  static std::int64_t frame_begin_;
+  static double last_frame_time_;
+  static std::vector<double> frame_times_;
+  static size_t frame_count_;
+  static std::vector<ScopeTime> last_frame_scopes_;
+
+  friend class ScopedTimer;
+};
+
+// Records the time between its construction and destruction.
+// It does nothing if the name is nullptr.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(const char* name);
+  ~ScopedTimer();
+
+ private:
+  const char* name_;
+  std::int64_t begin_;
+  unsigned* depth_;
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#define ENGINE_PROFILE_CONCAT_(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope. The name must be a string literal.
+// ENGINE_PROFILE_OBJECT times it under the type name of *this, if the
+// GameObject scopes are enabled.
+#if ENGINE_NO_PROFILER
+  #define ENGINE_PROFILE(name)
+  #define ENGINE_PROFILE_OBJECT()
+#else
+  #define ENGINE_PROFILE(name) \
+    ::engine::debug::ScopedTimer ENGINE_PROFILE_CONCAT(profile_scope_, \
+                                                       __LINE__){name}
+  #define ENGINE_PROFILE_OBJECT() \
+    ENGINE_PROFILE(::engine::debug::Profiler::object_scopes_enabled() ? \
+                   typeid(*this).name() : nullptr)
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_PROFILER_OVERLAY_H_
+#define ENGINE_DEBUG_PROFILER_OVERLAY_H_
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "../behaviour.h"
+#include "../gui/label.h"
+#include "./profiler.h"
+
+namespace engine {
+namespace debug {
+
+// Shows the frame time percentiles, and the scopes of the last frame.
+// F3 toggles the profiler (and the overlay), F4 the GameObject scopes,
+// F5 writes the recorded events to profiler_trace.json.
+class ProfilerOverlay : public Behaviour {
+ public:
+  explicit ProfilerOverlay(GameObject* parent) : Behaviour(parent) {
+    for (size_t i = 0; i < labels_.size(); ++i) {
+      labels_[i] = addComponent<gui::Label>(
+          L"", glm::vec2{-0.98f, 0.9f - 0.04f*i},
+          gui::Font{"src/resources/fonts/Vera.ttf", 14,
+                    glm::vec4(1, 1, 0, 1)});
+      labels_[i]->set_horizontal_alignment(
+          gui::Font::HorizontalAlignment::kLeft);
+      labels_[i]->set_enabled(false);
+    }
+  }
+
+ private:
+  static constexpr float kRefreshInterval = 0.25f;
+  std::array<gui::Label*, 20> labels_;
+  double time_since_refresh_ = 0;
+
+  virtual void update() override {
+    if (!Profiler::enabled()) { return; }
+
+    time_since_refresh_ += scene_->camera_time().dt;
+    if (time_since_refresh_ < kRefreshInterval) { return; }
+    time_since_refresh_ = 0;
+
+    char line[128];
+    Profiler::FramePercentiles frames = Profiler::frame_percentiles();
+    std::snprintf(line, sizeof(line),
+                  "frame: %.2f ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f",
+                  Profiler::last_frame_time(), frames.p50, frames.p90,
+                  frames.p99, frames.max);
+    setLine(0, line);
+
+    size_t i = 1;
+    for (const auto& scope : Profiler::last_frame_scopes()) {
+      if (i == labels_.size()) { break; }
+      std::string indent(2*scope.depth, ' ');
+      std::snprintf(line, sizeof(line), "%s: %s%s %.3f ms", scope.thread,
+                    indent.c_str(),
+                    Profiler::ReadableName(scope.name).c_str(), scope.ms);
+      setLine(i++, line);
+    }
+    for (; i < labels_.size(); ++i) {
+      setLine(i, "");
+    }
+  }
+
+  virtual void keyAction(int key, int scancode, int action, int mods) override {
+    if (action != GLFW_PRESS) { return; }
+    if (key == GLFW_KEY_F3) {
+      bool enabled = !Profiler::enabled();
+      Profiler::set_enabled(enabled);
+      for (gui::Label* label : labels_) {
+        label->set_enabled(enabled);
+      }
+    } else if (key == GLFW_KEY_F4) {
+      Profiler::set_object_scopes_enabled(!Profiler::object_scopes_enabled());
+    } else if (key == GLFW_KEY_F5) {
+      if (Profiler::WriteChromeTrace("profiler_trace.json")) {
+        std::cout << "Profiler trace written to profiler_trace.json"
+                  << std::endl;
+      } else {
+        std::cerr << "Couldn't write profiler_trace.json" << std::endl;
+      }
+    }
+  }
+
+  void setLine(size_t i, const std::string& text) {
+    labels_[i]->set_text(std::wstring(text.begin(), text.end()));
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
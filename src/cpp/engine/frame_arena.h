@@ -0,0 +1,158 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_FRAME_ARENA_H_
+#define ENGINE_FRAME_ARENA_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+// A linear allocator for the transient data of a frame: an allocation only
+// bumps a pointer, and the memory is freed all at once. Every thread has its
+// own arena (see ThisThread()), so it needs no locking. The main thread's
+// arena is reset at the end of every Scene::turn(), the ThreadPool's workers
+// put a Scope around every job, and the other threads should put a Scope
+// around their work. After the first few frames an arena has a single block,
+// that is big enough for a whole frame, so it makes no heap allocations at
+// all (RunHeadless counts them, see AllocationCounter).
+class FrameArena {
+ public:
+  static const size_t kMinBlockSize = 64 * 1024;
+
+  FrameArena() = default;
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  static FrameArena& ThisThread() {
+    static thread_local FrameArena arena;
+    return arena;
+  }
+
+  // The alignment must be a power of two.
+  void* allocate(size_t size,
+                 size_t alignment = alignof(std::max_align_t)) {
+    while (current_ < blocks_.size()) {
+      Block& block = blocks_[current_];
+      std::uintptr_t address =
+          reinterpret_cast<std::uintptr_t>(block.data.get()) + used_;
+      size_t offset = used_ + (-address & (alignment - 1));
+      if (offset + size <= block.size) {
+        used_ = offset + size;
+        return block.data.get() + offset;
+      }
+      // Go on with the next block (if a rewind left one there)
+      ++current_;
+      used_ = 0;
+    }
+
+    size_t block_size = 2*size + alignment;
+    if (block_size < kMinBlockSize) { block_size = kMinBlockSize; }
+    blocks_.push_back(Block{std::unique_ptr<char[]>{new char[block_size]},
+                            block_size});
+    current_ = blocks_.size() - 1;
+    used_ = 0;
+    return allocate(size, alignment);
+  }
+
+  template<typename T>
+  T* allocate_array(size_t count) {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // Frees everything that has been allocated from the arena. If the frame
+  // needed more than one block, they are merged into one, so that the next
+  // frame fits into it.
+  void reset() {
+    if (blocks_.size() > 1) {
+      size_t total_size = 0;
+      for (const Block& block : blocks_) { total_size += block.size; }
+      blocks_.clear();
+      blocks_.push_back(Block{std::unique_ptr<char[]>{new char[total_size]},
+                              total_size});
+    }
+    current_ = 0;
+    used_ = 0;
+  }
+
+  // The memory reserved by the arena.
+  size_t capacity() const {
+    size_t sum = 0;
+    for (const Block& block : blocks_) { sum += block.size; }
+    return sum;
+  }
+
+  // Frees what has been allocated from the arena of the current thread in
+  // its lifetime.
+  class Scope {
+   public:
+    Scope() : arena_(ThisThread())
+            , current_(arena_.current_), used_(arena_.used_) {}
+    ~Scope() {
+      arena_.current_ = current_;
+      arena_.used_ = used_;
+    }
+
+   private:
+    FrameArena& arena_;
+    size_t current_, used_;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  std::vector<Block> blocks_;
+  size_t current_ = 0;  // the index of the block that is being filled
+  size_t used_ = 0;  // in the current block
+};
+
+// Allocates the elements of the standard containers from a FrameArena (the
+// calling thread's by default). The memory is only freed by the arena.
+template<typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  template<typename U>
+  struct rebind { using other = ArenaAllocator<U>; };
+
+  ArenaAllocator() : arena_(&FrameArena::ThisThread()) {}
+  explicit ArenaAllocator(FrameArena* arena) : arena_(arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) { return arena_->allocate_array<T>(n); }
+  void deallocate(T*, size_t) {}
+
+  FrameArena* arena() const { return arena_; }
+
+  template<typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template<typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  FrameArena* arena_;
+};
+
+// Containers for the data that only lives until the end of the frame.
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+using FrameString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+}  // namespace engine
+
+#endif
@@ -1,12 +1,21 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include <string>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
 
 #include "./oglwrap_config.h"
 #include <GLFW/glfw3.h>
 
 #include "../oglwrap/smart_enums.h"
+#include "./clock.h"
 #include "./game_engine.h"
+#include "./debug/gl_stats.h"
+#include "./debug/allocation_counter.h"
 
 static double last_debug_time = 0;
 
@@ -25,12 +34,104 @@ static void GlInit() {
   gl::Hint(gl::kTextureCompressionHint, gl::kFastest);
 }
 
+// Writes the back buffer into a binary PPM file.
+static bool DumpFrame(const std::string& path, int width, int height) {
+  std::vector<unsigned char> pixels(size_t(width) * height * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+  std::ofstream file{path, std::ios::binary};
+  if (!file) { return false; }
+  file << "P6\n" << width << ' ' << height << "\n255\n";
+  // OpenGL stores the rows bottom up
+  for (int y = height - 1; y >= 0; --y) {
+    file.write(reinterpret_cast<const char*>(&pixels[size_t(y) * width * 3]),
+               width * 3);
+  }
+  return bool(file);
+}
+
+// The nearest-rank percentile of the (sorted) values
+static double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) { return 0; }
+  return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+}
+
+// The cost of a profiled scope over a headless run.
+struct PhaseCost {
+  const char* name;
+  std::string thread;
+  unsigned depth;
+  double total_ms, max_ms;
+};
+
+// Adds the scopes of the last frame to the phases.
+static void AddLastFrameScopes(std::vector<PhaseCost>* phases) {
+  using engine::debug::Profiler;
+  for (const Profiler::ScopeTime& scope : Profiler::last_frame_scopes()) {
+    auto iter = std::find_if(phases->begin(), phases->end(),
+                             [&scope](const PhaseCost& phase) {
+      return phase.name == scope.name && phase.depth == scope.depth &&
+             phase.thread == scope.thread;
+    });
+    if (iter == phases->end()) {
+      phases->push_back(PhaseCost{scope.name, scope.thread, scope.depth, 0, 0});
+      iter = phases->end() - 1;
+    }
+    iter->total_ms += scope.ms;
+    iter->max_ms = std::max(iter->max_ms, scope.ms);
+  }
+}
+
+// Writes the frame time percentiles, and the mean and max cost per frame of
+// every phase as JSON.
+static bool WriteSummary(const engine::GameEngine::HeadlessRun& run,
+                         int width, int height,
+                         const std::vector<double>& sorted_frame_times,
+                         const std::vector<PhaseCost>& phases) {
+  std::ofstream file{run.summary_path};
+  if (!file) { return false; }
+
+  const std::vector<double>& sorted = sorted_frame_times;
+  size_t frames = sorted.size();
+  double total = 0;
+  for (double ms : sorted) { total += ms; }
+  file << "{\n  \"label\": \"" << run.label << "\",\n"
+       << "  \"width\": " << width << ", \"height\": " << height
+       << ", \"frames\": " << frames << ", \"dt\": " << run.dt << ",\n"
+       << "  \"frame_ms\": {\"mean\": " << (frames ? total / frames : 0)
+       << ", \"p50\": " << Percentile(sorted, 0.5)
+       << ", \"p90\": " << Percentile(sorted, 0.9)
+       << ", \"p99\": " << Percentile(sorted, 0.99)
+       << ", \"max\": " << Percentile(sorted, 1.0) << "},\n"
+       << "  \"phases\": [";
+  for (size_t i = 0; i < phases.size(); ++i) {
+    const PhaseCost& phase = phases[i];
+    file << (i ? ",\n" : "\n") << "    {\"thread\": \"" << phase.thread
+         << "\", \"name\": \"" << phase.name << "\", \"depth\": "
+         << phase.depth << ", \"mean_ms\": "
+         << (frames ? phase.total_ms / frames : 0)
+         << ", \"max_ms\": " << phase.max_ms << "}";
+  }
+  file << "\n  ]\n}\n";
+  return bool(file);
+}
+
 namespace engine {
 
 Scene *GameEngine::scene_ = nullptr;
 Scene *GameEngine::new_scene_ = nullptr;
+std::future<Scene*> GameEngine::loading_scene_;
+Scene *GameEngine::loaded_scene_ = nullptr;
+std::vector<std::future<Scene*>> GameEngine::abandoned_scenes_;
+std::shared_ptr<std::atomic<float>> GameEngine::construction_progress_;
+thread_local std::atomic<float>* GameEngine::reported_progress_ = nullptr;
+double GameEngine::loading_budget_ = 4.0;
 GLFWwindow *GameEngine::window_ = nullptr;
 ShaderManager *GameEngine::shader_manager_ = new ShaderManager{};
+ThreadPool *GameEngine::thread_pool_ = new ThreadPool{};
+AssetCache *GameEngine::asset_cache_ = new AssetCache{};
 
 void GameEngine::InitContext() {
   PrintDebugText("Creating the OpenGL context");
@@ -50,14 +151,37 @@ void GameEngine::InitContext() {
     window_ = glfwCreateWindow(vidmode->width, vidmode->height,
                                "Land of Dreams", monitor, nullptr);
 #endif
+  PrintDebugTime();
 
-    if (!window_) {
-      std::cerr << "FATAL: Couldn't create a glfw window. Aborting now." << std::endl;
-      glfwTerminate();
+  SetupContext();
+}
+
+void GameEngine::InitHeadlessContext(int width, int height) {
+  PrintDebugText("Creating the headless OpenGL context");
+    glfwSetErrorCallback(ErrorCallback);
+
+    if (!glfwInit()) {
       std::terminate();
     }
+
+    // GLFW 3.1 can only create contexts with windows, so this one is never
+    // shown. Without a display, run it under Xvfb (Mesa's llvmpipe is fine).
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    window_ = glfwCreateWindow(width, height, "Land of Dreams",
+                               nullptr, nullptr);
   PrintDebugTime();
 
+  SetupContext();
+}
+
+void GameEngine::SetupContext() {
+  if (!window_) {
+    std::cerr << "FATAL: Couldn't create a glfw window. Aborting now." << std::endl;
+    glfwTerminate();
+    std::terminate();
+  }
+
   // Check the created OpenGL context's version
   int ogl_major_version = glfwGetWindowAttrib(window_, GLFW_CONTEXT_VERSION_MAJOR);
   int ogl_minor_version = glfwGetWindowAttrib(window_, GLFW_CONTEXT_VERSION_MINOR);
@@ -81,6 +205,8 @@ void GameEngine::InitContext() {
     std::terminate();
   }
   gl::GetError();
+  // Has to see the function pointers that glewInit loaded
+  debug::GlStats::InstallHooks();
 
   // No V-sync needed.
   glfwSwapInterval(0);
@@ -95,21 +221,222 @@ void GameEngine::InitContext() {
   glfwSetCursorPosCallback(window_, MouseMoved);
 }
 
-void GameEngine::Run() {
+void GameEngine::Run(double simulated_dt) {
+  debug::Profiler::SetThreadName("main");
+  if (simulated_dt) {
+    Clock::Simulate();
+  }
   while (!glfwWindowShouldClose(window_)) {
-    if (new_scene_) {
-      delete scene_;
-      scene_ = new_scene_;
-      new_scene_ = nullptr;
+    LoadNewScene();
+    if (simulated_dt) {
+      Clock::Advance(simulated_dt);
     }
     gl::Clear().Color().Depth();
     scene_->turn();
+    ContinueLoading();
+    EndFrame();
+  }
 
-    glfwSwapBuffers(window_);
-    glfwPollEvents();
+  Destroy();
+}
+
+void GameEngine::RunHeadless(const HeadlessRun& run) {
+  using WallClock = std::chrono::steady_clock;
+  debug::Profiler::SetThreadName("main");
+  Clock::Simulate();
+
+  if (run.check_allocations && !debug::AllocationCounter::enabled()) {
+    throw std::runtime_error("Checking the allocations needs a build "
+                             "without ENGINE_NO_PROFILER");
+  }
+
+  std::vector<PhaseCost> phases;
+  if (!run.summary_path.empty()) {
+    debug::Profiler::set_enabled(true);
+  }
+
+  std::ofstream timings;
+  if (!run.timings_path.empty()) {
+    timings.open(run.timings_path);
+    if (timings) {
+      timings << "frame,frame_ms\n";
+    } else {
+      std::cerr << "Couldn't open " << run.timings_path << std::endl;
+    }
+  }
+
+  int width, height;
+  glfwGetFramebufferSize(window_, &width, &height);
+  std::vector<double> frame_times;
+  frame_times.reserve(run.frames);
+  size_t steady_allocations = 0, allocating_frames = 0;
+  for (size_t frame = 0; frame < run.frames; ++frame) {
+    if (glfwWindowShouldClose(window_)) { break; }
+    WallClock::time_point begin = WallClock::now();
+    LoadNewScene();
+    Clock::Advance(run.dt);
+    gl::Clear().Color().Depth();
+    size_t allocations = debug::AllocationCounter::ThisThread();
+    scene_->turn();
+    allocations = debug::AllocationCounter::ThisThread() - allocations;
+    if (frame >= run.warmup_frames && allocations) {
+      steady_allocations += allocations;
+      ++allocating_frames;
+    }
+    ContinueLoading();
+    // Wait for the GPU too, so that the frame times contain the rendering.
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(
+        WallClock::now() - begin).count();
+    frame_times.push_back(ms);
+    if (timings.is_open()) {
+      timings << frame << ',' << ms << '\n';
+    }
+
+    if (run.dump_interval && frame % run.dump_interval == 0) {
+      char number[16];
+      std::snprintf(number, sizeof(number), "%05zu", frame);
+      std::string path = run.dump_prefix + number + ".ppm";
+      if (!DumpFrame(path, width, height)) {
+        std::cerr << "Couldn't write " << path << std::endl;
+      }
+    }
+    EndFrame();
+    AddLastFrameScopes(&phases);
+  }
+
+  std::vector<double> sorted = frame_times;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0;
+  for (double ms : frame_times) { total += ms; }
+  std::cout << "Headless run: " << frame_times.size() << " frames at "
+            << width << " x " << height << ", " << run.dt * 1000
+            << " ms simulated per frame" << std::endl
+            << " - frame time (ms): mean "
+            << (frame_times.empty() ? 0 : total / frame_times.size())
+            << ", p50 " << Percentile(sorted, 0.5)
+            << ", p90 " << Percentile(sorted, 0.9)
+            << ", p99 " << Percentile(sorted, 0.99)
+            << ", max " << Percentile(sorted, 1.0) << std::endl;
+  if (debug::AllocationCounter::enabled()) {
+    std::cout << " - heap allocations after " << run.warmup_frames
+              << " frames: " << steady_allocations << " in "
+              << allocating_frames << " frames" << std::endl;
+  }
+
+  if (!run.summary_path.empty() &&
+      !WriteSummary(run, width, height, sorted, phases)) {
+    std::cerr << "Couldn't write " << run.summary_path << std::endl;
+  }
+
+  if (run.check_allocations && steady_allocations) {
+    throw std::runtime_error("The steady state frames have allocated on the "
+                             "heap (see FrameArena)");
+  }
+
+  Destroy();
+}
+
+void GameEngine::LoadNewScene() {
+  if (new_scene_) {
+    ENGINE_PROFILE("load scene");
+    DeleteScene(scene_);
+    scene_ = new_scene_;
+    new_scene_ = nullptr;
+    // What only the old scene has used
+    asset_cache_->collect();
+  }
+}
+
+void GameEngine::AbandonLoading(const char* replacement) {
+  if (!loading()) { return; }
+  if (replacement) {
+    std::cerr << replacement << " replaces the scene that is being loaded"
+              << std::endl;
+  }
+  if (loading_scene_.valid()) {
+    abandoned_scenes_.push_back(std::move(loading_scene_));
+  }
+  DeleteScene(loaded_scene_);
+  loaded_scene_ = nullptr;
+  construction_progress_ = nullptr;
+}
+
+void GameEngine::ContinueLoading() {
+  for (auto iter = abandoned_scenes_.begin();
+       iter != abandoned_scenes_.end();) {
+    if (iter->wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++iter;
+      continue;
+    }
+    try {
+      DeleteScene(iter->get());
+    } catch(const std::exception& err) {
+      // Nothing waits for it anymore
+      std::cerr << "An abandoned scene has failed to load:\n" << err.what()
+                << std::endl;
+    }
+    iter = abandoned_scenes_.erase(iter);
   }
 
+  if (loading_scene_.valid()) {
+    if (loading_scene_.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return;
+    }
+    try {
+      loaded_scene_ = loading_scene_.get();
+      construction_progress_ = nullptr;
+    } catch(const std::exception& err) {
+      SceneLoadingFailed(err);
+    }
+  }
+
+  if (loaded_scene_) {
+    ENGINE_PROFILE("scene upload");
+    bool done = false;
+    try {
+      done = loaded_scene_->upload_queue().run(loading_budget_);
+    } catch(const std::exception& err) {
+      SceneLoadingFailed(err);
+    }
+    if (done) {
+      // It replaces the current scene at the beginning of the next frame.
+      // A LoadScene since the request would have abandoned this, so the
+      // waiting scene has been requested earlier.
+      if (new_scene_) {
+        std::cerr << typeid(*loaded_scene_).name() << " replaces "
+                  << typeid(*new_scene_).name() << ", before it has started"
+                  << std::endl;
+      }
+      DeleteScene(new_scene_);
+      new_scene_ = loaded_scene_;
+      loaded_scene_ = nullptr;
+    }
+  }
+}
+
+void GameEngine::SceneLoadingFailed(const std::exception& err) {
+  std::cerr << "Unable to load scene:\n" << err.what() << std::endl;
+  std::cerr << "Stopping now." << std::endl;
   Destroy();
+  std::terminate();
+}
+
+void GameEngine::EndFrame() {
+  {
+    ENGINE_PROFILE("swap buffers");
+    glfwSwapBuffers(window_);
+  }
+  {
+    ENGINE_PROFILE("poll events");
+    // The input callbacks might modify the physics world.
+    auto physics_lock = scene_->lockPhysics();
+    Input::PollEvents();
+  }
+  debug::Profiler::EndFrame();
+  debug::GlStats::EndFrame();
 }
 
 void GameEngine::KeyCallback(GLFWwindow* window, int key, int scancode,
@@ -119,6 +446,9 @@ void GameEngine::KeyCallback(GLFWwindow* window, int key, int scancode,
       case GLFW_KEY_ESCAPE:
         glfwSetWindowShouldClose(window, GL_TRUE);
         break;
+      case GLFW_KEY_F8:
+        debug::MemoryTracker::Report(std::cout);
+        break;
       case GLFW_KEY_F11: {
         static bool fix_mouse = false;
         fix_mouse = !fix_mouse;
@@ -134,7 +464,7 @@ void GameEngine::KeyCallback(GLFWwindow* window, int key, int scancode,
     }
   }
 
-  scene_->keyActionAll(key, scancode, action, mods);
+  Input::KeyAction(key, scancode, action, mods);
 }
 
 }  // namespace engine
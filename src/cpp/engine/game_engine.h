@@ -3,8 +3,22 @@
 #ifndef ENGINE_GAME_ENGINE_H_
 #define ENGINE_GAME_ENGINE_H_
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <vector>
 #include <typeinfo>
+#include <functional>
+#include <type_traits>
+#include "./clock.h"
+#include "./input.h"
 #include "./scene.h"
+#include "./thread_pool.h"
+#include "./asset_cache.h"
+#include "./debug/memory_tracker.h"
 
 // #define ENGINE_NO_FULLSCREEN 1
 
@@ -17,48 +31,238 @@ class GameEngine {
   // Initializes the OpenGL context
   static void InitContext();
 
+  // Initializes an OpenGL context with an invisible window of the given size
+  static void InitHeadlessContext(int width, int height);
+
   static void Destroy() {
-    delete scene_;
-    delete new_scene_;
+    debug::MemoryTracker::Report(std::cout);
+    DeleteScene(scene_);
+    DeleteScene(new_scene_);
+    AbandonLoading();
+    for (std::future<Scene*>& scene : abandoned_scenes_) {
+      try {
+        DeleteScene(scene.get());
+      } catch(const std::exception&) {}
+    }
+    abandoned_scenes_.clear();
+    // The assets might hold GL objects, they have to die with the context
+    asset_cache_->clear();
+    // Everything that the scenes owned should have been freed by now
+    debug::MemoryTracker::ReportAlive(std::cerr);
     glfwDestroyWindow(window_);
     glfwTerminate();
   }
 
   // Replaces the current scene with a new one, of the specified type.
-  template <typename Scene_t>
-  static void LoadScene() {
+  // The arguments are forwarded to the scene's constructor. The last request
+  // wins: it drops the scenes that earlier requests are loading.
+  template <typename Scene_t, typename... Args>
+  static void LoadScene(Args&&... args) {
     static_assert(std::is_base_of<Scene, Scene_t>::value,
                   "The given template type is not a Scene");
 
+    AbandonLoading(typeid(Scene_t).name());
+    if (new_scene_) {
+      std::cerr << typeid(Scene_t).name() << " replaces "
+                << typeid(*new_scene_).name() << ", before it has started"
+                << std::endl;
+      DeleteScene(new_scene_);
+      new_scene_ = nullptr;
+    }
     try {
-      new_scene_ = new Scene_t();
+      new_scene_ = new Scene_t(std::forward<Args>(args)...);
+      new_scene_->upload_queue().runAll();
     } catch(const std::exception& err) {
-      std::cerr << "Unable to load scene:\n" << err.what() << std::endl;
-      std::cerr << "Stopping now." << std::endl;
-      Destroy();
-      std::terminate();
+      SceneLoadingFailed(err);
     }
   }
 
+  // Builds a new scene of the specified type on the thread pool, while the
+  // current scene keeps running, then replaces the current scene with it.
+  // The constructor must not use the context: it has to record its GL work
+  // into the scene's upload_queue(), that the main thread runs for at most
+  // loading_budget() ms per frame. The arguments are copied. If a scene is
+  // being loaded already, it is dropped (the last request wins). It is
+  // synchronous in the deterministic mode (see deterministic()).
+  template <typename Scene_t, typename... Args>
+  static void LoadSceneAsync(Args&&... args) {
+    static_assert(std::is_base_of<Scene, Scene_t>::value,
+                  "The given template type is not a Scene");
+
+    // The replays have to see the same frames, however long the loading takes
+    if (deterministic()) {
+      LoadScene<Scene_t>(std::forward<Args>(args)...);
+      return;
+    }
+    AbandonLoading(typeid(Scene_t).name());
+    auto progress = std::make_shared<std::atomic<float>>(0.0f);
+    construction_progress_ = progress;
+    loading_scene_ = thread_pool_->enqueue(std::bind(
+        [progress](typename std::decay<Args>::type&... args) -> Scene* {
+          ProgressReporting reporting{progress.get()};
+          return new Scene_t(std::move(args)...);
+        }, std::forward<Args>(args)...));
+  }
+
+  // If a scene is being loaded by LoadSceneAsync.
+  static bool loading() {
+    return loading_scene_.valid() || loaded_scene_ != nullptr;
+  }
+
+  // The progress of the scene that is being loaded, in [0, 1]. The first half
+  // is its construction (see ReportLoadingProgress), the second half is its
+  // upload queue.
+  static float loading_progress() {
+    if (loaded_scene_) {
+      return 0.5f + 0.5f * loaded_scene_->upload_queue().progress();
+    }
+    return construction_progress_ ? 0.5f * construction_progress_->load()
+                                  : 0.0f;
+  }
+
+  // The constructor of a scene that LoadSceneAsync builds can report how far
+  // it is, in [0, 1]. It does nothing on the other threads.
+  static void ReportLoadingProgress(float progress) {
+    if (reported_progress_) { *reported_progress_ = progress; }
+  }
+
+  // The time the main thread may spend on the GL work of the scene that is
+  // being loaded, per frame.
+  static double loading_budget() { return loading_budget_; }
+  static void set_loading_budget(double ms) { loading_budget_ = ms; }
+
   static Scene* scene() { return scene_; }
 
+  // In the deterministic mode (with a simulated Clock, or while the input is
+  // recorded or replayed) the scenes step their physics on the main thread,
+  // right after update, instead of on their physics thread. That way every
+  // frame sees the same number of physics steps, independently of the
+  // timing of the threads.
+  static bool deterministic() {
+    return Clock::simulated() || Input::recording() || Input::replaying();
+  }
+
   static GLFWwindow* window() { return window_; }
 
   static ShaderManager* shader_manager() { return shader_manager_; }
 
+  // Worker threads for the background jobs of the engine
+  static ThreadPool* thread_pool() { return thread_pool_; }
+
+  // The assets shared between the objects and the scenes. The unused ones
+  // are collected when a new scene replaces the current one.
+  static AssetCache* asset_cache() { return asset_cache_; }
+
   static glm::vec2 window_size() {
+    if (!window()) { return glm::vec2(0); }  // headless (benchmarks)
     int width, height;
     glfwGetWindowSize(window(), &width, &height);
     return glm::vec2(width, height);
   }
 
-  static void Run();
+  // If simulated_dt isn't zero, then every frame advances the simulated Clock
+  // by it, instead of following the wall clock (see deterministic()).
+  static void Run(double simulated_dt = 0);
+
+  // The settings of RunHeadless.
+  struct HeadlessRun {
+    size_t frames = 600;
+    double dt = 1.0 / 60.0;  // the simulated time of a frame, in seconds
+    std::string timings_path;  // writes the frame times as CSV, if not empty
+    // Every dump_interval-th frame is written to <dump_prefix><frame>.ppm
+    std::string dump_prefix = "frame_";
+    size_t dump_interval = 0;
+    // Writes a JSON summary of the frame times and the cost of the profiled
+    // phases (this enables the Profiler), if not empty.
+    std::string summary_path;
+    std::string label;  // identifies the run in the summary
+    // The turns after the first warmup_frames should make no heap
+    // allocations on the main thread (see FrameArena). They are counted, and
+    // if check_allocations is set, the run throws if there were any.
+    size_t warmup_frames = 60;
+    bool check_allocations = false;
+  };
+
+  // Runs the scene for a fixed number of frames, with a fixed dt (see Clock),
+  // then prints the frame time percentiles. The run is deterministic (see
+  // deterministic()), so the frames of two runs are comparable one by one.
+  // Needs InitHeadlessContext.
+  static void RunHeadless(const HeadlessRun& run);
+
+  // Runs 'instances' simulation-only scenes (see Scene::SimulationOnly) in
+  // parallel on the thread pool, each for 'frames' frames of 'dt' seconds,
+  // then prints the throughput. It doesn't need a context.
+  template <typename Scene_t>
+  static void RunSimulations(size_t instances, size_t frames, double dt) {
+    static_assert(std::is_base_of<Scene, Scene_t>::value,
+                  "The given template type is not a Scene");
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point begin = Clock::now();
+    std::vector<std::future<void>> simulations;
+    for (size_t i = 0; i < instances; ++i) {
+      simulations.push_back(thread_pool_->enqueue([frames, dt]() {
+        auto scene = make_unique<Scene_t>();
+        for (size_t frame = 0; frame < frames; ++frame) {
+          scene->simulate(dt);
+        }
+      }));
+    }
+    for (auto& simulation : simulations) {
+      simulation.get();  // rethrows the exceptions of the simulation
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::cout << "Simulated " << instances << " x " << frames << " frames in "
+              << seconds << " s (" << instances * frames / seconds
+              << " frames/s on " << thread_pool_->size() << " threads)"
+              << std::endl;
+  }
 
  private:
   static Scene *scene_;
   static Scene *new_scene_;
+  static std::future<Scene*> loading_scene_;  // being constructed
+  static Scene *loaded_scene_;  // constructed, its GL work is being run
+  // The constructions that a later request has replaced. They can't be
+  // interrupted, so their scenes are deleted when they are done.
+  static std::vector<std::future<Scene*>> abandoned_scenes_;
+  static std::shared_ptr<std::atomic<float>> construction_progress_;
+  // Where ReportLoadingProgress writes on this thread.
+  static thread_local std::atomic<float>* reported_progress_;
+  static double loading_budget_;
   static GLFWwindow *window_;
   static ShaderManager *shader_manager_;
+  static ThreadPool *thread_pool_;
+  static AssetCache *asset_cache_;
+
+  // The parts of the context creation that don't depend on the window
+  static void SetupContext();
+
+  // Stops the scene's physics thread before the derived scene dies.
+  static void DeleteScene(Scene* scene) {
+    if (scene) {
+      scene->shutdown();
+      delete scene;
+    }
+  }
+
+  // Sets where the current thread reports the progress, while it lives.
+  struct ProgressReporting {
+    explicit ProgressReporting(std::atomic<float>* progress) {
+      reported_progress_ = progress;
+    }
+    ~ProgressReporting() { reported_progress_ = nullptr; }
+  };
+
+  // Drops the scene that LoadSceneAsync is loading (if there is one), and
+  // logs that the given scene replaces it.
+  static void AbandonLoading(const char* replacement = nullptr);
+
+  static void LoadNewScene();
+  static void ContinueLoading();
+  static void SceneLoadingFailed(const std::exception& err);
+  static void EndFrame();
 
   // Callbacks
   static void ErrorCallback(int error, const char* message) {
@@ -69,7 +273,7 @@ class GameEngine {
                           int action, int mods);
 
   static void CharCallback(GLFWwindow* window, unsigned codepoint) {
-    scene_->charTypedAll(codepoint);
+    Input::CharTyped(codepoint);
   }
 
   static void ScreenResizeCallback(GLFWwindow* window, int width, int height) {
@@ -79,16 +283,16 @@ class GameEngine {
 
   static void MouseScrolledCallback(GLFWwindow* window, double xoffset,
                                     double yoffset) {
-    scene_->mouseScrolledAll(xoffset, yoffset);
+    Input::MouseScrolled(xoffset, yoffset);
   }
 
   static void MouseButtonPressed(GLFWwindow* window, int button,
                                  int action, int mods) {
-    scene_->mouseButtonPressedAll(button, action, mods);
+    Input::MouseButtonPressed(button, action, mods);
   }
 
   static void MouseMoved(GLFWwindow* window,  double xpos, double ypos) {
-    scene_->mouseMovedAll(xpos, ypos);
+    Input::MouseMoved(xpos, ypos);
   }
 };
 
@@ -12,7 +12,7 @@ template<typename Transform_t>
 GameObject::GameObject(GameObject* parent, const Transform_t& transform)
     : scene_(parent ? parent->scene_ : nullptr), parent_(parent)
     , transform_(new Transform_t{transform})
-    , group_(0), enabled_(true) {
+    , uid_(-1), group_(0), enabled_(true) {
   if (parent) { transform_->set_parent(parent_->transform()); }
   sorted_components_.insert(this);
 }
@@ -23,7 +23,7 @@ T* GameObject::addComponent(Args&&... args) {
 
   try {
     T *obj = new T(this, std::forward<Args>(args)...);
-    obj->uid_ = NextUid();
+    AssignUid(obj);
     components_.push_back(std::unique_ptr<GameObject>(obj));
     components_just_enabled_.push_back(obj);
 
@@ -73,33 +73,9 @@ std::vector<T*> GameObject::findComponents() const {
   return found;
 }
 
-inline bool GameObject::stealComponent(GameObject* go) {
-  if (!go) { return false; }
-  GameObject* parent = go->parent();
-  if (!parent) {return false; }
-
-  for (auto iter = parent->components_.begin();
-       iter != parent->components_.end(); ++iter) {
-    GameObject* comp = iter->get();
-    if (comp == go) {
-      components_.push_back(std::unique_ptr<GameObject>(iter->release()));
-      components_just_enabled_.push_back(comp);
-      parent->components_just_disabled_.push_back(comp);
-      // The iter->release() leaves a nullptr in the parent->components_
-      // that should be removed, as it decrases performance
-      parent->removeComponent(nullptr);
-      comp->parent_ = this;
-      comp->transform_->set_parent(transform_.get());
-      comp->scene_ = scene_;
-      comp->uid_ = NextUid();
-      return true;
-    }
-  }
-  return false;
-}
-
 inline int GameObject::NextUid() {
-  static int uid = 0;
+  // The scenes might be built on worker threads
+  static std::atomic<int> uid{0};
   return uid++;
 }
 
@@ -3,6 +3,8 @@
 #include "./scene.h"
 #include "./game_object.h"
 #include "./game_engine.h"
+#include "./debug/profiler.h"
+#include "./debug/gl_stats.h"
 
 #define _TRY_(YourCode) \
   try { \
@@ -13,15 +15,35 @@
 
 namespace engine {
 
+GameObject::~GameObject() {
+  // The scene itself isn't registered
+  if (scene_ && scene_ != this) {
+    auto iter = scene_->objects_.find(uid_);
+    if (iter != scene_->objects_.end() && iter->second == this) {
+      scene_->objects_.erase(iter);
+    }
+  }
+}
+
+void GameObject::AssignUid(GameObject* obj) {
+  if (obj->scene_ && obj->uid_ != -1) {
+    obj->scene_->objects_.erase(obj->uid_);
+  }
+  obj->uid_ = NextUid();
+  if (obj->scene_) {
+    obj->scene_->objects_[obj->uid_] = obj;
+  }
+}
+
 GameObject* GameObject::addComponent(std::unique_ptr<GameObject>&& component) {
   try {
     GameObject *obj = component.get();
     components_.push_back(std::move(component));
     components_just_enabled_.push_back(obj);
     obj->parent_ = this;
-    obj->uid_ = NextUid();
     obj->transform_->set_parent(transform_.get());
     obj->scene_ = scene_;
+    AssignUid(obj);
 
     return obj;
   } catch (const std::exception& ex) {
@@ -63,6 +85,8 @@ void GameObject::set_group(int value) {
 void GameObject::shadowRenderAll() {
   for (auto& component : sorted_components_) {
     if (component == this) {
+      ENGINE_PROFILE_OBJECT();
+      ENGINE_GL_STATS_OBJECT();
       _TRY_(shadowRender());
     } else {
       component->shadowRenderAll();
@@ -73,6 +97,8 @@ void GameObject::shadowRenderAll() {
 void GameObject::renderAll() {
   for (auto& component : sorted_components_) {
     if (component == this) {
+      ENGINE_PROFILE_OBJECT();
+      ENGINE_GL_STATS_OBJECT();
       _TRY_(render());
     } else {
       component->renderAll();
@@ -83,6 +109,8 @@ void GameObject::renderAll() {
 void GameObject::render2DAll() {
   for (auto& component : sorted_components_) {
     if (component == this) {
+      ENGINE_PROFILE_OBJECT();
+      ENGINE_GL_STATS_OBJECT();
       _TRY_(render2D());
     } else {
       component->render2DAll();
@@ -149,14 +177,6 @@ void GameObject::mouseMovedAll(double xpos, double ypos) {
   }
 }
 
-void GameObject::collisionAll(const GameObject* other) {
-  for (auto& component : sorted_components_) {
-    if (component != this) {
-      component->collisionAll(other);
-    }
-  }
-}
-
 void GameObject::internalUpdate() {
   removeComponents();
   updateSortedComponents();
@@ -171,9 +191,12 @@ void GameObject::updateSortedComponents() {
   sorted_components_.insert(components_just_enabled_.begin(),
                             components_just_enabled_.end());
   // make sure all the componenets just enabled are aware of the screen's size
-  glm::vec2 window_size = GameEngine::window_size();
-  for (const auto& component : components_just_enabled_) {
-    component->screenResizedAll(window_size.x, window_size.y);
+  // (the simulation-only scenes have no screen)
+  if (!scene_ || !scene_->simulation_only()) {
+    glm::vec2 window_size = GameEngine::window_size();
+    for (const auto& component : components_just_enabled_) {
+      component->screenResizedAll(window_size.x, window_size.y);
+    }
   }
   components_just_enabled_.clear();
 }
@@ -4,12 +4,14 @@
 #define ENGINE_GAME_OBJECT_H_
 
 #include <set>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <iostream>
 #include <algorithm>
 
 #include "./transform.h"
+#include "./slab_allocator.h"
 
 namespace engine {
 
@@ -20,7 +22,16 @@ class GameObject {
   template<typename Transform_t = Transform>
   explicit GameObject(GameObject* parent,
                       const Transform_t& initial_transform = Transform_t{});
-  virtual ~GameObject() {}
+  virtual ~GameObject();
+
+  // The GameObjects are allocated from the SlabAllocator. The virtual
+  // destructor makes the delete pass the size of the dynamic type.
+  static void* operator new(size_t size) {
+    return SlabAllocator::Instance().allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    SlabAllocator::Instance().deallocate(ptr, size);
+  }
 
   template<typename T, typename... Args>
   T* addComponent(Args&&... contructor_args);
@@ -35,10 +46,6 @@ class GameObject {
   template<typename T>
   std::vector<T*> findComponents() const;
 
-  // Detaches a componenent from its parent, and adopts it.
-  // Returns true on success.
-  bool stealComponent(GameObject* component_to_steal);
-
   void removeComponent(GameObject* component_to_remove);
 
   template <typename T>
@@ -51,6 +58,9 @@ class GameObject {
   const GameObject* parent() const { return parent_; }
   void set_parent(GameObject* parent);
 
+  // Unique for every GameObject added as a component (see Scene::findObject)
+  int uid() const { return uid_; }
+
   Scene* scene() { return scene_; }
   const Scene* scene() const { return scene_; }
   void set_scene(Scene* scene) { scene_ = scene; }
@@ -77,7 +87,6 @@ class GameObject {
   virtual void mouseScrolledAll(double xoffset, double yoffset);
   virtual void mouseButtonPressedAll(int button, int action, int mods);
   virtual void mouseMovedAll(double xpos, double ypos);
-  virtual void collisionAll(const GameObject* other);
 
  protected:
   Scene* scene_;
@@ -90,7 +99,8 @@ class GameObject {
     bool operator() (GameObject* x, GameObject* y) const;
   };
 
-  std::set<GameObject*, CompareGameObjects> sorted_components_;
+  std::set<GameObject*, CompareGameObjects,
+           SlabStlAllocator<GameObject*>> sorted_components_;
   int uid_, group_;
   bool enabled_;
 
@@ -104,9 +114,12 @@ class GameObject {
   static void FindComponents(const GameObject* obj, std::vector<T*> *found);
 
   static int NextUid();
+  // Gives the object a new uid, and registers it in its scene.
+  static void AssignUid(GameObject* obj);
 
   struct ComponentRemoveHelper {
-    std::set<GameObject*> components_;
+    std::set<GameObject*, std::less<GameObject*>,
+             SlabStlAllocator<GameObject*>> components_;
     bool operator()(const std::unique_ptr<GameObject>& go_ptr) {
       return components_.find(go_ptr.get()) != components_.end();
     }
@@ -4,6 +4,7 @@
 #define ENGINE_GUI_BOX_H_
 
 #include <string>
+#include <memory>
 #include "./label.h"
 #include "../../oglwrap/shapes/rectangle_shape.h"
 
@@ -32,31 +33,19 @@ class Box : public engine::GameObject {
  public:
   Box(GameObject* parent, const BoxParams& params)
       : engine::GameObject(parent), params_(params), label_(nullptr)
-      , rect_({gl::RectangleShape::kPosition, gl::RectangleShape::kTexCoord}) {
-    gl::VertexShader vs("engine/box.vert");
-    gl::FragmentShader fs("engine/box.frag");
-    (prog_ << vs << fs).link();
-    gl::Use(prog_);
-
-    (prog_ | "aPosition").bindLocation(rect_.kPosition);
-    (prog_ | "aTexCoord").bindLocation(rect_.kTexCoord);
-    gl::Uniform<glm::vec2>(prog_, "uOffset") = params_.center;
-    gl::Uniform<glm::vec2>(prog_, "uScale") = params_.extent;
-    gl::Uniform<glm::vec4>(prog_, "uBorderColor") = params_.border_color;
-    gl::Uniform<float>(prog_, "uBorderPixels") = params_.border_width;
-    gl::Uniform<float>(prog_, "uRoundness") = params_.roundness;
-
-    if (params_.style == BoxParams::Style::kShaded) {
-      gl::Uniform<glm::vec4>(prog_, "uBgTopColor") = params_.bg_top_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgTopMidColor") = params_.bg_top_mid_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomMidColor") = params_.bg_bottom_mid_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomColor") = params_.bg_bottom_color;
-      gl::Uniform<float>(prog_, "uTransitionHeight") = params_.transition_height;
-    } else {
-      gl::Uniform<glm::vec4>(prog_, "uBgColor") = params_.bg_color;
-      gl::Uniform<float>(prog_, "uTransitionHeight") = -1.0f;
-    }
-
+      , rect_({gl::RectangleShape::kPosition, gl::RectangleShape::kTexCoord})
+      , prog_(GetProgram())
+      , uOffset_(*prog_, "uOffset"), uScale_(*prog_, "uScale")
+      , uBorderColor_(*prog_, "uBorderColor")
+      , uBorderPixels_(*prog_, "uBorderPixels")
+      , uRoundness_(*prog_, "uRoundness")
+      , uTransitionHeight_(*prog_, "uTransitionHeight")
+      , uBgColor_(*prog_, "uBgColor"), uBgTopColor_(*prog_, "uBgTopColor")
+      , uBgTopMidColor_(*prog_, "uBgTopMidColor")
+      , uBgBottomMidColor_(*prog_, "uBgBottomMidColor")
+      , uBgBottomColor_(*prog_, "uBgBottomColor")
+      , uBorderWidth_(*prog_, "uBorderWidth")
+      , uCorners_(*prog_, "uCorners") {
     if(!params_.label_text.empty()) {
       label_ = addComponent<Label>(params_.label_text, params_.label_pos,
                                    params_.label_font, params_.label_cursor_pos);
@@ -64,18 +53,7 @@ class Box : public engine::GameObject {
   }
 
   void set_inverted(bool value) {
-    gl::Use(prog_);
-    if (value) {
-      gl::Uniform<glm::vec4>(prog_, "uBgTopColor") = params_.bg_top_mid_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgTopMidColor") = params_.bg_top_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomMidColor") = params_.bg_bottom_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomColor") = params_.bg_bottom_mid_color;
-    } else {
-      gl::Uniform<glm::vec4>(prog_, "uBgTopColor") = params_.bg_top_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgTopMidColor") = params_.bg_top_mid_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomMidColor") = params_.bg_bottom_mid_color;
-      gl::Uniform<glm::vec4>(prog_, "uBgBottomColor") = params_.bg_bottom_color;
-    }
+    inverted_ = value;
   }
 
   std::wstring text() const {
@@ -96,15 +74,35 @@ class Box : public engine::GameObject {
   Label *label_;
 
   gl::RectangleShape rect_;
-  gl::Program prog_;
+  // Shared by every box, so the uniforms are set at every render.
+  std::shared_ptr<gl::Program> prog_;
+  gl::LazyUniform<glm::vec2> uOffset_, uScale_;
+  gl::LazyUniform<glm::vec4> uBorderColor_;
+  gl::LazyUniform<float> uBorderPixels_, uRoundness_, uTransitionHeight_;
+  gl::LazyUniform<glm::vec4> uBgColor_, uBgTopColor_, uBgTopMidColor_,
+                             uBgBottomMidColor_, uBgBottomColor_;
+  gl::LazyUniform<glm::vec2> uBorderWidth_, uCorners_;
+
+  bool inverted_ = false;
+  glm::vec2 border_width_, corners_[4];
+
+  static std::shared_ptr<gl::Program> GetProgram() {
+    return GameEngine::asset_cache()->get<gl::Program>(
+        "engine/box.vert|engine/box.frag", []() {
+      gl::VertexShader vs("engine/box.vert");
+      gl::FragmentShader fs("engine/box.frag");
+      auto prog = make_unique<gl::Program>();
+      (*prog << vs << fs).link();
+      (*prog | "aPosition").bindLocation(gl::RectangleShape::kPosition);
+      (*prog | "aTexCoord").bindLocation(gl::RectangleShape::kTexCoord);
+      return prog;
+    }, AssetCache::Retention::kForever);  // the menus use it in every scene
+  }
 
   virtual void screenResized(size_t width, size_t height) override {
-    glm::vec2 border_width = params_.border_width /
+    border_width_ = params_.border_width /
         (params_.extent * glm::vec2(0.99f * width, 0.99f * height));
 
-    gl::Use(prog_);
-    gl::Uniform<glm::vec2>(prog_, "uBorderWidth") = border_width;
-
     glm::vec2 corners[4] = {glm::vec2{-1, -1}, glm::vec2{-1, +1},
                             glm::vec2{+1, -1}, glm::vec2{+1, +1}};
 
@@ -116,14 +114,41 @@ class Box : public engine::GameObject {
       // offset it with 'roundness' px towards the center
       corner -= corners[i] * glm::vec2(params_.roundness);
 
-      // and upload the uniform
-      std::string name = "uCorners[" + std::to_string(i) + "]";
-      gl::Uniform<glm::vec2>(prog_, name) = corner;
+      corners_[i] = corner;
     }
   }
 
   virtual void render2D() override {
-    gl::Use(prog_);
+    gl::Use(*prog_);
+    uOffset_.set(params_.center);
+    uScale_.set(params_.extent);
+    uBorderColor_.set(params_.border_color);
+    uBorderPixels_.set(params_.border_width);
+    uRoundness_.set(params_.roundness);
+    uBorderWidth_.set(border_width_);
+    for (int i = 0; i < 4; ++i) {
+      uCorners_[i] = corners_[i];
+    }
+
+    if (params_.style == BoxParams::Style::kShaded) {
+      // Inverting swaps the colors of the top, and of the bottom half
+      if (inverted_) {
+        uBgTopColor_.set(params_.bg_top_mid_color);
+        uBgTopMidColor_.set(params_.bg_top_color);
+        uBgBottomMidColor_.set(params_.bg_bottom_color);
+        uBgBottomColor_.set(params_.bg_bottom_mid_color);
+      } else {
+        uBgTopColor_.set(params_.bg_top_color);
+        uBgTopMidColor_.set(params_.bg_top_mid_color);
+        uBgBottomMidColor_.set(params_.bg_bottom_mid_color);
+        uBgBottomColor_.set(params_.bg_bottom_color);
+      }
+      uTransitionHeight_.set(params_.transition_height);
+    } else {
+      uBgColor_.set(params_.bg_color);
+      uTransitionHeight_.set(-1.0f);
+    }
+
     rect_.render();
   }
 };
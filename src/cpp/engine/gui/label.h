@@ -5,8 +5,11 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
+#include "../misc.h"
 #include "../game_engine.h"
+#include "../../oglwrap/uniform.h"
 #include "../../oglwrap/smart_enums.h"
 
 #include "./font.h"
@@ -18,24 +21,35 @@ class Label : public GameObject {
   Font font_;
   gl::VertexArray vao_;
   gl::ArrayBuffer attribs_;
-  gl::Program prog_;
+  // Shared by every label, so the uniforms are set at every render.
+  std::shared_ptr<gl::Program> prog_;
+  gl::LazyUniform<glm::vec4> uColor_;
+  gl::LazyUniform<glm::vec2> uOffset_;
+  gl::LazyUniform<glm::mat4> uProjectionMatrix_;
 
   size_t vertex_count_;
-  glm::vec2 pos_, size_;
+  glm::vec2 pos_, size_, offset_;
+  glm::mat4 projection_matrix_;
   std::wstring text_;
 
+  static std::shared_ptr<gl::Program> GetProgram() {
+    return GameEngine::asset_cache()->get<gl::Program>(
+        "engine/text.vert|engine/text.frag", []() {
+      gl::VertexShader vs("engine/text.vert");
+      gl::FragmentShader fs("engine/text.frag");
+      auto prog = make_unique<gl::Program>();
+      (*prog << vs << fs).link();
+      return prog;
+    }, AssetCache::Retention::kForever);  // every scene has labels
+  }
+
  public:
   Label(GameObject* parent, const std::wstring& text, glm::vec2 pos,
         const Font& font = Font{}, size_t cursor_pos = -1)
-      : GameObject(parent), font_(font)
+      : GameObject(parent), font_(font), prog_(GetProgram())
+      , uColor_(*prog_, "uColor"), uOffset_(*prog_, "uOffset")
+      , uProjectionMatrix_(*prog_, "uProjectionMatrix")
       , vertex_count_(0), pos_(pos), text_(text) {
-    gl::VertexShader vs("engine/text.vert");
-    gl::FragmentShader fs("engine/text.frag");
-
-    (prog_ << vs << fs).link();
-    gl::Use(prog_);
-    gl::Uniform<glm::vec4>(prog_, "uColor") = font.color();
-
     set_text(text, cursor_pos);
     size_.y = font.size();
   }
@@ -64,8 +78,7 @@ class Label : public GameObject {
       actual_pos.y += size().y;
     }
 
-    gl::Use(prog_);
-    gl::Uniform<glm::vec2>(prog_, "uOffset") = actual_pos;
+    offset_ = actual_pos;
   }
 
   glm::vec2 size() const {
@@ -146,14 +159,14 @@ class Label : public GameObject {
     // Update the length of the text
     size_.x = x1;
 
-    gl::Use(prog_);
+    gl::Use(*prog_);
     gl::Bind(vao_);
     gl::Bind(attribs_);
     attribs_.data(attribs_vec);
-    (prog_ | "aPosition").pointer(2, gl::kFloat, false,
-                                  4*sizeof(GLfloat), 0).enable();
-    (prog_ | "aTexCoord").pointer(2, gl::kFloat, false, 4*sizeof(GLfloat),
-                                  (const void*)(2*sizeof(GLfloat))).enable();
+    (*prog_ | "aPosition").pointer(2, gl::kFloat, false,
+                                   4*sizeof(GLfloat), 0).enable();
+    (*prog_ | "aTexCoord").pointer(2, gl::kFloat, false, 4*sizeof(GLfloat),
+                                   (const void*)(2*sizeof(GLfloat))).enable();
     gl::Unbind(vao_);
 
     vertex_count_ = attribs_vec.size();
@@ -162,8 +175,6 @@ class Label : public GameObject {
   const Font& font() const { return font_; }
   const glm::vec4& color() const { return font_.color(); }
   void set_color(const glm::vec4& color) {
-    gl::Use(prog_);
-    gl::Uniform<glm::vec4>(prog_, "uColor") = color;
     font_.set_color(color);
   }
   float font_size() const { return font_.size(); }
@@ -192,14 +203,16 @@ class Label : public GameObject {
   }
 
   virtual void screenResized(size_t width, size_t height) override {
-    gl::Use(prog_);
-    gl::Uniform<glm::mat4>(prog_, "uProjectionMatrix") =
+    projection_matrix_ =
       glm::ortho<float>(-int(width)/2, width/2, -int(height)/2, height/2, -1, 1);
     set_position(pos_);
   }
 
   virtual void render2D() override {
-    gl::Use(prog_);
+    gl::Use(*prog_);
+    uColor_.set(font_.color());
+    uOffset_.set(offset_);
+    uProjectionMatrix_.set(projection_matrix_);
     gl::Bind(vao_);
 
     gl::ActiveTexture(0);
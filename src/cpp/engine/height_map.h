@@ -3,6 +3,8 @@
 #ifndef ENGINE_HEIGHT_MAP_H_
 #define ENGINE_HEIGHT_MAP_H_
 
+#include <array>
+#include <vector>
 #include <climits>
 #include "../oglwrap/debug/insertion.h"
 #include "./transform.h"
@@ -23,11 +25,14 @@ class HeightMap : public HeightMapInterface {
   HeightMap(const std::string& file_name,
             const std::string& format_string = "CR")
       : tex_(file_name, format_string) {
-    static_assert(std::is_same<T, char>::value ||
-                  std::is_same<T, unsigned char>::value ||
-                  std::is_same<T, short>::value ||
-                  std::is_same<T, unsigned short>::value,
-                  "Only uchar and ushort heightmaps are supported yet");
+    CheckType();
+  }
+
+  // Uses the given heights, row by row (it doesn't need an image file).
+  HeightMap(int w, int h, const std::vector<T>& heights,
+            const std::string& format_string = "CR")
+      : tex_(w, h, ToTexels(heights), format_string) {
+    CheckType();
   }
 
   // The width and height of the texture
@@ -47,7 +52,7 @@ class HeightMap : public HeightMapInterface {
   }
 
   virtual double heightAt(int s, int t) const override {
-    return tex_(s, t)[0] / double(std::numeric_limits<T>::max()) * 255;
+    return tex_(s, t)[0] * Scale();
   }
 
   virtual double heightAt(double s, double t) const override {
@@ -64,7 +69,7 @@ class HeightMap : public HeightMapInterface {
     double fh = glm::mix(double(tex_(fs, ft)[0]), double(tex_(cs, ft)[0]), s-fs);
     double ch = glm::mix(double(tex_(fs, ct)[0]), double(tex_(cs, ct)[0]), s-fs);
 
-    return glm::mix(fh, ch, t-ft) / double(std::numeric_limits<T>::max()) * 255;
+    return glm::mix(fh, ch, t-ft) * Scale();
   }
 
   virtual gl::PixelDataFormat format() const override {
@@ -82,6 +87,35 @@ class HeightMap : public HeightMapInterface {
   virtual const void* data() const override {
     return tex_.data().data();
   }
+
+  virtual double height_scale() const override {
+    return Scale();
+  }
+
+ private:
+  // The integer heightmaps are normalized to [0, 255],
+  // the floating point ones contain the heights themselves.
+  static double Scale() {
+    return std::is_floating_point<T>::value ? 1.0 :
+        255.0 / double(std::numeric_limits<T>::max());
+  }
+
+  static void CheckType() {
+    static_assert(std::is_same<T, char>::value ||
+                  std::is_same<T, unsigned char>::value ||
+                  std::is_same<T, short>::value ||
+                  std::is_same<T, unsigned short>::value ||
+                  std::is_same<T, float>::value,
+                  "Only char, short and float heightmaps are supported yet");
+  }
+
+  static std::vector<std::array<T, 1>> ToTexels(const std::vector<T>& heights) {
+    std::vector<std::array<T, 1>> texels(heights.size());
+    for (size_t i = 0; i < heights.size(); ++i) {
+      texels[i][0] = heights[i];
+    }
+    return texels;
+  }
 };
 
 }  // namespace engine
@@ -0,0 +1,120 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <utility>
+#include <stdexcept>
+
+#include "./import_graph.h"
+#include "./game_engine.h"
+#include "./mesh/cooked_model.h"
+
+namespace engine {
+
+ImportGraph::ImportGraph(ThreadPool* thread_pool)
+    : thread_pool_(thread_pool ? thread_pool : GameEngine::thread_pool()) {}
+
+ImportGraph::~ImportGraph() {
+  for (const auto& node : nodes_) {
+    if (!node->claimed.exchange(true)) {
+      node->done.set_value();
+    } else {
+      node->finished.wait();
+    }
+  }
+}
+
+ImportGraph::Id ImportGraph::addMesh(const std::string& filename,
+                                     unsigned flags,
+                                     const std::vector<Id>& dependencies) {
+  auto node = std::make_shared<Node>();
+  Node* raw_node = node.get();
+  node->work = [raw_node, filename, flags]() {
+    ENGINE_PROFILE("import mesh");
+    // The graphs that import the same model share it
+    raw_node->model = *GameEngine::asset_cache()->get<ImportedModel>(
+        ModelKey(filename, flags), [&]() {
+      return make_unique<ImportedModel>(LoadModel(filename, flags));
+    });
+  };
+  return add(std::move(node), dependencies);
+}
+
+ImportGraph::Id ImportGraph::addAnimation(const std::string& filename,
+                                          const std::vector<Id>& dependencies) {
+  auto node = std::make_shared<Node>();
+  Node* raw_node = node.get();
+  node->work = [raw_node, filename]() {
+    ENGINE_PROFILE("import animation");
+    raw_node->clip = AnimationClip::Load(filename);
+  };
+  return add(std::move(node), dependencies);
+}
+
+ImportGraph::Id ImportGraph::addJob(std::function<void()> job,
+                                    const std::vector<Id>& dependencies) {
+  auto node = std::make_shared<Node>();
+  node->work = std::move(job);
+  return add(std::move(node), dependencies);
+}
+
+ImportGraph::Id ImportGraph::add(std::shared_ptr<Node> node,
+                                 const std::vector<Id>& dependencies) {
+  for (Id dependency : dependencies) {
+    if (dependency >= nodes_.size()) {
+      throw std::logic_error("ImportGraph: unknown dependency");
+    }
+    node->dependencies.push_back(nodes_[dependency]);
+  }
+  nodes_.push_back(node);
+
+  // The dependencies were enqueued before this node, so by the time a worker
+  // gets to it, they are all running (or done) already.
+  thread_pool_->enqueue([node]() {
+    if (!node->claimed.exchange(true)) {
+      Run(node.get());
+    }
+  });
+  return nodes_.size() - 1;
+}
+
+void ImportGraph::wait(Id id) {
+  Wait(nodes_.at(id).get());
+}
+
+void ImportGraph::waitAll() {
+  for (const auto& node : nodes_) {
+    Wait(node.get());
+  }
+}
+
+ImportedModel ImportGraph::get(Id id) {
+  Node* node = nodes_.at(id).get();
+  Wait(node);
+  return node->model;
+}
+
+std::shared_ptr<const AnimationClip> ImportGraph::getAnimation(Id id) {
+  Node* node = nodes_.at(id).get();
+  Wait(node);
+  return node->clip;
+}
+
+void ImportGraph::Run(Node* node) {
+  try {
+    for (const auto& dependency : node->dependencies) {
+      Wait(dependency.get());
+    }
+    node->work();
+    node->done.set_value();
+  } catch(...) {
+    node->done.set_exception(std::current_exception());
+  }
+}
+
+void ImportGraph::Wait(Node* node) {
+  if (!node->claimed.exchange(true)) {
+    Run(node);
+  }
+  node->finished.get();
+}
+
+}  // namespace engine
@@ -0,0 +1,89 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_IMPORT_GRAPH_H_
+#define ENGINE_IMPORT_GRAPH_H_
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "./thread_pool.h"
+#include "./mesh/imported_model.h"
+#include "./mesh/animation_clip.h"
+
+namespace engine {
+
+// The assets of an object, declared up front, so that they can be imported in
+// parallel on the thread pool, while the declaring thread only does the
+// serial part (the GL uploads), taking the assets as they are needed.
+// A declaration can depend on earlier ones: it only runs after they have
+// finished. If a thread waits for an asset that no worker has started yet,
+// it imports it itself, so waiting from a worker thread can't deadlock.
+class ImportGraph {
+ public:
+  using Id = size_t;
+
+  // Uses the GameEngine's thread pool by default.
+  explicit ImportGraph(ThreadPool* thread_pool = nullptr);
+  // Drops the work that hasn't started yet, and waits for the rest.
+  ~ImportGraph();
+
+  ImportGraph(const ImportGraph&) = delete;
+  ImportGraph& operator=(const ImportGraph&) = delete;
+
+  // A model for a MeshRenderer (or an AnimatedMeshRenderer). It is
+  // triangulated, besides the given post processing steps. Its cooked version
+  // is used if it is up to date (see LoadModel). A model that is in the
+  // AssetCache already (see ModelKey) isn't imported again.
+  Id addMesh(const std::string& filename, unsigned flags,
+             const std::vector<Id>& dependencies = {});
+
+  // The skeletal animation of a file, for AnimatedMeshRenderer::addAnimation.
+  // Its cooked clip is used if it is up to date (see AnimationClip::Load).
+  Id addAnimation(const std::string& filename,
+                  const std::vector<Id>& dependencies = {});
+
+  // Any other work that doesn't need the context (i.e. cooking a collider).
+  Id addJob(std::function<void()> job,
+            const std::vector<Id>& dependencies = {});
+
+  // Waits until the work is done, and rethrows its exception if it failed.
+  void wait(Id id);
+  void waitAll();
+
+  // The number of declarations, their ids are [0, size()).
+  size_t size() const { return nodes_.size(); }
+
+  // Waits for an imported model. The copies share the assimp scene.
+  ImportedModel get(Id id);
+
+  // Waits for an animation clip.
+  std::shared_ptr<const AnimationClip> getAnimation(Id id);
+
+ private:
+  struct Node {
+    std::function<void()> work;
+    std::vector<std::shared_ptr<Node>> dependencies;
+    std::atomic<bool> claimed{false};  // a thread has started it
+    std::promise<void> done;
+    std::shared_future<void> finished = done.get_future().share();
+    ImportedModel model;
+    std::shared_ptr<const AnimationClip> clip;
+  };
+
+  ThreadPool* thread_pool_;
+  std::vector<std::shared_ptr<Node>> nodes_;
+
+  Id add(std::shared_ptr<Node> node, const std::vector<Id>& dependencies);
+
+  static void Run(Node* node);
+  // Runs the node on the calling thread, if no other thread has done it.
+  static void Wait(Node* node);
+};
+
+}  // namespace engine
+
+#endif
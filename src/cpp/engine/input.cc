@@ -0,0 +1,172 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <iomanip>
+#include <stdexcept>
+
+#include "./input.h"
+#include "./clock.h"
+#include "./game_engine.h"
+
+namespace engine {
+
+std::bitset<GLFW_KEY_LAST + 1> Input::keys_;
+std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> Input::buttons_;
+glm::dvec2 Input::cursor_pos_;
+
+bool Input::started_ = false;
+bool Input::replaying_ = false;
+double Input::start_time_ = 0;
+std::ofstream Input::record_;
+std::vector<Input::Event> Input::events_;
+size_t Input::next_event_ = 0;
+
+void Input::Record(const std::string& path) {
+  record_.open(path);
+  if (!record_) {
+    throw std::runtime_error("Couldn't open " + path + " for recording");
+  }
+  record_ << std::fixed << std::setprecision(9);
+}
+
+void Input::Replay(const std::string& path) {
+  std::ifstream file{path};
+  if (!file) {
+    throw std::runtime_error("Couldn't open the input recording " + path);
+  }
+
+  // Every line is: <time> <type> <up to 4 arguments>
+  events_.clear();
+  Event event;
+  char type;
+  while (file >> event.time >> type) {
+    event.type = static_cast<EventType>(type);
+    int arg_count = 0;
+    switch (event.type) {
+      case EventType::kKey: arg_count = 4; break;
+      case EventType::kChar: arg_count = 1; break;
+      case EventType::kScroll: arg_count = 2; break;
+      case EventType::kButton: arg_count = 3; break;
+      case EventType::kMove: arg_count = 2; break;
+      default:
+        throw std::runtime_error("Invalid event in the input recording " +
+                                 path + ": " + type);
+    }
+    for (int i = 0; i < arg_count; ++i) {
+      file >> event.args[i];
+    }
+    if (!file) {
+      throw std::runtime_error("Truncated input recording: " + path);
+    }
+    events_.push_back(event);
+  }
+
+  next_event_ = 0;
+  replaying_ = true;
+}
+
+void Input::PollEvents() {
+  GLFWwindow* window = GameEngine::window();
+  if (!started_) {
+    started_ = true;
+    start_time_ = Clock::now();
+    if (window && !replaying_) {
+      // The events only report the changes, so start from the real position.
+      glm::dvec2 pos;
+      glfwGetCursorPos(window, &pos.x, &pos.y);
+      LiveEvent({0.0, EventType::kMove, {pos.x, pos.y}});
+    }
+  }
+
+  if (window) {
+    glfwPollEvents();
+  }
+
+  if (replaying_) {
+    double time = Clock::now() - start_time_;
+    while (next_event_ < events_.size() && events_[next_event_].time <= time) {
+      Dispatch(events_[next_event_++]);
+    }
+  }
+}
+
+double Input::EventTime() {
+  return started_ ? Clock::now() - start_time_ : 0.0;
+}
+
+void Input::KeyAction(int key, int scancode, int action, int mods) {
+  LiveEvent({EventTime(), EventType::kKey,
+             {double(key), double(scancode), double(action), double(mods)}});
+}
+
+void Input::CharTyped(unsigned codepoint) {
+  LiveEvent({EventTime(), EventType::kChar,
+             {double(codepoint)}});
+}
+
+void Input::MouseScrolled(double xoffset, double yoffset) {
+  LiveEvent({EventTime(), EventType::kScroll,
+             {xoffset, yoffset}});
+}
+
+void Input::MouseButtonPressed(int button, int action, int mods) {
+  LiveEvent({EventTime(), EventType::kButton,
+             {double(button), double(action), double(mods)}});
+}
+
+void Input::MouseMoved(double xpos, double ypos) {
+  LiveEvent({EventTime(), EventType::kMove, {xpos, ypos}});
+}
+
+void Input::LiveEvent(const Event& event) {
+  if (replaying_) { return; }
+
+  if (record_.is_open()) {
+    record_ << event.time << ' ' << static_cast<char>(event.type);
+    int arg_count = event.type == EventType::kKey ? 4 :
+                    event.type == EventType::kButton ? 3 :
+                    event.type == EventType::kChar ? 1 : 2;
+    for (int i = 0; i < arg_count; ++i) {
+      record_ << ' ' << event.args[i];
+    }
+    record_ << '\n';
+  }
+
+  Dispatch(event);
+}
+
+void Input::Dispatch(const Event& event) {
+  Scene* scene = GameEngine::scene();
+  const double* args = event.args;
+  switch (event.type) {
+    case EventType::kKey: {
+      int key = int(args[0]), action = int(args[2]);
+      if (0 <= key && key <= GLFW_KEY_LAST) {
+        keys_[key] = action != GLFW_RELEASE;
+      }
+      if (scene) {
+        scene->keyActionAll(key, int(args[1]), action, int(args[3]));
+      }
+    } break;
+    case EventType::kChar:
+      if (scene) { scene->charTypedAll(unsigned(args[0])); }
+      break;
+    case EventType::kScroll:
+      if (scene) { scene->mouseScrolledAll(args[0], args[1]); }
+      break;
+    case EventType::kButton: {
+      int button = int(args[0]), action = int(args[1]);
+      if (0 <= button && button <= GLFW_MOUSE_BUTTON_LAST) {
+        buttons_[button] = action != GLFW_RELEASE;
+      }
+      if (scene) {
+        scene->mouseButtonPressedAll(button, action, int(args[2]));
+      }
+    } break;
+    case EventType::kMove:
+      cursor_pos_ = glm::dvec2(args[0], args[1]);
+      if (scene) { scene->mouseMovedAll(args[0], args[1]); }
+      break;
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,88 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_INPUT_H_
+#define ENGINE_INPUT_H_
+
+#include <bitset>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "./oglwrap_config.h"
+#include <GLFW/glfw3.h>
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace engine {
+
+// The keyboard and mouse state, that the behaviours should poll instead of
+// asking GLFW directly. It is built from the window's input events, which can
+// be recorded into a file (with their Clock time), and a recording can be
+// replayed instead of the live input. With a simulated Clock, two replays of
+// the same recording see the same events in the same frames, and as the
+// physics is stepped in sync with the frames meanwhile (see
+// GameEngine::deterministic), the same simulation. Main thread only.
+class Input {
+ public:
+  static bool key_pressed(int key) {
+    return 0 <= key && key <= GLFW_KEY_LAST && keys_[key];
+  }
+  static bool mouse_button_pressed(int button) {
+    return 0 <= button && button <= GLFW_MOUSE_BUTTON_LAST && buttons_[button];
+  }
+  static glm::dvec2 cursor_pos() { return cursor_pos_; }
+
+  // Writes every input event into the file, from the first frame on.
+  static void Record(const std::string& path);
+  // Ignores the live input, and plays back a recording instead.
+  static void Replay(const std::string& path);
+  static bool recording() { return record_.is_open(); }
+  static bool replaying() { return replaying_; }
+  static bool replay_finished() {
+    return replaying_ && next_event_ == events_.size();
+  }
+
+  // Processes the events of this frame (the live ones, or the recorded ones
+  // up to the Clock's current time), and forwards them to the scene.
+  static void PollEvents();
+
+  // The window's callbacks (see GameEngine).
+  static void KeyAction(int key, int scancode, int action, int mods);
+  static void CharTyped(unsigned codepoint);
+  static void MouseScrolled(double xoffset, double yoffset);
+  static void MouseButtonPressed(int button, int action, int mods);
+  static void MouseMoved(double xpos, double ypos);
+
+ private:
+  enum class EventType : char {
+    kKey = 'k', kChar = 'c', kScroll = 's', kButton = 'b', kMove = 'm'
+  };
+
+  struct Event {
+    double time;  // relative to the first PollEvents
+    EventType type;
+    double args[4];
+  };
+
+  static std::bitset<GLFW_KEY_LAST + 1> keys_;
+  static std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> buttons_;
+  static glm::dvec2 cursor_pos_;
+
+  static bool started_, replaying_;
+  static double start_time_;
+  static std::ofstream record_;
+  static std::vector<Event> events_;
+  static size_t next_event_;
+
+  // The time of a live event. The ones that arrive before the first
+  // PollEvents belong to the first frame.
+  static double EventTime();
+  // Handles a live event: records it, and dispatches it (unless replaying).
+  static void LiveEvent(const Event& event);
+  // Updates the state, and forwards the event to the scene.
+  static void Dispatch(const Event& event);
+};
+
+}  // namespace engine
+
+#endif
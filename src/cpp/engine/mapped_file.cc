@@ -0,0 +1,74 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <utility>
+#include <stdexcept>
+
+#include "./mapped_file.h"
+
+namespace engine {
+
+MappedFile::MappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::runtime_error("Couldn't open " + path);
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) == -1 || info.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("Couldn't get the size of " + path);
+  }
+
+  void* data = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive, the descriptor isn't needed anymore
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("Couldn't map " + path);
+  }
+
+  data_ = static_cast<unsigned char*>(data);
+  size_ = info.st_size;
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    unmap();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  unmap();
+}
+
+void MappedFile::unmap() {
+  if (data_) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+std::time_t MappedFile::ModificationTime(const std::string& path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) == -1) {
+    return 0;
+  }
+  return info.st_mtime;
+}
+
+}  // namespace engine
@@ -0,0 +1,44 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MAPPED_FILE_H_
+#define ENGINE_MAPPED_FILE_H_
+
+#include <string>
+#include <cstddef>
+#include <ctime>
+
+namespace engine {
+
+// A file mapped into the memory. The mapping is private: it can be written
+// (which is needed for in-place deserialization), but the changes never
+// reach the file. The data is page aligned.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  // Throws std::runtime_error if the file can't be opened or mapped.
+  explicit MappedFile(const std::string& path);
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  ~MappedFile();
+
+  unsigned char* data() { return data_; }
+  const unsigned char* data() const { return data_; }
+  size_t size() const { return size_; }
+  explicit operator bool() const { return data_ != nullptr; }
+
+  // Returns the modification time of a file, or 0 if it doesn't exist.
+  static std::time_t ModificationTime(const std::string& path);
+
+ private:
+  unsigned char* data_ = nullptr;
+  size_t size_ = 0;
+
+  void unmap();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+};
+
+}  // namespace engine
+
+#endif
@@ -5,23 +5,28 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 #include "../oglwrap_config.h"
 
 #include "anim_state.h"
+#include "animation_clip.h"
 #include "../assimp.h"
 
 namespace engine {
 
 /// A struct storing info per animation
 struct AnimInfo {
-  /// The importer that stores the animations.
+  /// The compressed animation.
   // It is a shared_ptr because we want to use AnimInfo
   // in std::vector, which needs copy ctor
-  std::shared_ptr<Assimp::Importer> importer;
+  std::shared_ptr<const AnimationClip> clip;
 
   /// Handle for the animations
-  const aiScene* handle;
+  const AnimationClip* handle;
+
+  /// The channel of the clip that animates a node of the mesh.
+  std::unordered_map<const aiNode*, unsigned> node_channels;
 
   /// The name of the animation.
   std::string name;
@@ -40,8 +45,7 @@ struct AnimInfo {
 
   /// Default constructor
   AnimInfo()
-      : importer(new Assimp::Importer{})
-      , handle(nullptr)
+      : handle(nullptr)
       , flags(0)
       , speed(1.0f)
   { }
@@ -7,6 +7,8 @@
 
 namespace engine {
 
+class AnimationClip;
+
 /// Animation modifying flags.
 enum class AnimFlag : GLbitfield {
   /// Doesn't do anything.
@@ -39,7 +41,7 @@ enum class AnimFlag : GLbitfield {
 /// A class storing an animation's state.
 struct AnimationState {
   /// The handle to the animation.
-  const aiScene* handle;
+  const AnimationClip* handle;
 
   /// The index of the animation in the anim vector.
   size_t idx;
@@ -38,6 +38,9 @@ class AnimatedMeshRenderer : public MeshRenderer {
   AnimatedMeshRenderer(const std::string& filename,
                        gl::Bitfield<aiPostProcessSteps> flags);
 
+  /// Uses a model that has been imported already (see ImportGraph::addMesh).
+  explicit AnimatedMeshRenderer(ImportedModel model);
+
   /// Returns a reference to the animation resources
   const AnimData& getAnimData() const { return anims_; }
 
@@ -54,8 +57,6 @@ class AnimatedMeshRenderer : public MeshRenderer {
 
   /**
    * @brief Returns the number of bones this scene has.
-   *
-   * May change the currently active VAO and ArrayBuffer at the first call.
    */
   size_t getNumBones();
 
@@ -100,6 +101,18 @@ class AnimatedMeshRenderer : public MeshRenderer {
    */
   void uploadBoneInfo(gl::LazyUniform<glm::mat4>& bones);
 
+  /**
+   * @brief Copies the bones' transformations, that updateBoneInfo has set.
+   *
+   * The objects that share the renderer (see AssetCache) keep their own pose
+   * this way, as update and render are separate passes.
+   */
+  void copyBoneInfo(std::vector<glm::mat4>* bones) const;
+
+  /// Uploads a pose that has been copied by copyBoneInfo.
+  static void UploadBoneInfo(const std::vector<glm::mat4>& pose,
+                             gl::LazyUniform<glm::mat4>& bones);
+
   /**
    * @brief Updates the bones transformation and uploads them into the given
    *        uniforms.
@@ -138,6 +151,13 @@ class AnimatedMeshRenderer : public MeshRenderer {
                     gl::Bitfield<AnimFlag> flags = AnimFlag::None,
                     float speed = 1.0f);
 
+  /// The same, but with an animation that has been loaded already (see
+  /// ImportGraph::addAnimation).
+  void addAnimation(std::shared_ptr<const AnimationClip> clip,
+                    const std::string& anim_name,
+                    gl::Bitfield<AnimFlag> flags = AnimFlag::None,
+                    float speed = 1.0f);
+
  private:
   /// It shouldn't be copyable.
   AnimatedMeshRenderer(const AnimatedMeshRenderer& src) = delete;
@@ -150,14 +170,20 @@ class AnimatedMeshRenderer : public MeshRenderer {
   /// Fills the bone_mapping with data.
   void mapBones();
 
+  /// Fills the node_bones from the bone_mapping, for a node's subtree.
+  void mapBoneNodes(const aiNode* node);
+
   /**
    * @brief A recursive functions that should be started from the root node, and
-   * it returns the first bone under it.
+   * it returns the channel of the first bone under it, or -1.
    *
    * @param node   The current root node.
    * @param anim   The animation to seek the root bone in.
    */
-  const aiNodeAnim* getRootBone(const aiNode* node, const aiScene* anim);
+  int getRootBone(const aiNode* node, const AnimationClip& anim);
+
+  /// Fills the node_channels of an animation, for a node's subtree.
+  void mapNodeChannels(const aiNode* node, AnimInfo* anim);
 
   template <typename Index_t>
   /**
@@ -226,85 +252,6 @@ class AnimatedMeshRenderer : public MeshRenderer {
 
   // -------------------------------- Animation --------------------------------
 
-  /**
-   * @brief Returns the index of the currently active translation keyframe for
-   *        the given animation and time.
-   *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findPosition(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the index of the currently active rotation keyframe for
-   *        the given animation and time.
-   *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findRotation(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the index of the currently active scaling keyframe for
-   *        the given animation and time.
-   *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findScaling(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a linearly interpolated value between the previous and next
-   *        translation keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedPosition(aiVector3D& out, float anim_time,
-                                const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a spherically interpolated value (always choosing the shorter
-   * path) between the previous and next rotation keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedRotation(aiQuaternion& out, float anim_time,
-                                const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a linearly interpolated value between the previous and next
-   *        scaling keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedScaling(aiVector3D& out, float anim_time,
-                               const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the animation node in the given animation, referenced by
-   *        its name.
-   *
-   * Returns nullptr if it doesn't find a node with that name,
-   * which usually means that it's not a bone.
-   *
-   * @param animation - The animation, this function should search in.
-   * @param node_name - The name of the bone to search.
-   */
-  const aiNodeAnim* findNodeAnim(const aiAnimation* animation,
-                                 const std::string node_name);
-
   /**
    * @brief Recursive function that travels through the entire node hierarchy,
    *        and creates transformation values in world space.
@@ -317,7 +264,7 @@ class AnimatedMeshRenderer : public MeshRenderer {
    * it was at the start of the animation.
    *
    * @param animation          The animation to update.
-   * @param anim_time          The current animation time.
+   * @param pose               The sampled channels of the current animation.
    * @param node               The node (bone) whose, and whose child's
    *                           transformation should be updated. You should call
    *                           this function with the root node.
@@ -325,19 +272,21 @@ class AnimatedMeshRenderer : public MeshRenderer {
    *                           call it with an identity matrix.
    */
   void updateBoneTree(Animation& animation,
-                      float anim_time,
+                      const AnimationClip::Transform* pose,
                       const aiNode* node,
                       const glm::mat4& parent_transform = glm::mat4());
 
   /**
-   * @brief Does the same thing as readNodeHierarchy, but it is used to create
-   *        transitions between animations, so it interpolates between four
-   *        keyframes not two.
+   * @brief Does the same thing as updateBoneTree, but it is used to create
+   *        transitions between animations, so it interpolates between the
+   *        poses of two animations.
    *
    * @param animation             The animation to update.
-   * @param prev_animation_time   The animation time of when, the last animation
-   *                              was interrupted.
-   * @param next_animation_time   The current animation time.
+   * @param prev_pose             The sampled channels of the last animation,
+   *                              at the time it was interrupted.
+   * @param next_pose             The sampled channels of the current
+   *                              animation.
+   * @param factor                The progress of the transition.
    * @param node                  The node (bone) whose, and whose child's
    *                              transformation should be updated. You should
    *                              call this function with the root node.
@@ -345,8 +294,8 @@ class AnimatedMeshRenderer : public MeshRenderer {
    *                              should call it with an identity matrix.
    */
   void updateBoneTreeInTransition(Animation& animation,
-                                  float prev_animation_time,
-                                  float next_animation_time,
+                                  const AnimationClip::Transform* prev_pose,
+                                  const AnimationClip::Transform* next_pose,
                                   float factor,
                                   const aiNode* node,
                                   const glm::mat4& parent_transform = glm::mat4());
@@ -2,158 +2,50 @@
 
 #include "animated_mesh_renderer.h"
 #include "animation.h"
+#include "../frame_arena.h"
 
 namespace engine {
 
-template <typename T, typename U>
-T mix(const T& x, const T& y, const U& a) {
-   return x*(1-a) + y*a;
-}
-
-unsigned AnimatedMeshRenderer::findPosition(float anim_time,
-                                            const aiNodeAnim* node_anim) {
-   // Find the first one that is bigger or equals
-   for (unsigned i = 0; i < node_anim->mNumPositionKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mPositionKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   // Should never get here
-   assert(0);
-}
-
-unsigned AnimatedMeshRenderer::findRotation(float anim_time,
-                                            const aiNodeAnim* node_anim) {
-   for (unsigned i = 0; i < node_anim->mNumRotationKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mRotationKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   assert(0);
-}
-
-unsigned AnimatedMeshRenderer::findScaling(float anim_time,
-                                           const aiNodeAnim* node_anim) {
-   for (unsigned i = 0; i < node_anim->mNumScalingKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mScalingKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   assert(0);
-}
-
-void AnimatedMeshRenderer::calcInterpolatedPosition(
-                                                aiVector3D& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mPositionKeys;
-   const auto& numKeys = node_anim->mNumPositionKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findPosition(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
+namespace {
 
-   const aiVector3D& start = keys[i].mValue;
-   const aiVector3D& end   = keys[i + 1].mValue;
-   out = mix(start, end, factor);
+glm::mat4 TransformMatrix(const glm::vec3& translation,
+                          const glm::quat& rotation,
+                          const glm::vec3& scaling) {
+   return glm::translate(glm::mat4(), translation) *
+          glm::mat4_cast(rotation) *
+          glm::scale(glm::mat4(), scaling);
 }
 
-void AnimatedMeshRenderer::calcInterpolatedRotation(
-                                                aiQuaternion& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mRotationKeys;
-   const auto& numKeys = node_anim->mNumRotationKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findRotation(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
-
-   const aiQuaternion& start = keys[i].mValue;
-   const aiQuaternion& end   = keys[i + 1].mValue;
-   aiQuaternion::Interpolate(out, start, end, factor);
-   out = out.Normalize();
-}
-
-void AnimatedMeshRenderer::calcInterpolatedScaling(
-                                                aiVector3D& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mScalingKeys;
-   const auto& numKeys = node_anim->mNumScalingKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findRotation(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
-
-   const aiVector3D& start = keys[i].mValue;
-   const aiVector3D& end   = keys[i + 1].mValue;
-   out = mix(start, end, factor);
-}
-
-const aiNodeAnim* AnimatedMeshRenderer::findNodeAnim(const aiAnimation* animation,
-                                                     const std::string node_name) {
-   for (unsigned i = 0; i < animation->mNumChannels; i++) {
-      const aiNodeAnim* node_anim = animation->mChannels[i];
-      if (std::string(node_anim->mNodeName.data) == node_name) {
-         return node_anim;
-      }
-   }
-   return nullptr;
-}
+}  // namespace
 
 void AnimatedMeshRenderer::updateBoneTree(Animation& anim,
-                                          float anim_time,
+                                          const AnimationClip::Transform* pose,
                                           const aiNode* node,
                                           const glm::mat4& parent_transform) {
-   std::string node_name(node->mName.data);
-   const aiAnimation* animation = anim.current_anim_.handle->mAnimations[0];
-   const aiNodeAnim* node_anim = findNodeAnim(animation, node_name);
+   const auto& node_channels = anims_[anim.current_anim_.idx].node_channels;
+   auto channel_iter = node_channels.find(node);
    glm::mat4 local_transform = engine::convertMatrix(node->mTransformation);
 
-   if (node_anim) {
-      // Interpolate the transformations and get the matrices
-      aiVector3D scaling;
-      calcInterpolatedScaling(scaling, anim_time, node_anim);
-      glm::mat4 scalingM = glm::scale(glm::mat4(), glm::vec3(scaling.x, scaling.y, scaling.z));
-
-      aiQuaternion rotation;
-      calcInterpolatedRotation(rotation, anim_time, node_anim);
-      glm::mat4 rotationM = engine::convertMatrix(rotation.GetMatrix());
-
-      aiVector3D translation;
-      calcInterpolatedPosition(translation, anim_time, node_anim);
-      glm::mat4 translationM;
+   if (channel_iter != node_channels.end()) {
+      const AnimationClip::Transform& transform = pose[channel_iter->second];
+      glm::vec3 translation = transform.translation;
 
-      if (node_name == skinning_data_.root_bone) {
+      if (skinning_data_.root_bone == node->mName.data) {
          anim.current_anim_.offset = glm::vec3(translation.x, 0, translation.z);
          if (anim.current_anim_.flags.test(AnimFlag::Mirrored)) {
             anim.current_anim_.offset *= -1;
          }
-         translationM = glm::translate(glm::mat4(), glm::vec3(0, translation.y, 0));
-      } else {
-         translationM = glm::translate(glm::mat4(), glm::vec3(translation.x, translation.y, translation.z));
+         translation = glm::vec3(0, translation.y, 0);
       }
-      // Combine the transformations
-      local_transform = translationM * rotationM * scalingM;
+      local_transform = TransformMatrix(translation, transform.rotation,
+                                        transform.scaling);
    }
 
    glm::mat4 global_transform = parent_transform * local_transform;
 
-   if (skinning_data_.bone_mapping.find(node_name) != skinning_data_.bone_mapping.end()) {
-      unsigned bone_idx = skinning_data_.bone_mapping[node_name];
+   auto bone_iter = skinning_data_.node_bones.find(node);
+   if (bone_iter != skinning_data_.node_bones.end()) {
+      unsigned bone_idx = bone_iter->second;
       if (skinning_data_.bone_info[bone_idx].external == false) {
          skinning_data_.bone_info[bone_idx].final_transform =
             global_transform * skinning_data_.bone_info[bone_idx].bone_offset;
@@ -165,64 +57,50 @@ void AnimatedMeshRenderer::updateBoneTree(Animation& anim,
       }
    }
    for (unsigned i = 0; i < node->mNumChildren; i++) {
-      updateBoneTree(anim, anim_time, node->mChildren[i], global_transform);
+      updateBoneTree(anim, pose, node->mChildren[i], global_transform);
    }
 }
 
 void AnimatedMeshRenderer::updateBoneTreeInTransition(
                                              Animation& anim,
-                                             float prev_anim_time,
-                                             float next_anim_time,
+                                             const AnimationClip::Transform* prev_pose,
+                                             const AnimationClip::Transform* next_pose,
                                              float factor,
                                              const aiNode* node,
                                              const glm::mat4& parent_transform) {
-   std::string node_name(node->mName.data);
-   const aiAnimation* prev_animation = anim.last_anim_.handle->mAnimations[0];
-   const aiAnimation* next_animation = anim.current_anim_.handle->mAnimations[0];
-   const aiNodeAnim* prev_node_anim = findNodeAnim(prev_animation, node_name);
-   const aiNodeAnim* next_node_anim = findNodeAnim(next_animation, node_name);
+   const auto& prev_channels = anims_[anim.last_anim_.idx].node_channels;
+   const auto& next_channels = anims_[anim.current_anim_.idx].node_channels;
+   auto prev_iter = prev_channels.find(node);
+   auto next_iter = next_channels.find(node);
 
    glm::mat4 local_transform = engine::convertMatrix(node->mTransformation);
 
-   if (prev_node_anim && next_node_anim) {
-      // Interpolate the transformations and get the matrices
-      aiVector3D prev_scaling, next_scaling;
-      calcInterpolatedScaling(prev_scaling, prev_anim_time, prev_node_anim);
-      calcInterpolatedScaling(next_scaling, next_anim_time, next_node_anim);
-      aiVector3D scaling = mix(prev_scaling, next_scaling, factor);
-      glm::mat4 scalingM = glm::scale(glm::mat4(), glm::vec3(scaling.x, scaling.y, scaling.z));
-
-      aiQuaternion prev_rotation, next_rotation, rotation;
-      calcInterpolatedRotation(prev_rotation, prev_anim_time, prev_node_anim);
-      calcInterpolatedRotation(next_rotation, next_anim_time, next_node_anim);
+   if (prev_iter != prev_channels.end() && next_iter != next_channels.end()) {
+      const AnimationClip::Transform& prev = prev_pose[prev_iter->second];
+      const AnimationClip::Transform& next = next_pose[next_iter->second];
 
+      glm::vec3 scaling = glm::mix(prev.scaling, next.scaling, factor);
       // Spherical linear interpolation, that chooses the shorter path.
-      aiQuaternion::Interpolate(rotation, prev_rotation, next_rotation, factor);
-      glm::mat4 rotationM = engine::convertMatrix(rotation.GetMatrix());
+      glm::quat rotation = glm::slerp(prev.rotation, next.rotation, factor);
+      glm::vec3 translation =
+         glm::mix(prev.translation, next.translation, factor);
 
-      aiVector3D prev_translation, next_translation;
-      calcInterpolatedPosition(prev_translation, prev_anim_time, prev_node_anim);
-      calcInterpolatedPosition(next_translation, next_anim_time, next_node_anim);
-      aiVector3D translation = mix(prev_translation, next_translation, factor);
-      glm::mat4 translationM;
-      if (node_name == skinning_data_.root_bone) {
+      if (skinning_data_.root_bone == node->mName.data) {
          anim.current_anim_.offset =
-            glm::vec3(next_translation.x, 0, next_translation.z);
+            glm::vec3(next.translation.x, 0, next.translation.z);
          if (anim.current_anim_.flags.test(AnimFlag::Mirrored)) {
             anim.current_anim_.offset *= -1;
          }
-         translationM = glm::translate(glm::mat4(), glm::vec3(0, translation.y, 0));
-      } else {
-         translationM = glm::translate(glm::mat4(), glm::vec3(translation.x, translation.y, translation.z));
+         translation = glm::vec3(0, translation.y, 0);
       }
-      // Combine the transformations
-      local_transform = translationM * rotationM * scalingM;
+      local_transform = TransformMatrix(translation, rotation, scaling);
    }
 
    glm::mat4 global_transform = parent_transform * local_transform;
 
-   if (skinning_data_.bone_mapping.find(node_name) != skinning_data_.bone_mapping.end()) {
-      unsigned bone_idx = skinning_data_.bone_mapping[node_name];
+   auto bone_iter = skinning_data_.node_bones.find(node);
+   if (bone_iter != skinning_data_.node_bones.end()) {
+      unsigned bone_idx = bone_iter->second;
       if (skinning_data_.bone_info[bone_idx].external == false) {
          skinning_data_.bone_info[bone_idx].final_transform =
             global_transform * skinning_data_.bone_info[bone_idx].bone_offset;
@@ -235,7 +113,7 @@ void AnimatedMeshRenderer::updateBoneTreeInTransition(
    }
    for (unsigned i = 0; i < node->mNumChildren; i++) {
       updateBoneTreeInTransition(
-         anim, prev_anim_time, next_anim_time, factor,
+         anim, prev_pose, next_pose, factor,
          node->mChildren[i], global_transform
       );
    }
@@ -243,33 +121,34 @@ void AnimatedMeshRenderer::updateBoneTreeInTransition(
 
 void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
                                           float time) {
-   if (!anim.current_anim_.handle || anim.current_anim_.handle->mAnimations == 0
-      || !anim.last_anim_.handle || anim.last_anim_.handle->mAnimations == 0) {
+   if (!anim.current_anim_.handle || !anim.last_anim_.handle) {
       throw std::runtime_error("Tried to run an invalid animation.");
    }
+   const AnimationClip& last_clip = *anim.last_anim_.handle;
+   const AnimationClip& current_clip = *anim.current_anim_.handle;
 
-   float last_ticks_per_second = anim.last_anim_.handle->mAnimations[0]->mTicksPerSecond > 1e-10 ? // != 0
-                                 anim.last_anim_.handle->mAnimations[0]->mTicksPerSecond : 24.0f;
+   float last_ticks_per_second = last_clip.ticks_per_second() > 1e-10 ? // != 0
+                                 last_clip.ticks_per_second() : 24.0f;
    float last_time_in_ticks = anim.anim_meta_info_.last_period_time * (anim.last_anim_.speed * last_ticks_per_second);
    float last_anim_time;
    if (anim.last_anim_.flags.test(AnimFlag::Repeat)) {
-      last_anim_time = fmod(last_time_in_ticks, (float)anim.last_anim_.handle->mAnimations[0]->mDuration);
+      last_anim_time = fmod(last_time_in_ticks, last_clip.duration());
    } else {
-      last_anim_time = std::min(last_time_in_ticks, (float)anim.last_anim_.handle->mAnimations[0]->mDuration);
+      last_anim_time = std::min(last_time_in_ticks, last_clip.duration());
    }
    if (anim.last_anim_.flags.test(AnimFlag::Backwards)) {
-      last_anim_time = (float)anim.last_anim_.handle->mAnimations[0]->mDuration - last_anim_time;
+      last_anim_time = last_clip.duration() - last_anim_time;
    }
 
-   float current_ticks_per_second = anim.current_anim_.handle->mAnimations[0]->mTicksPerSecond > 1e-10 ? // != 0
-                                    anim.current_anim_.handle->mAnimations[0]->mTicksPerSecond : 24.0f;
+   float current_ticks_per_second = current_clip.ticks_per_second() > 1e-10 ? // != 0
+                                    current_clip.ticks_per_second() : 24.0f;
    float current_time_in_ticks =
       (time - anim.anim_meta_info_.end_of_last_anim) * (anim.current_anim_.speed * current_ticks_per_second);
    float current_anim_time;
    if (anim.current_anim_.flags.test(AnimFlag::Repeat)) {
-      current_anim_time = fmod(current_time_in_ticks, (float)anim.current_anim_.handle->mAnimations[0]->mDuration);
+      current_anim_time = fmod(current_time_in_ticks, current_clip.duration());
    } else {
-      if (current_time_in_ticks < (float)anim.current_anim_.handle->mAnimations[0]->mDuration) {
+      if (current_time_in_ticks < current_clip.duration()) {
          current_anim_time = current_time_in_ticks;
       } else {
          anim.animationEnded(time);
@@ -279,7 +158,7 @@ void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
    }
 
    if (anim.current_anim_.flags.test(AnimFlag::Backwards)) {
-      current_anim_time = (float)anim.current_anim_.handle->mAnimations[0]->mDuration - current_anim_time;
+      current_anim_time = current_clip.duration() - current_anim_time;
    }
 
    bool in_transition =
@@ -287,19 +166,26 @@ void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
    float transition_factor =
       (time - anim.anim_meta_info_.end_of_last_anim) / anim.anim_meta_info_.transition_time;
 
+   // Every channel is sampled at once, reading a single segment of the clip
+   FrameArena::Scope frame_arena_scope;
+   FrameVector<AnimationClip::Transform> current_pose(
+      current_clip.num_channels());
+   current_clip.sample(current_anim_time, current_pose.data());
+
    if (in_transition) {
       // Normal animation
-      updateBoneTree(anim, current_anim_time, scene_->mRootNode);
+      updateBoneTree(anim, current_pose.data(), scene_->mRootNode);
    } else {
       // Transition between two animations.
-      updateBoneTreeInTransition(anim, last_anim_time, current_anim_time,
+      FrameVector<AnimationClip::Transform> last_pose(last_clip.num_channels());
+      last_clip.sample(last_anim_time, last_pose.data());
+      updateBoneTreeInTransition(anim, last_pose.data(), current_pose.data(),
                                  transition_factor, scene_->mRootNode);
    }
 
    // Start a new loop if necessary
    if (anim.current_anim_.flags.test(AnimFlag::Repeat)) {
-      unsigned loop_count = current_time_in_ticks /
-                        (float)anim.current_anim_.handle->mAnimations[0]->mDuration;
+      unsigned loop_count = current_time_in_ticks / current_clip.duration();
       if (loop_count > anim.anim_meta_info_.last_loop_count) {
          if (anim.current_anim_.flags.test(AnimFlag::MirroredRepeat)) {
             anim.current_anim_.flags ^= AnimFlag::Mirrored;
@@ -330,6 +216,20 @@ void AnimatedMeshRenderer::uploadBoneInfo(
   }
 }
 
+void AnimatedMeshRenderer::copyBoneInfo(std::vector<glm::mat4>* bones) const {
+  bones->resize(skinning_data_.num_bones);
+  for (unsigned i = 0; i < skinning_data_.num_bones; i++) {
+      (*bones)[i] = skinning_data_.bone_info[i].final_transform;
+  }
+}
+
+void AnimatedMeshRenderer::UploadBoneInfo(const std::vector<glm::mat4>& pose,
+                                          gl::LazyUniform<glm::mat4>& bones) {
+  for (size_t i = 0; i < pose.size(); i++) {
+      bones[i] = pose[i];
+  }
+}
+
 void AnimatedMeshRenderer::updateAndUploadBoneInfo(
                                     Animation& anim,
                                     float time,
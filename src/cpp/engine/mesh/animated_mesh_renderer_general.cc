@@ -1,5 +1,6 @@
 // Copyright (c) 2014, Tamas Csala
 
+#include <utility>
 #include "animated_mesh_renderer.h"
 
 namespace engine {
@@ -7,45 +8,64 @@ namespace engine {
 AnimatedMeshRenderer::AnimatedMeshRenderer(
                                   const std::string& filename,
                                   gl::Bitfield<aiPostProcessSteps> flags)
-  : MeshRenderer(filename, flags)
-  , skinning_data_(scene_->mNumMeshes) {
+  : MeshRenderer(filename, flags) {
+  mapBones();
+}
+
+AnimatedMeshRenderer::AnimatedMeshRenderer(ImportedModel model)
+  : MeshRenderer(std::move(model)) {
+  mapBones();
 }
 
 void AnimatedMeshRenderer::addAnimation(const std::string& filename,
                                         const std::string& anim_name,
                                         gl::Bitfield<AnimFlag> flags,
                                         float speed) {
+  addAnimation(AnimationClip::Load(filename), anim_name, flags, speed);
+}
+
+void AnimatedMeshRenderer::addAnimation(
+    std::shared_ptr<const AnimationClip> clip, const std::string& anim_name,
+    gl::Bitfield<AnimFlag> flags, float speed) {
   if (anims_.canFind(anim_name)) {
     throw std::runtime_error(
-      "Animation name '" + anim_name + "' isn't unique for '" + filename + "'"
+      "Animation name '" + anim_name + "' isn't unique."
     );
   }
-  size_t idx = anims_.data.size();
-  anims_.names[anim_name] = idx;
-  anims_.data.push_back(AnimInfo());
-  anims_[idx].name = anim_name;
-  anims_[idx].handle = anims_[idx].importer->ReadFile(filename, aiProcess_Debone);
-  if (!anims_[idx].handle) {
-    throw std::runtime_error("Error parsing " + filename
-                              + " : " + anims_[idx].importer->GetErrorString());
-  }
 
-  auto node = getRootBone(scene_->mRootNode, anims_[idx].handle);
-  if (!node) {
+  int root_channel = getRootBone(scene_->mRootNode, *clip);
+  if (root_channel < 0) {
     throw std::runtime_error(
       "Animation error: The mesh's skeleton, and the animated skeleton '"
       + anim_name + "' doesn't have a single bone in common."
     );
   }
 
-  aiVector3D v = node->mPositionKeys[0].mValue;
-  anims_[idx].start_offset = glm::vec3(v.x, v.y, v.z);
+  size_t idx = anims_.data.size();
+  anims_.names[anim_name] = idx;
+  anims_.data.push_back(AnimInfo());
+  anims_[idx].name = anim_name;
+  anims_[idx].handle = clip.get();
+  mapNodeChannels(scene_->mRootNode, &anims_[idx]);
 
-  v = node->mPositionKeys[node->mNumPositionKeys - 1].mValue;
-  anims_[idx].end_offset =  glm::vec3(v.x, v.y, v.z);
+  anims_[idx].start_offset = clip->sample(root_channel, 0).translation;
+  anims_[idx].end_offset =
+      clip->sample(root_channel, clip->duration()).translation;
 
+  anims_[idx].clip = std::move(clip);
   anims_[idx].flags = flags;
   anims_[idx].speed = speed;
 }
 
+void AnimatedMeshRenderer::mapNodeChannels(const aiNode* node,
+                                           AnimInfo* anim) {
+  int channel = anim->handle->findChannel(node->mName.data);
+  if (channel >= 0) {
+    anim->node_channels[node] = channel;
+  }
+  for (unsigned i = 0; i < node->mNumChildren; ++i) {
+    mapNodeChannels(node->mChildren[i], anim);
+  }
+}
+
 } // namespace engine
@@ -9,7 +9,7 @@ namespace engine {
 
 /// Fills the bone_mapping with data.
 void AnimatedMeshRenderer::mapBones() {
-  for (size_t entry = 0; entry < entries_.size(); entry++) {
+  for (size_t entry = 0; entry < scene_->mNumMeshes; entry++) {
     const aiMesh* mesh = scene_->mMeshes[entry];
 
     for (size_t i = 0; i < mesh->mNumBones; i++) {
@@ -28,6 +28,18 @@ void AnimatedMeshRenderer::mapBones() {
       }
     }
   }
+
+  mapBoneNodes(scene_->mRootNode);
+}
+
+void AnimatedMeshRenderer::mapBoneNodes(const aiNode* node) {
+  auto iter = skinning_data_.bone_mapping.find(node->mName.data);
+  if (iter != skinning_data_.bone_mapping.end()) {
+    skinning_data_.node_bones[node] = iter->second;
+  }
+  for (size_t i = 0; i < node->mNumChildren; i++) {
+    mapBoneNodes(node->mChildren[i]);
+  }
 }
 
 /**
@@ -37,14 +49,13 @@ void AnimatedMeshRenderer::mapBones() {
  * @param node   The current root node.
  * @param anim   The animation to seek the root bone in.
  */
-const aiNodeAnim* AnimatedMeshRenderer::getRootBone(const aiNode* node,
-                                                    const aiScene* anim) {
+int AnimatedMeshRenderer::getRootBone(const aiNode* node,
+                                      const AnimationClip& anim) {
   std::string node_name(node->mName.data);
 
-  const aiAnimation* animation = anim->mAnimations[0];
-  const aiNodeAnim* node_anim = findNodeAnim(animation, node_name);
+  int channel = anim.findChannel(node_name);
 
-  if (node_anim) {
+  if (channel >= 0) {
     if (skinning_data_.root_bone.empty()) {
       skinning_data_.root_bone = node_name;
     } else {
@@ -53,17 +64,17 @@ const aiNodeAnim* AnimatedMeshRenderer::getRootBone(const aiNode* node,
                                  "different root bones.");
       }
     }
-    return node_anim;
+    return channel;
   } else {
     for (size_t i = 0; i < node->mNumChildren; i++) {
-      auto childsReturn = getRootBone(node->mChildren[i], anim);
-      if (childsReturn) {
+      int childsReturn = getRootBone(node->mChildren[i], anim);
+      if (childsReturn >= 0) {
         return childsReturn;
       }
     }
   }
 
-  return nullptr;
+  return -1;
 }
 
 template <typename Index_t>
@@ -76,6 +87,8 @@ void AnimatedMeshRenderer::loadBones() {
   const size_t per_attrib_size =
       sizeof(SkinningData::VertexBoneData_PerAttribute<Index_t>);
 
+  createEntries();
+  skinning_data_.vertex_bone_data_buffers.resize(entries_.size());
   skinning_data_.per_mesh_attrib_max.resize(entries_.size());
 
   for (size_t entry = 0; entry < entries_.size(); entry++) {
@@ -146,6 +159,7 @@ void AnimatedMeshRenderer::loadBones() {
 
     // upload
     skinning_data_.vertex_bone_data_buffers[entry].data(buffer_size, data.get());
+    buffer_memory_.add(buffer_size);
   }
 
   // Unbind our things, so they won't be modified from outside
@@ -160,8 +174,6 @@ void AnimatedMeshRenderer::loadBones() {
  * with the appropriate template parameter
  */
 void AnimatedMeshRenderer::createBonesData() {
-  mapBones();
-
   if (skinning_data_.num_bones < std::numeric_limits<GLubyte>::max()) {
     loadBones<GLubyte>();
   } else if (skinning_data_.num_bones < std::numeric_limits<GLushort>::max()) {
@@ -321,14 +333,7 @@ ExternalBoneTree AnimatedMeshRenderer::markBoneExternal(
 }
 
 /// Returns the number of bones this scene has.
-/** May change the currently active VAO and ArrayBuffer at the first call. */
 size_t AnimatedMeshRenderer::getNumBones() {
-  // If loadBones hasn't been called yet, than have to create
-  // the bones data first to know the number of bones.
-  if (skinning_data_.per_mesh_attrib_max.size() == 0) {
-    createBonesData();
-  }
-
   return skinning_data_.num_bones;
 }
 
@@ -32,7 +32,7 @@ public:
     : anims_(anim_data) {}
 
   /// Returns the currently running animation's name.
-  std::string getCurrentAnimation() const {
+  const std::string& getCurrentAnimation() const {
     return current_anim_name_;
   }
 
@@ -52,7 +52,7 @@ public:
   }
 
   /// Returns the name of the default animation
-  std::string getDefaultAnim() const {
+  const std::string& getDefaultAnim() const {
     return anims_[anim_meta_info_.default_idx].name;
   }
 
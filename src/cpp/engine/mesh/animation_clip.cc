@@ -0,0 +1,522 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./animation_clip.h"
+#include "./imported_model.h"
+#include "../mapped_file.h"
+#include "../binary_stream.h"
+#include "../game_engine.h"
+#include "../debug/profiler.h"
+
+namespace engine {
+
+namespace {
+
+const char kMagic[4] = {'L', 'A', 'N', 'M'};
+const std::uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  float duration, ticks_per_second, segment_length;
+  std::uint32_t num_channels, num_segments, data_size;
+};
+
+// The keys that interpolation can reproduce within these are dropped.
+const float kTranslationTolerance = 1e-3f;  // in the model's units
+const float kRotationTolerance = 1e-3f;  // in radians
+const float kScalingTolerance = 1e-4f;
+
+// The time range of a segment.
+const float kSegmentSeconds = 0.5f;
+
+// A key is the time, and three quantized components. The tracks (the
+// translation, rotation and scaling keys of a channel) in a segment are the
+// number of keys (as an uint16), followed by the keys.
+const size_t kKeySize = sizeof(float) + 3*sizeof(std::uint16_t);
+const size_t kMaxKeysPerTrack = 0xFFFF;
+
+template <typename T>
+struct Key {
+  float time;
+  T value;
+};
+
+struct Range {
+  glm::vec3 min, step;
+};
+
+glm::vec3 Interpolate(const glm::vec3& a, const glm::vec3& b, float t) {
+  return glm::mix(a, b, t);
+}
+
+glm::quat Interpolate(const glm::quat& a, const glm::quat& b, float t) {
+  return glm::normalize(glm::slerp(a, b, t));  // it takes the shorter path
+}
+
+float Distance(const glm::vec3& a, const glm::vec3& b) {
+  return glm::length(a - b);
+}
+
+// The angle of the rotation between them.
+float Distance(const glm::quat& a, const glm::quat& b) {
+  return 2 * std::acos(std::min(std::abs(glm::dot(a, b)), 1.0f));
+}
+
+// Keeps the first and the last key, and those that can't be interpolated
+// from the kept keys around them within the tolerance.
+template <typename T>
+std::vector<Key<T>> ReduceKeys(const std::vector<Key<T>>& keys,
+                               float tolerance) {
+  if (keys.empty()) { return keys; }
+  std::vector<Key<T>> kept{keys.front()};
+  size_t last_kept = 0;
+  for (size_t i = 1; i + 1 < keys.size(); ++i) {
+    // Could the keys since the last kept one be dropped, if this one was?
+    const Key<T>& begin = keys[last_kept];
+    const Key<T>& end = keys[i + 1];
+    float length = end.time - begin.time;
+    bool fits = true;
+    for (size_t j = last_kept + 1; j <= i && fits; ++j) {
+      float factor = length > 0 ? (keys[j].time - begin.time) / length : 0;
+      fits = Distance(Interpolate(begin.value, end.value, factor),
+                      keys[j].value) <= tolerance;
+    }
+    if (!fits) {
+      kept.push_back(keys[i]);
+      last_kept = i;
+    }
+  }
+  kept.push_back(keys.back());
+
+  // A constant track needs a single key
+  if (kept.size() == 2 &&
+      Distance(kept[0].value, kept[1].value) <= tolerance) {
+    kept.pop_back();
+  }
+  return kept;
+}
+
+Range QuantizationRange(const std::vector<Key<glm::vec3>>& keys) {
+  if (keys.empty()) { return Range{glm::vec3{}, glm::vec3{}}; }
+  glm::vec3 mins = keys[0].value, maxes = keys[0].value;
+  for (const auto& key : keys) {
+    mins = glm::min(mins, key.value);
+    maxes = glm::max(maxes, key.value);
+  }
+  return Range{mins, (maxes - mins) / float(0xFFFF)};
+}
+
+void Quantize(const glm::vec3& value, const Range& range,
+              std::uint16_t* out) {
+  for (int i = 0; i < 3; ++i) {
+    float quantized = range.step[i] > 0
+        ? std::round((value[i] - range.min[i]) / range.step[i]) : 0;
+    out[i] = std::uint16_t(glm::clamp(quantized, 0.0f, float(0xFFFF)));
+  }
+}
+
+glm::vec3 Dequantize(const std::uint16_t* in, const glm::vec3& min,
+                     const glm::vec3& step) {
+  return min + glm::vec3(in[0], in[1], in[2]) * step;
+}
+
+// The largest component of a unit quaternion can be calculated from the
+// other three, which are in [-1/sqrt(2), 1/sqrt(2)]. These are stored on 15
+// bits each, along with the index of the largest one on 2 bits.
+const float kSqrt2 = 1.41421356f;
+const std::uint64_t kComponentMax = (1 << 15) - 1;
+
+void Quantize(glm::quat rotation, std::uint16_t* out) {
+  rotation = glm::normalize(rotation);
+  float components[4] = {rotation.x, rotation.y, rotation.z, rotation.w};
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (std::abs(components[i]) > std::abs(components[largest])) {
+      largest = i;
+    }
+  }
+  // q and -q are the same rotation, the largest one is made positive
+  float sign = components[largest] < 0 ? -1.0f : 1.0f;
+  std::uint64_t bits = largest;
+  int shift = 2;
+  for (int i = 0; i < 4; ++i) {
+    if (i == largest) { continue; }
+    float normalized = (sign * components[i] * kSqrt2 + 1) / 2;
+    float quantized = std::round(normalized * kComponentMax);
+    bits |= std::uint64_t(glm::clamp(quantized, 0.0f, float(kComponentMax)))
+            << shift;
+    shift += 15;
+  }
+  out[0] = bits & 0xFFFF;
+  out[1] = (bits >> 16) & 0xFFFF;
+  out[2] = (bits >> 32) & 0xFFFF;
+}
+
+glm::quat DequantizeRotation(const std::uint16_t* in) {
+  std::uint64_t bits = std::uint64_t(in[0]) | (std::uint64_t(in[1]) << 16) |
+                       (std::uint64_t(in[2]) << 32);
+  int largest = bits & 3;
+  float components[4];
+  float sum_squares = 0;
+  int shift = 2;
+  for (int i = 0; i < 4; ++i) {
+    if (i == largest) { continue; }
+    float normalized = float((bits >> shift) & kComponentMax) / kComponentMax;
+    components[i] = (normalized * 2 - 1) / kSqrt2;
+    sum_squares += components[i] * components[i];
+    shift += 15;
+  }
+  components[largest] = std::sqrt(std::max(1 - sum_squares, 0.0f));
+  return glm::quat(components[3], components[0], components[1],
+                   components[2]);
+}
+
+template <typename T, typename Quantizer>
+void WriteTrack(const std::vector<Key<T>>& keys, float begin, float end,
+                const Quantizer& quantize, std::vector<unsigned char>* out) {
+  // The last key before the segment, the keys in it, and the first after it
+  size_t first = 0, last = keys.empty() ? 0 : keys.size() - 1;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i].time <= begin) { first = i; }
+  }
+  for (size_t i = keys.size(); i-- > first;) {
+    if (keys[i].time >= end) { last = i; }
+  }
+  size_t count = keys.empty() ? 0 : last - first + 1;
+  if (count > kMaxKeysPerTrack) {
+    throw std::runtime_error("Too many keys in an animation segment.");
+  }
+
+  std::uint16_t count16 = count;
+  size_t offset = out->size();
+  out->resize(offset + sizeof(count16) + count * kKeySize);
+  unsigned char* data = out->data() + offset;
+  std::memcpy(data, &count16, sizeof(count16));
+  data += sizeof(count16);
+  for (size_t i = first; i < first + count; ++i) {
+    std::uint16_t value[3];
+    quantize(keys[i].value, value);
+    std::memcpy(data, &keys[i].time, sizeof(float));
+    std::memcpy(data + sizeof(float), value, sizeof(value));
+    data += kKeySize;
+  }
+}
+
+float KeyTime(const unsigned char* key) {
+  float time;
+  std::memcpy(&time, key, sizeof(time));
+  return time;
+}
+
+struct KeyValue {
+  std::uint16_t components[3];
+};
+
+KeyValue KeyValueOf(const unsigned char* key) {
+  KeyValue value;
+  std::memcpy(value.components, key + sizeof(float), sizeof(value));
+  return value;
+}
+
+// Interpolates a track at a time, and moves the data to the next track.
+// The decoder makes a T from a KeyValue.
+template <typename T, typename Decode>
+T SampleTrack(const unsigned char** data, float time, const T& default_value,
+              const Decode& decode) {
+  std::uint16_t count;
+  std::memcpy(&count, *data, sizeof(count));
+  const unsigned char* keys = *data + sizeof(count);
+  *data = keys + count * kKeySize;
+
+  if (count == 0) { return default_value; }
+  if (count == 1) { return decode(KeyValueOf(keys)); }
+
+  // The keys before the first and after the last one are clamped
+  size_t i = 0;
+  while (i + 2 < count && KeyTime(keys + (i + 1)*kKeySize) < time) {
+    ++i;
+  }
+  const unsigned char* begin = keys + i*kKeySize;
+  const unsigned char* end = begin + kKeySize;
+  float length = KeyTime(end) - KeyTime(begin);
+  float factor = length > 0 ? (time - KeyTime(begin)) / length : 0;
+  return Interpolate(decode(KeyValueOf(begin)), decode(KeyValueOf(end)),
+                     glm::clamp(factor, 0.0f, 1.0f));
+}
+
+void SkipTrack(const unsigned char** data) {
+  std::uint16_t count;
+  std::memcpy(&count, *data, sizeof(count));
+  *data += sizeof(count) + count * kKeySize;
+}
+
+}  // namespace
+
+AnimationClip::AnimationClip(const aiScene* scene) {
+  if (!scene->mNumAnimations) {
+    throw std::runtime_error("The scene doesn't have any animation.");
+  }
+  const aiAnimation* animation = scene->mAnimations[0];
+  duration_ = animation->mDuration;
+  ticks_per_second_ = animation->mTicksPerSecond;
+  segment_length_ = kSegmentSeconds *
+      (ticks_per_second_ > 1e-10 ? ticks_per_second_ : 24.0f);
+
+  std::vector<std::vector<Key<glm::vec3>>> translations, scalings;
+  std::vector<std::vector<Key<glm::quat>>> rotations;
+  for (unsigned i = 0; i < animation->mNumChannels; ++i) {
+    const aiNodeAnim* node_anim = animation->mChannels[i];
+    std::vector<Key<glm::vec3>> translation, scaling;
+    std::vector<Key<glm::quat>> rotation;
+    for (unsigned j = 0; j < node_anim->mNumPositionKeys; ++j) {
+      const aiVectorKey& key = node_anim->mPositionKeys[j];
+      translation.push_back({float(key.mTime),
+                             glm::vec3(key.mValue.x, key.mValue.y,
+                                       key.mValue.z)});
+    }
+    for (unsigned j = 0; j < node_anim->mNumRotationKeys; ++j) {
+      const aiQuatKey& key = node_anim->mRotationKeys[j];
+      rotation.push_back({float(key.mTime),
+                          glm::normalize(glm::quat(key.mValue.w, key.mValue.x,
+                                                   key.mValue.y,
+                                                   key.mValue.z))});
+    }
+    for (unsigned j = 0; j < node_anim->mNumScalingKeys; ++j) {
+      const aiVectorKey& key = node_anim->mScalingKeys[j];
+      scaling.push_back({float(key.mTime),
+                         glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)});
+    }
+
+    translations.push_back(ReduceKeys(translation, kTranslationTolerance));
+    rotations.push_back(ReduceKeys(rotation, kRotationTolerance));
+    scalings.push_back(ReduceKeys(scaling, kScalingTolerance));
+
+    Range translation_range = QuantizationRange(translations.back());
+    Range scaling_range = QuantizationRange(scalings.back());
+    channels_.push_back(Channel{node_anim->mNodeName.data,
+                                translation_range.min, translation_range.step,
+                                scaling_range.min, scaling_range.step});
+  }
+
+  size_t num_segments = std::max(1.0f, std::ceil(duration_ / segment_length_));
+  for (size_t segment = 0; segment < num_segments; ++segment) {
+    segment_offsets_.push_back(data_.size());
+    float begin = segment * segment_length_, end = begin + segment_length_;
+    for (size_t i = 0; i < channels_.size(); ++i) {
+      const Channel& channel = channels_[i];
+      WriteTrack<glm::vec3>(translations[i], begin, end,
+          [&channel](const glm::vec3& value, std::uint16_t* out) {
+        Quantize(value, Range{channel.translation_min,
+                              channel.translation_step}, out);
+      }, &data_);
+      WriteTrack<glm::quat>(rotations[i], begin, end,
+          [](const glm::quat& value, std::uint16_t* out) {
+        Quantize(value, out);
+      }, &data_);
+      WriteTrack<glm::vec3>(scalings[i], begin, end,
+          [&channel](const glm::vec3& value, std::uint16_t* out) {
+        Quantize(value, Range{channel.scaling_min, channel.scaling_step}, out);
+      }, &data_);
+    }
+  }
+  segment_offsets_.push_back(data_.size());
+}
+
+std::shared_ptr<const AnimationClip> AnimationClip::Load(
+    const std::string& filename) {
+  // The characters that play the same animation share its clip
+  return GameEngine::asset_cache()->get<AnimationClip>(filename, [&]() {
+    std::string cooked_path = CookedPath(filename);
+    std::unique_ptr<AnimationClip> clip;
+    if (MappedFile::ModificationTime(filename) <=
+        MappedFile::ModificationTime(cooked_path)) {
+      clip = LoadCooked(cooked_path);
+    }
+    if (!clip) {
+      ENGINE_PROFILE("cook animation");
+      ImportedModel model = ImportModel(filename, aiProcess_Debone);
+      clip.reset(new AnimationClip{model.scene});
+      // The clip is already built, so this isn't fatal, just slow next time
+      if (!clip->save(cooked_path)) {
+        std::cerr << "Couldn't write the cooked animation " << cooked_path
+                  << std::endl;
+      }
+    }
+    clip->memory_ = debug::MemoryTracker::Allocation{"animation", filename,
+        debug::MemoryTracker::Category::kCpu, clip->size()};
+    return clip;
+  });
+}
+
+std::string AnimationClip::CookedPath(const std::string& filename) {
+  return filename + ".clip.cooked";
+}
+
+std::unique_ptr<AnimationClip> AnimationClip::LoadCooked(
+    const std::string& cooked_path) {
+  ENGINE_PROFILE("load cooked animation");
+  MappedFile file;
+  try {
+    file = MappedFile{cooked_path};
+  } catch (const std::runtime_error&) {
+    return nullptr;
+  }
+
+  std::unique_ptr<AnimationClip> clip{new AnimationClip};
+  try {
+    BinaryReader in{file.data(), file.size()};
+    auto header = in.value<Header>();
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion) {
+      throw std::runtime_error("wrong version");
+    }
+    if (!(header.segment_length > 0) || header.num_segments == 0 ||
+        header.num_channels > file.size() ||
+        header.num_segments > file.size()) {
+      throw std::runtime_error("invalid header");
+    }
+    clip->duration_ = header.duration;
+    clip->ticks_per_second_ = header.ticks_per_second;
+    clip->segment_length_ = header.segment_length;
+
+    for (unsigned i = 0; i < header.num_channels; ++i) {
+      Channel channel;
+      channel.node_name = in.string();
+      channel.translation_min = in.value<glm::vec3>();
+      channel.translation_step = in.value<glm::vec3>();
+      channel.scaling_min = in.value<glm::vec3>();
+      channel.scaling_step = in.value<glm::vec3>();
+      clip->channels_.push_back(channel);
+    }
+
+    const std::uint32_t* offsets =
+        in.array<std::uint32_t>(header.num_segments + 1);
+    clip->segment_offsets_.assign(offsets, offsets + header.num_segments + 1);
+    const unsigned char* data = in.array<unsigned char>(header.data_size);
+    clip->data_.assign(data, data + header.data_size);
+    if (!in.done()) {
+      throw std::runtime_error("unexpected data at the end");
+    }
+
+    // Every segment has to be exactly the tracks of every channel
+    if (clip->segment_offsets_.front() != 0 ||
+        clip->segment_offsets_.back() != header.data_size) {
+      throw std::runtime_error("invalid segments");
+    }
+    for (unsigned i = 0; i < header.num_segments; ++i) {
+      size_t offset = clip->segment_offsets_[i];
+      size_t end = clip->segment_offsets_[i + 1];
+      for (unsigned j = 0; j < 3 * header.num_channels; ++j) {
+        std::uint16_t count;
+        if (offset > end || end - offset < sizeof(count)) {
+          throw std::runtime_error("invalid segments");
+        }
+        std::memcpy(&count, clip->data_.data() + offset, sizeof(count));
+        offset += sizeof(count) + count * kKeySize;
+      }
+      if (offset != end) {
+        throw std::runtime_error("invalid segments");
+      }
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << "Ignoring the invalid cooked animation " << cooked_path
+              << " (" << ex.what() << ")" << std::endl;
+    return nullptr;
+  }
+
+  return clip;
+}
+
+bool AnimationClip::save(const std::string& cooked_path) const {
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.duration = duration_;
+  header.ticks_per_second = ticks_per_second_;
+  header.segment_length = segment_length_;
+  header.num_channels = channels_.size();
+  header.num_segments = segment_offsets_.size() - 1;
+  header.data_size = data_.size();
+
+  BinaryWriter out;
+  out.value(header);
+  for (const Channel& channel : channels_) {
+    out.string(channel.node_name);
+    out.value(channel.translation_min);
+    out.value(channel.translation_step);
+    out.value(channel.scaling_min);
+    out.value(channel.scaling_step);
+  }
+  out.array(segment_offsets_.data(), segment_offsets_.size());
+  out.array(data_.data(), data_.size());
+  return out.save(cooked_path);
+}
+
+int AnimationClip::findChannel(const std::string& node_name) const {
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    if (channels_[i].node_name == node_name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const unsigned char* AnimationClip::segment(float time) const {
+  size_t num_segments = segment_offsets_.size() - 1;
+  size_t idx = time > 0 ? size_t(time / segment_length_) : 0;
+  idx = std::min(idx, num_segments - 1);
+  return data_.data() + segment_offsets_[idx];
+}
+
+AnimationClip::Transform AnimationClip::SampleChannel(
+    const Channel& channel, float time, const unsigned char** data) {
+  Transform transform;
+  transform.translation = SampleTrack(data, time, glm::vec3{0.0f},
+      [&channel](const KeyValue& key) {
+    return Dequantize(key.components, channel.translation_min,
+                      channel.translation_step);
+  });
+  transform.rotation = SampleTrack(data, time, glm::quat{},
+      [](const KeyValue& key) {
+    return DequantizeRotation(key.components);
+  });
+  transform.scaling = SampleTrack(data, time, glm::vec3{1.0f},
+      [&channel](const KeyValue& key) {
+    return Dequantize(key.components, channel.scaling_min,
+                      channel.scaling_step);
+  });
+  return transform;
+}
+
+void AnimationClip::sample(float time, Transform* transforms) const {
+  const unsigned char* data = segment(time);
+  for (const Channel& channel : channels_) {
+    *transforms++ = SampleChannel(channel, time, &data);
+  }
+}
+
+AnimationClip::Transform AnimationClip::sample(unsigned channel,
+                                               float time) const {
+  const unsigned char* data = segment(time);
+  for (unsigned i = 0; i < 3 * channel; ++i) {
+    SkipTrack(&data);
+  }
+  return SampleChannel(channels_.at(channel), time, &data);
+}
+
+size_t AnimationClip::size() const {
+  size_t size = sizeof(*this) + segment_offsets_.size() * sizeof(std::uint32_t)
+                + data_.size();
+  for (const Channel& channel : channels_) {
+    size += sizeof(channel) + channel.node_name.size();
+  }
+  return size;
+}
+
+}  // namespace engine
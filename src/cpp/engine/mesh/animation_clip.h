@@ -0,0 +1,100 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_ANIMATION_CLIP_H_
+#define ENGINE_MESH_ANIMATION_CLIP_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../assimp.h"
+#include "../debug/memory_tracker.h"
+
+namespace engine {
+
+// A skeletal animation, compressed for playback. Only the keys that linear
+// interpolation can't reproduce within a tolerance are kept, the rotations
+// are quantized to 48 bits (the smallest three components), the translations
+// and scalings to 16 bits per component, in the range of their channel.
+// The keys are grouped by time into segments, each of which holds every key
+// that sampling needs in its time range, for one channel after the other, so
+// sampling a pose reads one contiguous block of memory.
+// The cooked (binary) version of the clip is loaded instead of the animation
+// file if it's up to date.
+class AnimationClip {
+ public:
+  // The local transformation of a node.
+  struct Transform {
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scaling;
+  };
+
+  // Compresses the first animation of a scene. Throws std::runtime_error if
+  // it doesn't have any.
+  explicit AnimationClip(const aiScene* scene);
+
+  // Loads the cooked clip if it is up to date, otherwise imports the file
+  // with assimp, and cooks it for the next time. Throws std::runtime_error if
+  // assimp can't read the file, or it doesn't have an animation. A clip that
+  // is loaded already is shared (see AssetCache).
+  static std::shared_ptr<const AnimationClip> Load(const std::string& filename);
+
+  static std::string CookedPath(const std::string& filename);
+
+  // Returns nullptr if the cooked file is missing or invalid.
+  static std::unique_ptr<AnimationClip> LoadCooked(
+      const std::string& cooked_path);
+
+  // Returns false if the file can't be written.
+  bool save(const std::string& cooked_path) const;
+
+  // The length of the clip, in ticks.
+  float duration() const { return duration_; }
+  // Might be zero, if the file doesn't specify it.
+  float ticks_per_second() const { return ticks_per_second_; }
+
+  size_t num_channels() const { return channels_.size(); }
+  // The index of the channel that animates a node, or -1 if there is none.
+  int findChannel(const std::string& node_name) const;
+
+  // Writes the transformations of every channel at a time (in ticks).
+  void sample(float time, Transform* transforms) const;
+  // The transformation of a single channel.
+  Transform sample(unsigned channel, float time) const;
+
+  // The size of the compressed data.
+  size_t size() const;
+
+ private:
+  struct Channel {
+    std::string node_name;
+    // A quantized component is min + value * step
+    glm::vec3 translation_min, translation_step;
+    glm::vec3 scaling_min, scaling_step;
+  };
+
+  float duration_ = 0, ticks_per_second_ = 0, segment_length_ = 1;
+  std::vector<Channel> channels_;
+  // The beginning of the segments in the data (and the end of the last one).
+  std::vector<std::uint32_t> segment_offsets_;
+  std::vector<unsigned char> data_;
+  debug::MemoryTracker::Allocation memory_;
+
+  AnimationClip() = default;
+
+  // The data of the segment that contains the time.
+  const unsigned char* segment(float time) const;
+  // Reads the tracks of a channel, and moves the data to the next channel.
+  static Transform SampleChannel(const Channel& channel, float time,
+                                 const unsigned char** data);
+};
+
+}  // namespace engine
+
+#endif
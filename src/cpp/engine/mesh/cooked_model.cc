@@ -0,0 +1,380 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "./cooked_model.h"
+#include "../mapped_file.h"
+#include "../binary_stream.h"
+#include "../debug/profiler.h"
+
+namespace engine {
+
+namespace {
+
+const char kMagic[4] = {'L', 'M', 'D', 'L'};
+const std::uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t flags;  // the post processing steps of the import
+  std::uint32_t num_materials, num_meshes;
+  float bounds_min[3], bounds_max[3];
+};
+
+// The arrays are used in place, so their layout must match assimp's.
+static_assert(sizeof(aiVector3D) == 3*sizeof(float), "aiVector3D isn't packed");
+static_assert(sizeof(aiVertexWeight) == 2*sizeof(float),
+              "aiVertexWeight isn't packed");
+static_assert(sizeof(aiMatrix4x4) == 16*sizeof(float),
+              "aiMatrix4x4 isn't packed");
+
+// The material properties that MeshRenderer::setupTextures uses.
+struct MaterialChannel {
+  aiTextureType texture;
+  const char* color_key;
+  unsigned color_type, color_index;
+};
+
+const MaterialChannel kMaterialChannels[] = {
+  {aiTextureType_DIFFUSE, AI_MATKEY_COLOR_DIFFUSE},
+  {aiTextureType_SPECULAR, AI_MATKEY_COLOR_SPECULAR}
+};
+
+aiString ReadString(BinaryReader* in) {
+  std::string str = in->string();
+  if (str.size() >= MAXLEN) {
+    throw std::runtime_error("the string is too long");
+  }
+  return aiString{str};
+}
+
+void WriteString(const aiString& str, BinaryWriter* out) {
+  out->string(str.data, str.length);
+}
+
+// The owner of a loaded scene. Its vertex data points into the mapped file,
+// which must be detached from the scene before assimp deletes it.
+struct CookedScene {
+  MappedFile file;
+  aiScene* scene = nullptr;
+
+  CookedScene() = default;
+  CookedScene(const CookedScene&) = delete;
+  CookedScene& operator=(const CookedScene&) = delete;
+
+  ~CookedScene() {
+    if (!scene) { return; }
+    for (unsigned i = 0; scene->mMeshes && i < scene->mNumMeshes; ++i) {
+      aiMesh* mesh = scene->mMeshes[i];
+      if (!mesh) { continue; }
+      mesh->mVertices = nullptr;
+      mesh->mNormals = nullptr;
+      mesh->mTextureCoords[0] = nullptr;
+      for (unsigned j = 0; mesh->mFaces && j < mesh->mNumFaces; ++j) {
+        mesh->mFaces[j].mIndices = nullptr;
+      }
+      for (unsigned j = 0; mesh->mBones && j < mesh->mNumBones; ++j) {
+        if (mesh->mBones[j]) { mesh->mBones[j]->mWeights = nullptr; }
+      }
+    }
+    delete scene;
+  }
+};
+
+void WriteMaterial(const aiMaterial* material, BinaryWriter* out) {
+  for (const MaterialChannel& channel : kMaterialChannels) {
+    aiString path;
+    bool has_texture =
+        material->GetTexture(channel.texture, 0, &path) == AI_SUCCESS;
+    out->value(std::uint32_t(has_texture));
+    if (has_texture) {
+      WriteString(path, out);
+    }
+
+    aiColor4D color;
+    bool has_color = material->Get(channel.color_key, channel.color_type,
+                                   channel.color_index, color) == AI_SUCCESS;
+    out->value(std::uint32_t(has_color));
+    if (has_color) {
+      out->value(color);
+    }
+  }
+}
+
+aiMaterial* ReadMaterial(BinaryReader* in) {
+  std::unique_ptr<aiMaterial> material{new aiMaterial};
+  for (const MaterialChannel& channel : kMaterialChannels) {
+    if (in->value<std::uint32_t>()) {
+      aiString path = ReadString(in);
+      material->AddProperty(&path, AI_MATKEY_TEXTURE(channel.texture, 0));
+    }
+    if (in->value<std::uint32_t>()) {
+      aiColor4D color = in->value<aiColor4D>();
+      material->AddProperty(&color, 1, channel.color_key, channel.color_type,
+                            channel.color_index);
+    }
+  }
+  return material.release();
+}
+
+void WriteMesh(const aiMesh* mesh, BinaryWriter* out) {
+  WriteString(mesh->mName, out);
+  out->value(std::uint32_t(mesh->mMaterialIndex));
+  out->value(std::uint32_t(mesh->mNumVertices));
+  out->array(mesh->mVertices, mesh->mNumVertices);
+
+  out->value(std::uint32_t(mesh->HasNormals()));
+  if (mesh->HasNormals()) {
+    out->array(mesh->mNormals, mesh->mNumVertices);
+  }
+
+  out->value(std::uint32_t(mesh->HasTextureCoords(0)));
+  if (mesh->HasTextureCoords(0)) {
+    out->value(std::uint32_t(mesh->mNumUVComponents[0]));
+    out->array(mesh->mTextureCoords[0], mesh->mNumVertices);
+  }
+
+  // The invalid faces are just ignored, like the renderer does.
+  std::vector<std::uint32_t> indices;
+  indices.reserve(mesh->mNumFaces * 3);
+  for (unsigned i = 0; i < mesh->mNumFaces; ++i) {
+    const aiFace& face = mesh->mFaces[i];
+    if (face.mNumIndices == 3) {
+      indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+    }
+  }
+  out->value(std::uint32_t(indices.size() / 3));
+  out->array(indices.data(), indices.size());
+
+  out->value(std::uint32_t(mesh->mNumBones));
+  for (unsigned i = 0; i < mesh->mNumBones; ++i) {
+    const aiBone* bone = mesh->mBones[i];
+    WriteString(bone->mName, out);
+    out->value(bone->mOffsetMatrix);
+    out->value(std::uint32_t(bone->mNumWeights));
+    out->array(bone->mWeights, bone->mNumWeights);
+  }
+}
+
+// The vertex data isn't copied, the mesh points into the reader's data.
+aiMesh* ReadMesh(BinaryReader* in, unsigned num_materials,
+                 CookedScene* cooked, unsigned mesh_idx) {
+  aiMesh* mesh = new aiMesh;
+  // From now on, the CookedScene is responsible for it
+  cooked->scene->mMeshes[mesh_idx] = mesh;
+
+  mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+  mesh->mName = ReadString(in);
+  mesh->mMaterialIndex = in->value<std::uint32_t>();
+  if (mesh->mMaterialIndex >= num_materials) {
+    throw std::runtime_error("invalid material index");
+  }
+  unsigned num_vertices = in->count();
+  mesh->mVertices = in->array<aiVector3D>(num_vertices);
+  mesh->mNumVertices = num_vertices;
+
+  if (in->value<std::uint32_t>()) {
+    mesh->mNormals = in->array<aiVector3D>(num_vertices);
+  }
+
+  if (in->value<std::uint32_t>()) {
+    mesh->mNumUVComponents[0] = in->value<std::uint32_t>();
+    mesh->mTextureCoords[0] = in->array<aiVector3D>(num_vertices);
+  }
+
+  unsigned num_faces = in->count();
+  unsigned* indices = in->array<unsigned>(3*size_t(num_faces));
+  for (size_t i = 0; i < 3*size_t(num_faces); ++i) {
+    if (indices[i] >= num_vertices) {
+      throw std::runtime_error("invalid vertex index");
+    }
+  }
+  mesh->mFaces = new aiFace[num_faces];
+  mesh->mNumFaces = num_faces;
+  for (unsigned i = 0; i < num_faces; ++i) {
+    mesh->mFaces[i].mNumIndices = 3;
+    mesh->mFaces[i].mIndices = indices + 3*i;
+  }
+
+  unsigned num_bones = in->count();
+  if (num_bones) {
+    mesh->mBones = new aiBone*[num_bones]();
+    mesh->mNumBones = num_bones;
+  }
+  for (unsigned i = 0; i < num_bones; ++i) {
+    aiBone* bone = mesh->mBones[i] = new aiBone;
+    bone->mName = ReadString(in);
+    bone->mOffsetMatrix = in->value<aiMatrix4x4>();
+    unsigned num_weights = in->count();
+    bone->mWeights = in->array<aiVertexWeight>(num_weights);
+    bone->mNumWeights = num_weights;
+    for (unsigned j = 0; j < num_weights; ++j) {
+      if (bone->mWeights[j].mVertexId >= num_vertices) {
+        throw std::runtime_error("invalid bone weight");
+      }
+    }
+  }
+
+  return mesh;
+}
+
+// The nodes are stored in pre-order.
+void WriteNode(const aiNode* node, BinaryWriter* out) {
+  WriteString(node->mName, out);
+  out->value(node->mTransformation);
+  out->value(std::uint32_t(node->mNumMeshes));
+  out->array(node->mMeshes, node->mNumMeshes);
+  out->value(std::uint32_t(node->mNumChildren));
+  for (unsigned i = 0; i < node->mNumChildren; ++i) {
+    WriteNode(node->mChildren[i], out);
+  }
+}
+
+aiNode* ReadNode(BinaryReader* in, aiNode* parent, unsigned num_meshes) {
+  std::unique_ptr<aiNode> node{new aiNode};
+  node->mParent = parent;
+  node->mName = ReadString(in);
+  node->mTransformation = in->value<aiMatrix4x4>();
+
+  unsigned node_meshes = in->count();
+  const unsigned* meshes = in->array<unsigned>(node_meshes);
+  if (node_meshes) {
+    node->mMeshes = new unsigned[node_meshes];
+    node->mNumMeshes = node_meshes;
+  }
+  for (unsigned i = 0; i < node_meshes; ++i) {
+    if (meshes[i] >= num_meshes) {
+      throw std::runtime_error("invalid mesh index");
+    }
+    node->mMeshes[i] = meshes[i];
+  }
+
+  unsigned num_children = in->count();
+  if (num_children) {
+    node->mChildren = new aiNode*[num_children]();
+    node->mNumChildren = num_children;
+  }
+  for (unsigned i = 0; i < num_children; ++i) {
+    node->mChildren[i] = ReadNode(in, node.get(), num_meshes);
+  }
+  return node.release();
+}
+
+}  // namespace
+
+std::string CookedModelPath(const std::string& filename, unsigned flags) {
+  char flags_str[16];
+  std::snprintf(flags_str, sizeof(flags_str), "%x", flags);
+  return filename + '.' + flags_str + ".cooked";
+}
+
+ImportedModel LoadCookedModel(const std::string& filename, unsigned flags) {
+  ENGINE_PROFILE("load cooked model");
+  std::string cooked_path = CookedModelPath(filename, flags);
+  auto cooked = std::make_shared<CookedScene>();
+  try {
+    cooked->file = MappedFile{cooked_path};
+  } catch (const std::runtime_error&) {
+    return ImportedModel{};
+  }
+
+  ImportedModel model;
+  try {
+    BinaryReader in{cooked->file.data(), cooked->file.size()};
+    auto header = in.value<Header>();
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.flags != flags) {
+      throw std::runtime_error("wrong version");
+    }
+
+    cooked->scene = new aiScene;
+    aiScene* scene = cooked->scene;
+    if (header.num_materials) {
+      scene->mMaterials = new aiMaterial*[header.num_materials]();
+      scene->mNumMaterials = header.num_materials;
+    }
+    for (unsigned i = 0; i < header.num_materials; ++i) {
+      scene->mMaterials[i] = ReadMaterial(&in);
+    }
+
+    if (header.num_meshes) {
+      scene->mMeshes = new aiMesh*[header.num_meshes]();
+      scene->mNumMeshes = header.num_meshes;
+    }
+    for (unsigned i = 0; i < header.num_meshes; ++i) {
+      ReadMesh(&in, header.num_materials, cooked.get(), i);
+    }
+
+    scene->mRootNode = ReadNode(&in, nullptr, header.num_meshes);
+    if (!in.done()) {
+      throw std::runtime_error("unexpected data at the end");
+    }
+
+    model.bounds = BoundingBox{glm::make_vec3(header.bounds_min),
+                               glm::make_vec3(header.bounds_max)};
+  } catch (const std::exception& ex) {
+    std::cerr << "Ignoring the invalid cooked model " << cooked_path
+              << " (" << ex.what() << ")" << std::endl;
+    return ImportedModel{};
+  }
+
+  model.filename = filename;
+  model.scene = cooked->scene;
+  model.owner = std::move(cooked);
+  return model;
+}
+
+bool CookModel(const ImportedModel& model, unsigned flags) {
+  ENGINE_PROFILE("cook model");
+  const aiScene* scene = model.scene;
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.flags = flags;
+  header.num_materials = scene->mNumMaterials;
+  header.num_meshes = scene->mNumMeshes;
+  glm::vec3 mins = model.bounds.mins(), maxes = model.bounds.maxes();
+  std::memcpy(header.bounds_min, glm::value_ptr(mins), sizeof(mins));
+  std::memcpy(header.bounds_max, glm::value_ptr(maxes), sizeof(maxes));
+
+  BinaryWriter out;
+  out.value(header);
+  for (unsigned i = 0; i < scene->mNumMaterials; ++i) {
+    WriteMaterial(scene->mMaterials[i], &out);
+  }
+  for (unsigned i = 0; i < scene->mNumMeshes; ++i) {
+    WriteMesh(scene->mMeshes[i], &out);
+  }
+  WriteNode(scene->mRootNode, &out);
+
+  return out.save(CookedModelPath(model.filename, flags));
+}
+
+ImportedModel LoadModel(const std::string& filename, unsigned flags) {
+  flags |= aiProcess_Triangulate;
+  if (MappedFile::ModificationTime(filename) <=
+      MappedFile::ModificationTime(CookedModelPath(filename, flags))) {
+    ImportedModel model = LoadCookedModel(filename, flags);
+    if (model.scene) {
+      return model;
+    }
+  }
+
+  ImportedModel model = ImportModel(filename, flags);
+  // The model is already imported, so this isn't fatal, just slow next time
+  if (!CookModel(model, flags)) {
+    std::cerr << "Couldn't write the cooked model "
+              << CookedModelPath(filename, flags) << std::endl;
+  }
+  return model;
+}
+
+}  // namespace engine
@@ -0,0 +1,43 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_COOKED_MODEL_H_
+#define ENGINE_MESH_COOKED_MODEL_H_
+
+#include <string>
+#include "./imported_model.h"
+
+namespace engine {
+
+// The engine's binary model format: what assimp's import and post processing
+// produce, stored as it is uploaded. The loader maps the file, and the
+// positions, normals, texture coordinates, indices and bone weights of the
+// scene it builds point into the mapping, so a MeshRenderer (or an
+// AnimatedMeshRenderer) uploads them straight from the file, and can't tell
+// it apart from an imported model.
+// Only what the renderers use is stored: the node tree, the triangles of the
+// meshes with the first texture coordinate set and the bones, the diffuse and
+// specular textures (or colors) of the materials, and the bounds. Animations
+// aren't stored, they are cooked separately (see AnimationClip).
+
+// The cooked file that belongs to a model imported with the given flags.
+std::string CookedModelPath(const std::string& filename, unsigned flags);
+
+// Loads the cooked version of a file, even if it is older than the file.
+// Returns a model with a null scene if the cooked file is missing or invalid,
+// or it wasn't imported with the same flags.
+ImportedModel LoadCookedModel(const std::string& filename, unsigned flags);
+
+// Writes an imported model into its cooked file (see CookedModelPath), where
+// the flags are the post processing steps it has been imported with.
+// Returns false if the file can't be written.
+bool CookModel(const ImportedModel& model, unsigned flags);
+
+// Loads the cooked version of a model if it is up to date, otherwise imports
+// it with assimp, and cooks it for the next time. The model is triangulated,
+// besides the given post processing steps. Throws std::runtime_error if
+// assimp can't read the file.
+ImportedModel LoadModel(const std::string& filename, unsigned flags);
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_IMPORTED_MODEL_H_
+#define ENGINE_MESH_IMPORTED_MODEL_H_
+
+#include <string>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "../assimp.h"
+#include "../collision/bounding_box.h"
+
+namespace engine {
+
+// A file read (and post processed) by assimp, or loaded from its cooked
+// version (see LoadModel). Importing doesn't need the context, so it can be
+// done on any thread (see ImportGraph), then the model can be given to a
+// MeshRenderer, or be added as an animation.
+struct ImportedModel {
+  std::string filename;
+  // The scene belongs to this: an assimp importer, or a mapped cooked file.
+  std::shared_ptr<const void> owner;
+  const aiScene* scene = nullptr;
+  // The bounding box of the vertices in the model's space.
+  BoundingBox bounds;
+};
+
+// Identifies a model that is imported with the given post processing steps,
+// in the AssetCache. The imports and the renderers of a model are shared by
+// this key.
+inline std::string ModelKey(const std::string& filename, unsigned flags) {
+  return filename + '|' + std::to_string(flags);
+}
+
+// The bounding box of every vertex of the scene's meshes.
+inline BoundingBox SceneBounds(const aiScene* scene) {
+  float infty = std::numeric_limits<float>::infinity();
+  glm::vec3 mins{infty}, maxes{-infty};
+  for (unsigned i = 0; i < scene->mNumMeshes; ++i) {
+    const aiMesh* mesh = scene->mMeshes[i];
+    for (unsigned j = 0; j < mesh->mNumVertices; ++j) {
+      glm::vec3 vert{mesh->mVertices[j].x, mesh->mVertices[j].y,
+                     mesh->mVertices[j].z};
+      mins = glm::min(mins, vert);
+      maxes = glm::max(maxes, vert);
+    }
+  }
+  return BoundingBox{mins, maxes};
+}
+
+// Throws std::runtime_error if assimp can't read the file.
+inline ImportedModel ImportModel(const std::string& filename, unsigned flags) {
+  auto importer = std::make_shared<Assimp::Importer>();
+  ImportedModel model;
+  model.filename = filename;
+  model.scene = importer->ReadFile(filename, flags);
+  if (!model.scene) {
+    throw std::runtime_error("Error parsing " + filename + " : " +
+                             importer->GetErrorString());
+  }
+  model.owner = std::move(importer);
+  model.bounds = SceneBounds(model.scene);
+  return model;
+}
+
+}  // namespace engine
+
+#endif
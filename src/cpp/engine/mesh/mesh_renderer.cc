@@ -1,34 +1,72 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include <vector>
+#include <utility>
 #include "./mesh_renderer.h"
+#include "./cooked_model.h"
+#include "../texture_loader.h"
 #include "../../oglwrap/context.h"
 #include "../../oglwrap/smart_enums.h"
 
 namespace engine {
 
+namespace {
+
+/// Estimates the memory used by the vertex data of an assimp scene.
+size_t SceneSize(const aiScene* scene) {
+  size_t size = 0;
+  for (unsigned i = 0; i < scene->mNumMeshes; ++i) {
+    const aiMesh* mesh = scene->mMeshes[i];
+    size_t vectors = 1 + mesh->HasNormals() +
+                     2*mesh->HasTangentsAndBitangents();
+    size_t per_vertex = vectors * sizeof(aiVector3D);
+    for (unsigned j = 0; j < AI_MAX_NUMBER_OF_TEXTURECOORDS; ++j) {
+      per_vertex += mesh->HasTextureCoords(j) ? sizeof(aiVector3D) : 0;
+    }
+    for (unsigned j = 0; j < AI_MAX_NUMBER_OF_COLOR_SETS; ++j) {
+      per_vertex += mesh->HasVertexColors(j) ? sizeof(aiColor4D) : 0;
+    }
+    size += per_vertex * mesh->mNumVertices;
+    size += mesh->mNumFaces * (sizeof(aiFace) + 3*sizeof(unsigned));
+    for (unsigned j = 0; j < mesh->mNumBones; ++j) {
+      size += sizeof(aiBone) +
+              mesh->mBones[j]->mNumWeights * sizeof(aiVertexWeight);
+    }
+  }
+  return size;
+}
+
+}  // namespace
+
 /// Loads in the mesh from a file, and does some post-processing on it.
 /** @param filename - The name of the file to load in.
   * @param flags - The assimp post-process flags. */
 MeshRenderer::MeshRenderer(const std::string& filename,
                            gl::Bitfield<aiPostProcessSteps> flags)
-    : scene_(importer_.ReadFile(filename.c_str(), flags|aiProcess_Triangulate))
-    , filename_(filename)
-    , entries_(scene_->mNumMeshes)
+    : MeshRenderer(LoadModel(filename, flags)) {}
+
+MeshRenderer::MeshRenderer(ImportedModel model)
+    : owner_(std::move(model.owner))
+    , scene_(model.scene)
+    , filename_(std::move(model.filename))
+    , bounds_(model.bounds)
     , is_setup_positions_(false)
     , is_setup_normals_(false)
     , is_setup_tex_coords_(false)
     , textures_enabled_(true) {
-  if (!scene_) {
-    throw std::runtime_error("Error parsing " + filename_ + " : " +
-                             importer_.GetErrorString());
-  }
-
   // The world transform is the transform that takes the root node to it's
   // parent's space, which is the OpenGL style world space. The inverse of this
   // is stored as an attribute of the scene's root node.
   world_transformation_ =
     glm::inverse(engine::convertMatrix(scene_->mRootNode->mTransformation));
+
+  using debug::MemoryTracker;
+  cpu_memory_ = MemoryTracker::Allocation{"mesh", filename_,
+      MemoryTracker::Category::kCpu, SceneSize(scene_)};
+  buffer_memory_ = MemoryTracker::Allocation{"mesh", filename_,
+      MemoryTracker::Category::kGpuBuffer};
+  texture_memory_ = MemoryTracker::Allocation{"mesh", filename_,
+      MemoryTracker::Category::kGpuTexture};
 }
 
 std::vector<int> MeshRenderer::btTriangles(btTriangleIndexVertexArray* triangles) {
@@ -106,6 +144,7 @@ void MeshRenderer::setIndices(size_t index) {
 
   gl::Bind(entries_[index].indices);
   entries_[index].indices.data(indices_vector);
+  buffer_memory_.add(indices_vector.size() * sizeof(IdxType));
   entries_[index].idx_count = indices_vector.size();
 }
 
@@ -129,6 +168,7 @@ void MeshRenderer::setupPositions(gl::VertexAttrib attrib) {
     std::terminate();
   }
 
+  createEntries();
   for (size_t i = 0; i < entries_.size(); i++) {
     const aiMesh* mesh = scene_->mMeshes[i];
     gl::Bind(entries_[i].vao);
@@ -137,6 +177,7 @@ void MeshRenderer::setupPositions(gl::VertexAttrib attrib) {
 
     gl::Bind(entries_[i].verts);
     entries_[i].verts.data(mesh->mNumVertices*sizeof(aiVector3D), mesh->mVertices);
+    buffer_memory_.add(mesh->mNumVertices*sizeof(aiVector3D));
     attrib.setup<glm::vec3>().enable();
 
     // ~~~~~~<{ Load the indices }>~~~~~~
@@ -176,12 +217,14 @@ void MeshRenderer::setupNormals(gl::VertexAttrib attrib) {
     std::terminate();
   }
 
+  createEntries();
   for (size_t i = 0; i < entries_.size(); i++) {
     const aiMesh* mesh = scene_->mMeshes[i];
     gl::Bind(entries_[i].vao);
 
     gl::Bind(entries_[i].normals);
     entries_[i].normals.data(mesh->mNumVertices*sizeof(aiVector3D), mesh->mNormals);
+    buffer_memory_.add(mesh->mNumVertices*sizeof(aiVector3D));
     attrib.setup<float>(3).enable();
   }
 
@@ -195,7 +238,7 @@ void MeshRenderer::setupNormals(gl::VertexAttrib attrib) {
   * @param tex_coord_set  Specifies the index of the texture coordinate
   *                     set that should be inspected */
 bool MeshRenderer::hasTexCoords(unsigned char tex_coord_set) {
-  for (size_t i = 0; i < entries_.size(); i++) {
+  for (size_t i = 0; i < scene_->mNumMeshes; i++) {
     if (!scene_->mMeshes[i]->HasTextureCoords(tex_coord_set)) {
       return false;
     }
@@ -229,6 +272,7 @@ void MeshRenderer::setupTexCoords(gl::VertexAttrib attrib,
   }
 
   // Initialize TexCoords
+  createEntries();
   for (size_t i = 0; i < entries_.size(); i++) {
     const aiMesh* mesh = scene_->mMeshes[i];
     entries_[i].material_index = mesh->mMaterialIndex;
@@ -250,6 +294,7 @@ void MeshRenderer::setupTexCoords(gl::VertexAttrib attrib,
 
     gl::Bind(entries_[i].tex_coords);
     entries_[i].tex_coords.data(tex_coords_vector);
+    buffer_memory_.add(tex_coords_vector.size() * sizeof(aiVector2D));
     attrib.setup<float>(2).enable();
   }
 
@@ -300,25 +345,26 @@ void MeshRenderer::setupTextures(unsigned short texture_unit,
     // Initialize the materials
     for (unsigned int i = 0; i < scene_->mNumMaterials; ++i) {
       const aiMaterial* mat = scene_->mMaterials[i];
-      materials_[tex_type].textures.push_back(gl::Texture2D{});
+      std::shared_ptr<gl::Texture2D> texture;
 
       aiString filepath;
       if (mat->GetTexture(tex_type, 0, &filepath) == AI_SUCCESS) {
-        gl::Bind(materials_[tex_type].textures[i]);
-        materials_[tex_type].textures[i].loadTexture(dir + filepath.data,
-                                                     srgb ? "CSRGBA" : "CRGBA");
-        materials_[tex_type].textures[i].minFilter(gl::kLinear);
-        materials_[tex_type].textures[i].magFilter(gl::kLinear);
+        texture = GetTexture(dir + filepath.data, srgb ? "CSRGBA" : "CRGBA");
+        gl::Bind(*texture);
+        texture->minFilter(gl::kLinearMipmapLinear);
+        texture->magFilter(gl::kLinear);
       } else {
         aiColor4D color(0.f, 0.f, 0.f, 1.0f);
         mat->Get(pKey, type, idx, color);
 
-        gl::Bind(materials_[tex_type].textures[i]);
-        materials_[tex_type].textures[i].upload(gl::kRgba32F, 1, 1, gl::kRgba,
-                                                gl::kFloat, &color.r);
-        materials_[tex_type].textures[i].minFilter(gl::kNearest);
-        materials_[tex_type].textures[i].magFilter(gl::kNearest);
+        texture = std::make_shared<gl::Texture2D>();
+        gl::Bind(*texture);
+        texture->upload(gl::kRgba32F, 1, 1, gl::kRgba, gl::kFloat, &color.r);
+        texture_memory_.add(sizeof(color));
+        texture->minFilter(gl::kNearest);
+        texture->magFilter(gl::kNearest);
       }
+      materials_[tex_type].textures.push_back(std::move(texture));
     }
   }
 
@@ -359,7 +405,7 @@ void MeshRenderer::render() {
         if (material.active == true && material_index < scene_->mNumMaterials) {
           gl::ActiveTexture(material.tex_unit);
         }
-        gl::Bind(material.textures[material_index]);
+        gl::Bind(*material.textures[material_index]);
       }
     }
 
@@ -371,7 +417,7 @@ void MeshRenderer::render() {
         if (material.active == true && material_index < scene_->mNumMaterials) {
           gl::ActiveTexture(material.tex_unit);
         }
-        gl::Unbind(material.textures[material_index]);
+        gl::Unbind(*material.textures[material_index]);
       }
     }
   }
@@ -392,7 +438,7 @@ BoundingBox MeshRenderer::boundingBox(const glm::mat4& matrix) const {
   float zero = 0.0f;  // This is needed to bypass a visual c++ compile error
   float infty = 1.0f / zero;
   glm::vec3 mins{infty, infty, infty}, maxes{-infty, -infty, -infty};
-  for (size_t entry = 0; entry < entries_.size(); entry++) {
+  for (size_t entry = 0; entry < scene_->mNumMeshes; entry++) {
     const aiMesh* mesh = scene_->mMeshes[entry];
 
     for (size_t i = 0; i < mesh->mNumVertices; i++) {
@@ -438,12 +484,12 @@ glm::vec4 MeshRenderer::bSphere(const glm::mat4& model_matrix) const {
 
 /// Returns the center of the bounding sphere.
 glm::vec3 MeshRenderer::bSphereCenter() const {
-  return boundingBox().center();
+  return bounds_.center();
 }
 
 /// Returns the radius of the bounding sphere.
 float MeshRenderer::bSphereRadius() const {
-  glm::vec3 extent = boundingBox().extent();
+  glm::vec3 extent = bounds_.extent();
   return sqrt(glm::dot(extent, extent)) / 2;  // Pythagoras.
 }
 
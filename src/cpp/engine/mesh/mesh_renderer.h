@@ -15,7 +15,9 @@
 #include "../../oglwrap/textures/texture_2D.h"
 
 #include "../assimp.h"
+#include "./imported_model.h"
 #include "../collision/bounding_box.h"
+#include "../debug/memory_tracker.h"
 
 namespace engine {
 
@@ -37,26 +39,37 @@ class MeshRenderer {
     MeshEntry() : material_index(kInvalidMaterial) {}
   };
 
-  /// The assimp importer. The scene actually belongs to this.
-  Assimp::Importer importer_;
+  /// The assimp importer or the cooked file. The scene actually belongs to this.
+  std::shared_ptr<const void> owner_;
 
-  /// A pointer to the scene stored by the importer. But this is the working interface for it.
+  /// A pointer to the scene stored by the owner. But this is the working interface for it.
   const aiScene* scene_;
 
   /// The name of the file loaded in. It is stored to be able to print it out if an error happens.
   std::string filename_;
 
-  /// The vao-s and buffers per mesh.
+  /// The vao-s and buffers per mesh. They are only created by the first
+  /// setup call, so that the CPU side data can be used without a GL context.
   std::vector<MeshEntry> entries_;
 
+  void createEntries() {
+    if (entries_.empty()) {
+      entries_ = std::vector<MeshEntry>(scene_->mNumMeshes);
+    }
+  }
+
   /// The transformation that takes the model's world coordinates to the OpenGL style world coordinates.
   glm::mat4 world_transformation_;
 
+  /// The bounding box of the vertices, in the model's space.
+  BoundingBox bounds_;
+
   /// A struct containin the state and data of a material type.
   struct MaterialInfo {
     bool active;
     int tex_unit;
-    std::vector<gl::Texture2D> textures;
+    // The file textures are shared with the other meshes (see GetTexture).
+    std::vector<std::shared_ptr<gl::Texture2D>> textures;
 
     MaterialInfo() : active(false), tex_unit(0) {}
   };
@@ -73,6 +86,9 @@ class MeshRenderer {
   /// Textures can be disabled, and not used for rendering
   bool textures_enabled_;
 
+  /// The size of the aiScene, and of the GL objects created from it.
+  debug::MemoryTracker::Allocation cpu_memory_, buffer_memory_, texture_memory_;
+
   /// It shouldn't be copyable.
   MeshRenderer(const MeshRenderer& src) = delete;
   /// It shouldn't be copyable.
@@ -80,11 +96,16 @@ class MeshRenderer {
 
 public:
   /// Loads in the mesh from a file, and does some post-processing on it.
-  /** @param filename - The name of the file to load in.
+  /** The cooked version of the file is used instead, if it is up to date.
+    * @param filename - The name of the file to load in.
     * @param flags - The assimp post-process flags. */
   MeshRenderer(const std::string& filename,
                gl::Bitfield<aiPostProcessSteps> flags);
 
+  /// Uses a model that has been imported already (see ImportGraph::addMesh).
+  /** The model has to be triangulated. */
+  explicit MeshRenderer(ImportedModel model);
+
   template <typename IdxType>
   /// Returns a vector of the indices
   std::vector<IdxType> indices();
@@ -170,7 +191,10 @@ public:
   void render();
 
   /// Gives information about the mesh's bounding cuboid.
-  BoundingBox boundingBox(const glm::mat4& matrix = glm::mat4{}) const;
+  BoundingBox boundingBox() const { return bounds_; }
+
+  /// Gives information about the mesh's bounding cuboid, transformed by a matrix.
+  BoundingBox boundingBox(const glm::mat4& matrix) const;
 
   /// Returns the transformation that takes the model's world coordinates to the OpenGL style world coordinates.
   /** i.e if you see that a character is laying on ground instead of standing, it is probably
@@ -181,8 +205,11 @@ public:
   /// Returns the bounding sphere from the bounding box
   glm::vec4 bSphere(const BoundingBox& bbox) const;
 
+  /// Returns the center (as xyz) and radius (as w) of the bounding sphere.
+  glm::vec4 bSphere() const { return bSphere(bounds_); }
+
   /// Returns the center offseted by the model matrix (as xyz) and radius (as w) of the bounding sphere.
-  glm::vec4 bSphere(const glm::mat4& modelMatrix = glm::mat4{}) const;
+  glm::vec4 bSphere(const glm::mat4& modelMatrix) const;
 
   /// Returns the center of the bounding sphere.
   glm::vec3 bSphereCenter() const;
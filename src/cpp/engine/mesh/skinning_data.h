@@ -4,6 +4,7 @@
 #define ENGINE_MESH_SKINNING_DATA_H_
 
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -82,6 +83,10 @@ struct SkinningData {
     * multiplies, is to reference them by their name */
   std::map<std::string, unsigned> bone_mapping;
 
+  /// The bone index of the nodes that are bones, so that the per frame bone
+  /// tree updates don't have to look them up by their name.
+  std::unordered_map<const aiNode*, unsigned> node_bones;
+
   /// The number of the bones.
   size_t num_bones;
 
@@ -0,0 +1,150 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cmath>
+#include <algorithm>
+
+#include "./activation_grid.h"
+#include "./activators.h"
+
+namespace engine {
+namespace physics {
+
+ActivationGrid::ActivationGrid(GameObject* parent, float cell_size,
+                               float radius)
+    : Behaviour(parent), cell_size_(cell_size), radius_(radius) {}
+
+void ActivationGrid::addStatic(btRigidBody* body) {
+  CellKey key = Key(cellOf(body->getWorldTransform().getOrigin()));
+  std::vector<btRigidBody*>& cell = cells_[key];
+  if (cell.empty()) {
+    // a new cell might be needed even if no activator crossed a cell border
+    activator_cells_.clear();
+  }
+  cell.push_back(body);
+  if (!isActive(key)) {
+    scene_->world()->removeRigidBody(body);
+  }
+}
+
+void ActivationGrid::removeStatic(btRigidBody* body) {
+  CellKey key = Key(cellOf(body->getWorldTransform().getOrigin()));
+  auto cell = cells_.find(key);
+  if (cell == cells_.end()) { return; }
+
+  auto& bodies = cell->second;
+  auto iter = std::find(bodies.begin(), bodies.end(), body);
+  if (iter == bodies.end()) { return; }
+  bodies.erase(iter);
+
+  // give back the body in the same state as it was registered
+  if (!isActive(key)) {
+    scene_->world()->addRigidBody(body);
+  }
+}
+
+void ActivationGrid::update() {
+  btDynamicsWorld* world = scene_->world();
+  if (!world) { return; }
+
+  std::swap(prev_activator_cells_, activator_cells_);
+  activator_cells_.clear();
+
+  ForEachActivator(scene_, [this](const glm::vec3& pos) {
+    activator_cells_.push_back(Key(cellOf(pos)));
+  });
+  std::sort(activator_cells_.begin(), activator_cells_.end());
+  activator_cells_.erase(
+      std::unique(activator_cells_.begin(), activator_cells_.end()),
+      activator_cells_.end());
+
+  // Nothing can change, until an activator crosses a cell border
+  if (activator_cells_ == prev_activator_cells_) { return; }
+
+  // Cells are activated in the radius, but they are only deactivated if
+  // they get further than that plus a cell, so that an object moving around
+  // a cell border doesn't make its neighbours flicker in and out.
+  cells_to_activate_.clear();
+  cells_to_keep_.clear();
+  for (CellKey key : activator_cells_) {
+    glm::ivec2 cell(static_cast<std::int32_t>(key >> 32),
+                    static_cast<std::int32_t>(key & 0xFFFFFFFF));
+    gatherCellsAround(cell, radius_, &cells_to_activate_);
+    gatherCellsAround(cell, radius_ + cell_size_, &cells_to_keep_);
+  }
+  for (auto cells : {&cells_to_activate_, &cells_to_keep_}) {
+    std::sort(cells->begin(), cells->end());
+    cells->erase(std::unique(cells->begin(), cells->end()), cells->end());
+  }
+
+  // The buffers are reused, so the steady state doesn't allocate
+  std::vector<CellKey>& new_active_cells = next_active_cells_;
+  new_active_cells.clear();
+  new_active_cells.reserve(active_cells_.size() + cells_to_activate_.size());
+  for (CellKey key : active_cells_) {
+    if (std::binary_search(cells_to_keep_.begin(), cells_to_keep_.end(), key)) {
+      new_active_cells.push_back(key);
+    } else {
+      setCellActive(key, false);
+    }
+  }
+  for (CellKey key : cells_to_activate_) {
+    if (!isActive(key)) {
+      setCellActive(key, true);
+      new_active_cells.push_back(key);
+    }
+  }
+  std::sort(new_active_cells.begin(), new_active_cells.end());
+  std::swap(active_cells_, new_active_cells);
+}
+
+glm::ivec2 ActivationGrid::cellOf(const btVector3& pos) const {
+  return cellOf(glm::vec3(pos.x(), pos.y(), pos.z()));
+}
+
+glm::ivec2 ActivationGrid::cellOf(const glm::vec3& pos) const {
+  return glm::ivec2(std::floor(pos.x / cell_size_),
+                    std::floor(pos.z / cell_size_));
+}
+
+ActivationGrid::CellKey ActivationGrid::Key(const glm::ivec2& cell) {
+  return (static_cast<CellKey>(static_cast<std::uint32_t>(cell.x)) << 32) |
+         static_cast<std::uint32_t>(cell.y);
+}
+
+void ActivationGrid::gatherCellsAround(const glm::ivec2& center, float radius,
+                                       std::vector<CellKey>* cells) const {
+  // The activator can be anywhere in the center cell, so the distance of two
+  // cells is measured between their closest points.
+  int range = std::ceil(radius / cell_size_);
+  float max_dist = radius / cell_size_;
+  for (int dx = -range; dx <= range; ++dx) {
+    for (int dy = -range; dy <= range; ++dy) {
+      float x = std::max(std::abs(dx) - 1, 0);
+      float y = std::max(std::abs(dy) - 1, 0);
+      if (x*x + y*y <= max_dist*max_dist) {
+        CellKey key = Key(center + glm::ivec2(dx, dy));
+        if (cells_.find(key) != cells_.end()) {
+          cells->push_back(key);
+        }
+      }
+    }
+  }
+}
+
+void ActivationGrid::setCellActive(CellKey key, bool active) {
+  btDynamicsWorld* world = scene_->world();
+  for (btRigidBody* body : cells_[key]) {
+    if (active) {
+      world->addRigidBody(body);
+    } else {
+      world->removeRigidBody(body);
+    }
+  }
+}
+
+bool ActivationGrid::isActive(CellKey key) const {
+  return std::binary_search(active_cells_.begin(), active_cells_.end(), key);
+}
+
+}  // namespace physics
+}  // namespace engine
@@ -0,0 +1,58 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_ACTIVATION_GRID_H_
+#define ENGINE_PHYSICS_ACTIVATION_GRID_H_
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <btBulletDynamicsCommon.h>
+
+#include "../behaviour.h"
+
+namespace engine {
+
+namespace physics {
+
+// Keeps static colliders in a uniform grid (on the XZ plane), and only keeps
+// the cells in the world that are close to the camera, or to an active
+// dynamic body. The cells are added to / removed from the world as a whole,
+// so the cost of it depends on the number of cells crossed, and not on
+// the number of the registered colliders.
+class ActivationGrid : public Behaviour {
+ public:
+  ActivationGrid(GameObject* parent, float cell_size, float radius);
+
+  // Registers a static body that is already added to the world. The body
+  // is removed from the world if its cell isn't active. The body has to be
+  // unregistered before it is destroyed (unless the grid dies first).
+  void addStatic(btRigidBody* body);
+  void removeStatic(btRigidBody* body);
+
+ private:
+  using CellKey = std::int64_t;
+
+  const float cell_size_, radius_;
+  std::unordered_map<CellKey, std::vector<btRigidBody*>> cells_;
+  // These are kept sorted
+  std::vector<CellKey> active_cells_;
+  std::vector<CellKey> activator_cells_, prev_activator_cells_;
+  std::vector<CellKey> cells_to_activate_, cells_to_keep_;
+  std::vector<CellKey> next_active_cells_;  // swapped with active_cells_
+
+  virtual void update() override;
+
+  glm::ivec2 cellOf(const btVector3& pos) const;
+  glm::ivec2 cellOf(const glm::vec3& pos) const;
+  static CellKey Key(const glm::ivec2& cell);
+  void gatherCellsAround(const glm::ivec2& center, float radius,
+                         std::vector<CellKey>* cells) const;
+  void setCellActive(CellKey key, bool active);
+  bool isActive(CellKey key) const;
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
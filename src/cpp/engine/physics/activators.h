@@ -0,0 +1,34 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_ACTIVATORS_H_
+#define ENGINE_PHYSICS_ACTIVATORS_H_
+
+#include <btBulletDynamicsCommon.h>
+#include "../scene.h"
+#include "./bullet_rigid_body.h"
+
+namespace engine {
+
+namespace physics {
+
+// Calls function with the position of everything that needs the static
+// world around it: the camera, and the moving rigid bodies.
+template<typename Function>
+void ForEachActivator(Scene* scene, Function function) {
+  if (scene->camera()) {
+    function(scene->camera()->transform()->pos());
+  }
+
+  // The bodies that sleep, or didn't move recently are not in the list
+  for (BulletRigidBody* body : scene->active_bodies().bodies()) {
+    if (body->bt_rigid_body()->isActive()) {
+      function(body->parent()->transform()->pos());
+    }
+  }
+}
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
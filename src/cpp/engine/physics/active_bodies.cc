@@ -0,0 +1,78 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./active_bodies.h"
+#include "./bullet_rigid_body.h"
+
+namespace engine {
+namespace physics {
+
+void ActiveBodies::Add(List* list, Index index, BulletRigidBody* body) {
+  body->*index = static_cast<int>(list->size());
+  list->push_back(body);
+}
+
+void ActiveBodies::Remove(List* list, Index index, BulletRigidBody* body) {
+  BulletRigidBody* last = list->back();
+  (*list)[body->*index] = last;
+  last->*index = body->*index;
+  list->pop_back();
+  body->*index = -1;
+}
+
+void ActiveBodies::moved(BulletRigidBody* body) {
+  if (body->moved_ == -1) {
+    Add(&moved_, &BulletRigidBody::moved_, body);
+  }
+}
+
+void ActiveBodies::publish() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (BulletRigidBody* body : moved_) {
+    body->moved_ = -1;
+    if (body->published_ == -1) {
+      Add(&published_, &BulletRigidBody::published_, body);
+    }
+  }
+  moved_.clear();
+}
+
+void ActiveBodies::removed(BulletRigidBody* body) {
+  if (body->moved_ != -1) {
+    Remove(&moved_, &BulletRigidBody::moved_, body);
+  }
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (body->published_ != -1) {
+      Remove(&published_, &BulletRigidBody::published_, body);
+    }
+  }
+  if (body->active_ != -1) {
+    Remove(&active_, &BulletRigidBody::active_, body);
+  }
+}
+
+void ActiveBodies::sync() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (BulletRigidBody* body : published_) {
+      body->published_ = -1;
+      if (body->active_ == -1) {
+        Add(&active_, &BulletRigidBody::active_, body);
+      }
+    }
+    published_.clear();
+  }
+
+  for (size_t i = 0; i < active_.size();) {
+    BulletRigidBody* body = active_[i];
+    if (body->sync()) {
+      ++i;
+    } else {
+      // The last body is moved here, it has to be synced too
+      Remove(&active_, &BulletRigidBody::active_, body);
+    }
+  }
+}
+
+}  // namespace physics
+}  // namespace engine
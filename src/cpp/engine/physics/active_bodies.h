@@ -0,0 +1,61 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_ACTIVE_BODIES_H_
+#define ENGINE_PHYSICS_ACTIVE_BODIES_H_
+
+#include <mutex>
+#include <vector>
+
+namespace engine {
+
+namespace physics {
+
+class BulletRigidBody;
+
+// Keeps track of the rigid bodies whose GameObjects need to be synced with
+// the simulation. Bullet only calls the motion state of the bodies that it
+// moved, so those are collected during the step, and only they (and the
+// ones still interpolating towards their last state) are synced per frame.
+// Static and sleeping bodies cost nothing.
+// The physics thread hands the moved bodies over after every step, under a
+// lock of its own, so the main thread can sync them without locking the
+// world.
+class ActiveBodies {
+ public:
+  // Physics thread, called from BulletRigidBody::setWorldTransform, with the
+  // world locked.
+  void moved(BulletRigidBody* body);
+
+  // Physics thread, after a step: hands over the bodies that it moved.
+  void publish();
+
+  // Must be called before the body is destroyed, or taken out of the world,
+  // with the world locked. O(1): the bodies store their index in the lists.
+  void removed(BulletRigidBody* body);
+
+  // Writes back the transforms of the active bodies, and drops the ones
+  // that reached their final state. Main thread, once per frame.
+  void sync();
+
+  // The bodies that moved recently, in no particular order. Main thread.
+  const std::vector<BulletRigidBody*>& bodies() const { return active_; }
+
+ private:
+  // moved_ is owned by the physics thread, active_ by the main thread, and
+  // published_ is guarded by the mutex.
+  using List = std::vector<BulletRigidBody*>;
+  using Index = int BulletRigidBody::*;
+
+  List moved_, published_, active_;
+  std::mutex mutex_;
+
+  // Swap-and-pop, keeping the stored indices of the bodies up-to-date.
+  static void Add(List* list, Index index, BulletRigidBody* body);
+  static void Remove(List* list, Index index, BulletRigidBody* body);
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
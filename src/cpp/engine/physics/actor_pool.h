@@ -0,0 +1,102 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_ACTOR_POOL_H_
+#define ENGINE_PHYSICS_ACTOR_POOL_H_
+
+#include <list>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "../game_object.h"
+
+namespace engine {
+
+namespace physics {
+
+// Recycles frequently spawned actors (projectiles, debris), instead of
+// creating and destroying them with their rigid bodies, meshes, and
+// components. The released actors are only disabled, and a spawn reuses
+// them through respawn(), which has the same arguments as the constructor.
+// The actors have to implement:
+//   T(GameObject* parent, Args... args);
+//   void respawn(Args... args);  // reset the state, teleport the bodies
+//   void despawn();              // take the bodies out of the world
+// If max_actors is reached, the living actor that was spawned the longest
+// time ago is respawned.
+template<typename T>
+class ActorPool : public GameObject {
+ public:
+  explicit ActorPool(GameObject* parent, size_t max_actors = 1024)
+      : GameObject(parent), max_actors_(max_actors) {
+    actors_.reserve(max_actors);
+    free_actors_.reserve(max_actors);
+    spawn_order_iters_.reserve(max_actors);
+  }
+
+  template<typename... Args>
+  T* spawn(Args&&... args) {
+    T* actor = nullptr;
+    if (!free_actors_.empty()) {
+      actor = free_actors_.back();
+      free_actors_.pop_back();
+    } else if (actors_.size() >= max_actors_) {
+      // The least recently spawned one becomes the most recent
+      actor = spawn_order_.front();
+      spawn_order_.splice(spawn_order_.end(), spawn_order_,
+                          spawn_order_.begin());
+    } else {
+      actor = addComponent<T>(std::forward<Args>(args)...);
+      if (actor) {
+        actors_.push_back(actor);
+        spawned(actor);
+      }
+      return actor;
+    }
+
+    actor->respawn(std::forward<Args>(args)...);
+    if (!actor->enabled()) {
+      actor->set_enabled(true);
+      spawned(actor);
+    }
+    return actor;
+  }
+
+  void release(T* actor) {
+    if (actor->enabled()) {
+      actor->despawn();
+      actor->set_enabled(false);
+      free_actors_.push_back(actor);
+      auto iter = spawn_order_iters_.find(actor);
+      spawn_order_.erase(iter->second);
+      spawn_order_iters_.erase(iter);
+    }
+  }
+
+  void releaseAll() {
+    for (T* actor : actors_) {
+      release(actor);
+    }
+  }
+
+  const std::vector<T*>& actors() const { return actors_; }
+  size_t num_alive() const { return actors_.size() - free_actors_.size(); }
+
+ private:
+  const size_t max_actors_;
+  std::vector<T*> actors_, free_actors_;
+  // The living actors, the least recently spawned one first
+  std::list<T*> spawn_order_;
+  std::unordered_map<T*, typename std::list<T*>::iterator> spawn_order_iters_;
+
+  void spawned(T* actor) {
+    spawn_order_iters_[actor] =
+        spawn_order_.insert(spawn_order_.end(), actor);
+  }
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,168 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <algorithm>
+
+#include "./bullet_rigid_body.h"
+#include "../scene.h"
+#include "../misc.h"
+
+namespace engine {
+namespace physics {
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 std::unique_ptr<btCollisionShape>&& shape,
+                                 bool ignore_rotation)
+    : Behaviour(parent), shape_(std::move(shape))
+    , ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  init(mass, shape_.get());
+}
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 btCollisionShape* shape, bool ignore_rotation)
+    : Behaviour(parent), ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  init(mass, shape);
+}
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 btCollisionShape* shape, const glm::vec3& pos,
+                                 bool ignore_rotation)
+    : Behaviour(parent), ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  transform()->set_pos(pos);
+  init(mass, shape);
+}
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 std::unique_ptr<btCollisionShape>&& shape,
+                                 const glm::vec3& pos, bool ignore_rotation)
+    : Behaviour(parent), shape_(std::move(shape))
+    , ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  transform()->set_pos(pos);
+  init(mass, shape_.get());
+}
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 btCollisionShape* shape, const glm::vec3& pos,
+                                 const glm::fquat& rot, bool ignore_rotation)
+    : Behaviour(parent), ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  transform()->set_pos(pos);
+  transform()->set_rot(rot);
+  init(mass, shape);
+}
+
+BulletRigidBody::BulletRigidBody(GameObject* parent, float mass,
+                                 std::unique_ptr<btCollisionShape>&& shape,
+                                 const glm::vec3& pos, const glm::fquat& rot,
+                                 bool ignore_rotation)
+    : Behaviour(parent), shape_(std::move(shape))
+    , ignore_rotation_(ignore_rotation), simulated_(true)
+    , moved_(-1), published_(-1), active_(-1) {
+  transform()->set_pos(pos);
+  transform()->set_rot(rot);
+  init(mass, shape_.get());
+}
+
+BulletRigidBody::~BulletRigidBody() {
+  scene_->active_bodies().removed(this);
+  scene_->contact_events().bodyRemoved(bt_rigid_body_.get());
+  scene_->world()->removeCollisionObject(bt_rigid_body_.get());
+}
+
+void BulletRigidBody::init(float mass, btCollisionShape* shape) {
+  // The physics thread can't be running at this point (the world is either
+  // locked, or it isn't stepped yet), so it is safe to set up its data here.
+  resetState(transform()->pos(), transform()->rot());
+
+  btVector3 inertia(0, 0, 0);
+  shape->calculateLocalInertia(mass, inertia);
+  btRigidBody::btRigidBodyConstructionInfo info{mass, this, shape, inertia};
+  bt_rigid_body_ = engine::make_unique<btRigidBody>(info);
+  bt_rigid_body_->setUserPointer(parent_);
+  if (mass == 0.0f) { bt_rigid_body_->setRestitution(1.0f); }
+  scene_->world()->addRigidBody(bt_rigid_body_.get());
+}
+
+void BulletRigidBody::resetState(const glm::vec3& pos, const glm::fquat& rot) {
+  physics_transform_.setIdentity();
+  physics_transform_.setOrigin(btVector3{pos.x, pos.y, pos.z});
+  if (!ignore_rotation_) {
+    physics_transform_.setRotation(btQuaternion{rot.x, rot.y, rot.z, rot.w});
+  }
+  snapshots_.reset(Snapshot{physics_transform_, physics_transform_,
+                            scene_->physics_time()});
+}
+
+void BulletRigidBody::teleport(const glm::vec3& pos, const glm::fquat& rot,
+                               const glm::vec3& velocity) {
+  parent_->transform()->set_pos(pos);
+  if (!ignore_rotation_) { parent_->transform()->set_rot(rot); }
+  resetState(pos, rot);
+
+  btRigidBody* body = bt_rigid_body_.get();
+  body->setWorldTransform(physics_transform_);
+  body->setInterpolationWorldTransform(physics_transform_);
+  body->setLinearVelocity(btVector3{velocity.x, velocity.y, velocity.z});
+  body->setAngularVelocity(btVector3{0, 0, 0});
+  body->setInterpolationLinearVelocity(body->getLinearVelocity());
+  body->setInterpolationAngularVelocity(btVector3{0, 0, 0});
+  body->clearForces();
+  body->activate(true);
+}
+
+void BulletRigidBody::set_simulated(bool value) {
+  if (value == simulated_) { return; }
+  simulated_ = value;
+  if (value) {
+    scene_->world()->addRigidBody(bt_rigid_body_.get());
+  } else {
+    // Its GameObject shouldn't be synced while it's out of the world
+    scene_->active_bodies().removed(this);
+    scene_->contact_events().bodyDisabled(bt_rigid_body_.get());
+    scene_->world()->removeRigidBody(bt_rigid_body_.get());
+  }
+}
+
+void BulletRigidBody::getWorldTransform(btTransform &t) const {
+  t = physics_transform_;
+}
+
+void BulletRigidBody::setWorldTransform(const btTransform &t) {
+  Snapshot& snapshot = snapshots_.back();
+  snapshot.previous = physics_transform_;
+  snapshot.current = t;
+  snapshot.time = scene_->physics_time();
+  snapshots_.publish();
+  scene_->active_bodies().moved(this);
+
+  physics_transform_ = t;
+}
+
+bool BulletRigidBody::sync() {
+  snapshots_.acquire();
+
+  // The previous state was simulated until (snapshot.time - time_step)
+  const Snapshot& snapshot = snapshots_.front();
+  double time_step = scene_->physics_time_step();
+  double alpha =
+      (scene_->physics_render_time() - snapshot.time) / time_step + 1;
+  alpha = std::max(0.0, std::min(alpha, 1.0));
+
+  btVector3 o = snapshot.previous.getOrigin().lerp(
+      snapshot.current.getOrigin(), alpha);
+  parent_->transform()->set_pos(glm::vec3(o.x(), o.y(), o.z()));
+  if (!ignore_rotation_) {
+    btQuaternion r = snapshot.previous.getRotation().slerp(
+        snapshot.current.getRotation(), alpha);
+    parent_->transform()->set_rot(glm::quat(r.getW(), r.getX(),
+                                            r.getY(), r.getZ()));
+  }
+
+  return alpha < 1.0;
+}
+
+}  // namespace physics
+}  // namespace engine
@@ -0,0 +1,99 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_BULLET_RIGID_BODY_H_
+#define ENGINE_PHYSICS_BULLET_RIGID_BODY_H_
+
+#include <memory>
+#include <btBulletDynamicsCommon.h>
+
+#include "../behaviour.h"
+#include "../triple_buffer.h"
+
+namespace engine {
+
+namespace physics {
+
+// Connects a GameObject with a btRigidBody. The simulation runs on the
+// physics thread, at a fixed timestep, and it hands over the body's states
+// through a lock-free triple buffer. The GameObject's transform is
+// interpolated between the last two simulated states, so the motion is smooth
+// independently from the framerate. Only the bodies that Bullet moved are
+// synced (see ActiveBodies), there is no per frame cost for the others.
+class BulletRigidBody : public Behaviour, public btMotionState {
+ public:
+  BulletRigidBody(GameObject* parent, float mass,
+                  std::unique_ptr<btCollisionShape>&& shape,
+                  bool ignore_rotation = false);
+
+  BulletRigidBody(GameObject* parent, float mass,
+                  btCollisionShape* shape, bool ignore_rotation = false);
+
+  BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
+                  const glm::vec3& pos, bool ignore_rotation = false);
+
+  BulletRigidBody(GameObject* parent, float mass,
+                  std::unique_ptr<btCollisionShape>&& shape,
+                  const glm::vec3& pos, bool ignore_rotation = false);
+
+  BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
+                  const glm::vec3& pos, const glm::fquat& rot,
+                  bool ignore_rotation = false);
+
+  BulletRigidBody(GameObject* parent, float mass,
+                  std::unique_ptr<btCollisionShape>&& shape,
+                  const glm::vec3& pos, const glm::fquat& rot,
+                  bool ignore_rotation = false);
+
+  virtual ~BulletRigidBody();
+
+  btRigidBody* bt_rigid_body() { return bt_rigid_body_.get(); }
+  const btRigidBody* bt_rigid_body() const { return bt_rigid_body_.get(); }
+
+  // Moves the GameObject and the body to a new state, without interpolating
+  // to it, and without any momentum except the velocity. Needs the physics
+  // lock (that update and the input callbacks are called with).
+  void teleport(const glm::vec3& pos, const glm::fquat& rot = glm::fquat{},
+                const glm::vec3& velocity = glm::vec3{});
+
+  // Takes the body out of the world, or puts it back, while keeping it
+  // (and its contact subscription) alive. Needs the physics lock.
+  bool simulated() const { return simulated_; }
+  void set_simulated(bool value);
+
+ private:
+  // Two consecutive states of the body, the current one is
+  // simulated until 'time', the previous one one step earlier.
+  struct Snapshot {
+    btTransform previous, current;
+    double time;
+  };
+
+  std::unique_ptr<btCollisionShape> shape_;
+  std::unique_ptr<btRigidBody> bt_rigid_body_;
+  bool ignore_rotation_, simulated_;
+  // Owned by ActiveBodies: the body's index in its lists, or -1
+  int moved_, published_, active_;
+
+  // Owned by the physics thread, after the initialization.
+  btTransform physics_transform_;
+  TripleBuffer<Snapshot> snapshots_;
+
+  void init(float mass, btCollisionShape* shape);
+  void resetState(const glm::vec3& pos, const glm::fquat& rot);
+
+  // btMotionState interface, called by the physics thread
+  virtual void getWorldTransform(btTransform &t) const override;
+  virtual void setWorldTransform(const btTransform &t) override;
+
+  // Interpolates the GameObject's transform. Returns false if the
+  // body has reached its last simulated state.
+  bool sync();
+
+  friend class ActiveBodies;
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_CONTACT_EVENT_H_
+#define ENGINE_PHYSICS_CONTACT_EVENT_H_
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace engine {
+
+class GameObject;
+
+namespace physics {
+
+struct ContactEvent {
+  enum class Type { kBegin, kPersist, kEnd };
+
+  Type type;
+  // The object whose rigid body was subscribed for the contact events.
+  GameObject* object;
+  // The object it is touching. Might be nullptr for a kEnd event,
+  // if the other object has been destroyed since.
+  GameObject* other;
+  // The deepest contact point (in world space), and the contact normal
+  // pointing towards the object. Both are undefined for kEnd events.
+  glm::vec3 position, normal;
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,268 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <mutex>
+#include <iostream>
+#include <algorithm>
+
+#include "./contact_event_queue.h"
+#include "../behaviour.h"
+
+namespace engine {
+namespace physics {
+
+// Bullet keeps the manifold points a bit beyond the touching distance,
+// we only count the ones that really touch.
+static const float kContactThreshold = 1e-3f;
+
+// Bullet's contact callbacks are global, this routes them to the queue of
+// the subscribed body's scene. The scenes might be simulated in parallel.
+static std::mutex registry_mutex;
+static std::unordered_map<const btCollisionObject*,
+                          ContactEventQueue*> registry;
+
+ContactEventQueue::~ContactEventQueue() {
+  std::lock_guard<std::mutex> lock{registry_mutex};
+  for (const auto& subscription : subscriptions_) {
+    registry.erase(subscription.first);
+  }
+}
+
+void ContactEventQueue::ContactStarted(btPersistentManifold* const& manifold) {
+  std::lock_guard<std::mutex> lock{registry_mutex};
+  for (const btCollisionObject* body : {manifold->getBody0(),
+                                        manifold->getBody1()}) {
+    auto iter = registry.find(body);
+    if (iter != registry.end()) {
+      iter->second->manifolds_.insert(manifold);
+    }
+  }
+}
+
+void ContactEventQueue::ContactEnded(btPersistentManifold* const& manifold) {
+  std::lock_guard<std::mutex> lock{registry_mutex};
+  for (const btCollisionObject* body : {manifold->getBody0(),
+                                        manifold->getBody1()}) {
+    auto iter = registry.find(body);
+    if (iter != registry.end()) {
+      iter->second->manifolds_.erase(manifold);
+    }
+  }
+}
+
+void ContactEventQueue::subscribe(const btCollisionObject* body,
+                                  Behaviour* listener, short layer_mask,
+                                  bool persist_events) {
+  subscriptions_[body] = Subscription{listener, layer_mask, persist_events};
+  new_subscriptions_.push_back(body);
+
+  std::lock_guard<std::mutex> lock{registry_mutex};
+  gContactStartedCallback = &ContactStarted;
+  gContactEndedCallback = &ContactEnded;
+  registry[body] = this;
+}
+
+void ContactEventQueue::bodyRemoved(const btCollisionObject* body) {
+  subscriptions_.erase(body);
+  {
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    registry.erase(body);
+  }
+  endContacts(body, true);
+}
+
+void ContactEventQueue::bodyDisabled(const btCollisionObject* body) {
+  endContacts(body, false);
+}
+
+void ContactEventQueue::endContacts(const btCollisionObject* body,
+                                    bool removed) {
+  pending_events_.erase(
+      std::remove_if(pending_events_.begin(), pending_events_.end(),
+                     [body](const PendingEvent& e) { return e.self == body; }),
+      pending_events_.end());
+  // A removed body's GameObject might die before the events are delivered
+  if (removed) {
+    for (PendingEvent& e : pending_events_) {
+      if (e.other == body) {
+        e.other = nullptr;
+        e.event.other = nullptr;
+      }
+    }
+  }
+
+  auto iter = std::remove_if(
+      previous_contacts_.begin(), previous_contacts_.end(),
+      [body](const Contact& c) { return c.self == body || c.other == body; });
+  for (auto i = iter; i != previous_contacts_.end(); ++i) {
+    if (i->self != body) {
+      Contact ended = *i;
+      if (removed) { ended.other = nullptr; }
+      addEvent(ContactEvent::Type::kEnd, ended);
+    }
+  }
+  previous_contacts_.erase(iter, previous_contacts_.end());
+
+  // Bullet releases the body's manifolds after this call, and if it was
+  // already unregistered, the ended callback wouldn't find this queue
+  for (auto i = manifolds_.begin(); i != manifolds_.end();) {
+    if ((*i)->getBody0() == body || (*i)->getBody1() == body) {
+      i = manifolds_.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  new_subscriptions_.erase(
+      std::remove(new_subscriptions_.begin(), new_subscriptions_.end(), body),
+      new_subscriptions_.end());
+}
+
+void ContactEventQueue::collect(btDispatcher* dispatcher) {
+  contacts_.clear();
+  if (subscriptions_.empty() && previous_contacts_.empty()) {
+    return;
+  }
+
+  // A body might have been touching something when it got subscribed,
+  // the started callback has already been called for those manifolds.
+  if (!new_subscriptions_.empty()) {
+    std::sort(new_subscriptions_.begin(), new_subscriptions_.end());
+    auto is_new = [this](const btCollisionObject* body) {
+      return std::binary_search(new_subscriptions_.begin(),
+                                new_subscriptions_.end(), body);
+    };
+    int num_manifolds = dispatcher->getNumManifolds();
+    for (int i = 0; i < num_manifolds; ++i) {
+      const btPersistentManifold* manifold =
+          dispatcher->getManifoldByIndexInternal(i);
+      if (manifold->getNumContacts() != 0 &&
+          (is_new(manifold->getBody0()) || is_new(manifold->getBody1()))) {
+        manifolds_.insert(manifold);
+      }
+    }
+    new_subscriptions_.clear();
+  }
+
+  for (const btPersistentManifold* manifold : manifolds_) {
+    if (manifold->getNumContacts() != 0) {
+      addContact(manifold, false);
+      addContact(manifold, true);
+    }
+  }
+  std::sort(contacts_.begin(), contacts_.end());
+  removeDuplicates();
+
+  // Merge the two sorted contact lists
+  auto prev = previous_contacts_.begin();
+  auto curr = contacts_.begin();
+  while (prev != previous_contacts_.end() || curr != contacts_.end()) {
+    if (curr == contacts_.end() ||
+        (prev != previous_contacts_.end() && *prev < *curr)) {
+      addEvent(ContactEvent::Type::kEnd, *prev++);
+    } else if (prev == previous_contacts_.end() || *curr < *prev) {
+      addEvent(ContactEvent::Type::kBegin, *curr++);
+    } else {
+      if (subscriptions_[curr->self].persist_events) {
+        addEvent(ContactEvent::Type::kPersist, *curr);
+      }
+      ++prev, ++curr;
+    }
+  }
+
+  std::swap(contacts_, previous_contacts_);
+}
+
+void ContactEventQueue::addContact(const btPersistentManifold* manifold,
+                                   bool swap) {
+  const btCollisionObject* self = swap ? manifold->getBody1()
+                                       : manifold->getBody0();
+  const btCollisionObject* other = swap ? manifold->getBody0()
+                                        : manifold->getBody1();
+
+  auto subscription = subscriptions_.find(self);
+  if (subscription == subscriptions_.end()) { return; }
+
+  const btBroadphaseProxy* proxy = other->getBroadphaseHandle();
+  if (!proxy ||
+      !(proxy->m_collisionFilterGroup & subscription->second.layer_mask)) {
+    return;
+  }
+
+  const btManifoldPoint* deepest = nullptr;
+  int num_contacts = manifold->getNumContacts();
+  for (int i = 0; i < num_contacts; ++i) {
+    const btManifoldPoint& pt = manifold->getContactPoint(i);
+    if (pt.getDistance() < kContactThreshold &&
+        (!deepest || pt.getDistance() < deepest->getDistance())) {
+      deepest = &pt;
+    }
+  }
+  if (!deepest) { return; }
+
+  // The manifold's normal points from body1 towards body0
+  const btVector3& pos = swap ? deepest->getPositionWorldOnB()
+                              : deepest->getPositionWorldOnA();
+  btVector3 normal = swap ? -deepest->m_normalWorldOnB
+                          : deepest->m_normalWorldOnB;
+  contacts_.push_back(Contact{self, other,
+                              glm::vec3(pos.x(), pos.y(), pos.z()),
+                              glm::vec3(normal.x(), normal.y(), normal.z()),
+                              deepest->getDistance()});
+}
+
+// Compound shapes can have several manifolds between the same two bodies,
+// but they should only generate one event per step: keep the deepest point.
+void ContactEventQueue::removeDuplicates() {
+  if (contacts_.empty()) { return; }
+  auto last = contacts_.begin();
+  for (auto curr = last + 1; curr != contacts_.end(); ++curr) {
+    if (last->self == curr->self && last->other == curr->other) {
+      if (curr->distance < last->distance) { *last = *curr; }
+    } else {
+      *++last = *curr;
+    }
+  }
+  contacts_.erase(last + 1, contacts_.end());
+}
+
+void ContactEventQueue::addEvent(ContactEvent::Type type,
+                                 const Contact& contact) {
+  auto subscription = subscriptions_.find(contact.self);
+  if (subscription == subscriptions_.end()) { return; }
+
+  auto self = static_cast<GameObject*>(contact.self->getUserPointer());
+  auto other = contact.other ?
+      static_cast<GameObject*>(contact.other->getUserPointer()) : nullptr;
+  pending_events_.push_back(PendingEvent{
+      subscription->second.listener, contact.self, contact.other,
+      ContactEvent{type, self, other, contact.position, contact.normal}});
+}
+
+void ContactEventQueue::dispatch() {
+  if (pending_events_.empty()) { return; }
+
+  // Group the events by the listener, but keep their order otherwise
+  std::stable_sort(pending_events_.begin(), pending_events_.end(),
+                   [](const PendingEvent& a, const PendingEvent& b) {
+                     return a.listener < b.listener;
+                   });
+
+  for (auto begin = pending_events_.begin(); begin != pending_events_.end();) {
+    Behaviour* listener = begin->listener;
+    batch_.clear();
+    auto end = begin;
+    for (; end != pending_events_.end() && end->listener == listener; ++end) {
+      batch_.push_back(end->event);
+    }
+    try {
+      listener->contacts(batch_);
+    } catch (const std::exception& ex) {
+      std::cerr << "Contact handler failed: " << ex.what() << std::endl;
+    }
+    begin = end;
+  }
+
+  pending_events_.clear();
+}
+
+}  // namespace physics
+}  // namespace engine
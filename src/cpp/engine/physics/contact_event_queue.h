@@ -0,0 +1,101 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_CONTACT_EVENT_QUEUE_H_
+#define ENGINE_PHYSICS_CONTACT_EVENT_QUEUE_H_
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <btBulletDynamicsCommon.h>
+
+#include "./contact_event.h"
+
+namespace engine {
+
+class Behaviour;
+
+namespace physics {
+
+// Turns the persistent manifolds into begin / persist / end contact events
+// for the subscribed rigid bodies. The events are collected by the physics
+// thread after every step, and delivered on the main thread, as one batch
+// per listener per frame (through Behaviour::contacts).
+// Only the manifolds that involve a subscribed body are looked at: bullet's
+// contact started / ended callbacks keep track of them, so the cost of a
+// step doesn't depend on the number of contacts in the whole world.
+class ContactEventQueue {
+ public:
+  ContactEventQueue() = default;
+  ContactEventQueue(const ContactEventQueue&) = delete;
+  ~ContactEventQueue();
+
+  // The listener will receive the contacts of the body with the objects
+  // whose collision filter group is in the layer_mask. The persist events
+  // are only generated when they are explicitly asked for.
+  void subscribe(const btCollisionObject* body, Behaviour* listener,
+                 short layer_mask = btBroadphaseProxy::AllFilter,
+                 bool persist_events = false);
+
+  // Must be called before a body is destroyed. Drops the body's subscription
+  // and the events pointing to its listener, and it ends its contacts
+  // (with a nullptr as the other object).
+  void bodyRemoved(const btCollisionObject* body);
+
+  // Should be called when a body is taken out of the world temporarily.
+  // Ends its contacts, and drops its undelivered events, but the
+  // subscription is kept for when it gets back into the world.
+  void bodyDisabled(const btCollisionObject* body);
+
+  // Compares the contacts with the previous step's. Physics thread only.
+  // The dispatcher is only walked through if there are bodies subscribed
+  // since the last call, to pick up the contacts they already had.
+  void collect(btDispatcher* dispatcher);
+
+  // Delivers the events collected since the last call. Main thread only.
+  void dispatch();
+
+ private:
+  struct Subscription {
+    Behaviour* listener;
+    short layer_mask;
+    bool persist_events;
+  };
+
+  struct Contact {
+    const btCollisionObject *self, *other;
+    glm::vec3 position, normal;
+    float distance;
+
+    bool operator<(const Contact& rhs) const {
+      return self < rhs.self || (self == rhs.self && other < rhs.other);
+    }
+  };
+
+  struct PendingEvent {
+    Behaviour* listener;
+    const btCollisionObject *self, *other;
+    ContactEvent event;
+  };
+
+  std::unordered_map<const btCollisionObject*, Subscription> subscriptions_;
+  // The manifolds with at least one point, that involve a subscribed body
+  std::unordered_set<const btPersistentManifold*> manifolds_;
+  std::vector<const btCollisionObject*> new_subscriptions_;
+  std::vector<Contact> contacts_, previous_contacts_;
+  std::vector<PendingEvent> pending_events_;
+  std::vector<ContactEvent> batch_;
+
+  static void ContactStarted(btPersistentManifold* const& manifold);
+  static void ContactEnded(btPersistentManifold* const& manifold);
+
+  void addContact(const btPersistentManifold* manifold, bool swap);
+  void removeDuplicates();
+  void addEvent(ContactEvent::Type type, const Contact& contact);
+  void endContacts(const btCollisionObject* body, bool removed);
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
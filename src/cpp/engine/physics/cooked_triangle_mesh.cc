@@ -0,0 +1,182 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "./cooked_triangle_mesh.h"
+#include "../assimp.h"
+#include "../misc.h"
+#include "../binary_stream.h"
+
+namespace engine {
+namespace physics {
+
+namespace {
+
+const char kMagic[4] = {'L', 'B', 'V', 'H'};
+const std::uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  // The layout of the in-place BVH depends on these
+  std::uint32_t scalar_size, pointer_size;
+  std::uint32_t num_vertices, num_indices;
+  std::uint64_t bvh_offset, bvh_size;
+};
+
+// The BVH has to start on a 16 bytes boundary
+std::uint64_t AlignedOffset(std::uint64_t offset) {
+  return (offset + 15) & ~std::uint64_t(15);
+}
+
+}  // namespace
+
+CookedTriangleMesh::CookedTriangleMesh(const std::string& source_path,
+                                       const std::string& cooked_path) {
+  if (MappedFile::ModificationTime(source_path) >
+        MappedFile::ModificationTime(cooked_path) || !load(cooked_path)) {
+    cook(source_path, cooked_path);
+  }
+
+  // The BVH is in the mapped file, or in the shape if it has been just cooked
+  size_t size = file_.size() + sizeof(float)*vertices_.size() +
+                sizeof(int)*indices_.size();
+  if (!file_) {
+    size += shape_->getOptimizedBvh()->calculateSerializeBufferSize();
+  }
+  memory_ = debug::MemoryTracker::Allocation{"physics", cooked_path,
+      debug::MemoryTracker::Category::kCpu, size};
+}
+
+bool CookedTriangleMesh::load(const std::string& cooked_path) {
+  try {
+    file_ = MappedFile{cooked_path};
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+
+  Header header;
+  if (file_.size() < sizeof(header)) { return false; }
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion ||
+      header.scalar_size != sizeof(btScalar) ||
+      header.pointer_size != sizeof(void*) ||
+      header.num_indices % 3 != 0 ||
+      header.bvh_offset % 16 != 0 ||
+      header.bvh_offset < sizeof(header) + 3*sizeof(float)*header.num_vertices
+                          + sizeof(int)*header.num_indices ||
+      header.bvh_offset + header.bvh_size != file_.size()) {
+    std::cerr << "Ignoring the invalid cooked mesh " << cooked_path
+              << std::endl;
+    file_ = MappedFile{};
+    return false;
+  }
+
+  unsigned char* data = file_.data();
+  auto vertices = reinterpret_cast<const float*>(data + sizeof(header));
+  auto indices = reinterpret_cast<const int*>(
+      vertices + 3*header.num_vertices);
+  btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(
+      data + header.bvh_offset, header.bvh_size, false);
+  if (!bvh) {
+    file_ = MappedFile{};
+    return false;
+  }
+
+  setupMesh(vertices, header.num_vertices, indices, header.num_indices);
+  // The BVH lives in the mapping, the shape doesn't own it
+  shape_ = make_unique<btBvhTriangleMeshShape>(mesh_.get(), true, false);
+  shape_->setOptimizedBvh(bvh);
+  return true;
+}
+
+void CookedTriangleMesh::cook(const std::string& source_path,
+                              const std::string& cooked_path) {
+  Assimp::Importer importer;
+  const aiScene* scene = importer.ReadFile(
+      source_path, aiProcess_PreTransformVertices | aiProcess_Triangulate);
+  if (!scene) {
+    throw std::runtime_error("Error parsing " + source_path + " : " +
+                             importer.GetErrorString());
+  }
+
+  // All the meshes are merged into one
+  for (unsigned mesh_idx = 0; mesh_idx < scene->mNumMeshes; ++mesh_idx) {
+    const aiMesh* mesh = scene->mMeshes[mesh_idx];
+    int base_vertex = vertices_.size() / 3;
+    for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+      const aiVector3D& v = mesh->mVertices[i];
+      vertices_.insert(vertices_.end(), {v.x, v.y, v.z});
+    }
+    for (unsigned i = 0; i < mesh->mNumFaces; ++i) {
+      const aiFace& face = mesh->mFaces[i];
+      if (face.mNumIndices == 3) {  // Points and lines are ignored
+        indices_.insert(indices_.end(), {base_vertex + int(face.mIndices[0]),
+                                         base_vertex + int(face.mIndices[1]),
+                                         base_vertex + int(face.mIndices[2])});
+      }
+    }
+  }
+
+  setupMesh(vertices_.data(), vertices_.size() / 3,
+            indices_.data(), indices_.size());
+  shape_ = make_unique<btBvhTriangleMeshShape>(mesh_.get(), true, true);
+
+  const btOptimizedBvh* bvh = shape_->getOptimizedBvh();
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.scalar_size = sizeof(btScalar);
+  header.pointer_size = sizeof(void*);
+  header.num_vertices = vertices_.size() / 3;
+  header.num_indices = indices_.size();
+  std::uint64_t data_end = sizeof(header) + sizeof(float)*vertices_.size()
+                           + sizeof(int)*indices_.size();
+  header.bvh_offset = AlignedOffset(data_end);
+  header.bvh_size = bvh->calculateSerializeBufferSize();
+
+  void* bvh_data = btAlignedAlloc(header.bvh_size, 16);
+  bvh->serializeInPlace(bvh_data, header.bvh_size, false);
+
+  bool saved = WriteFileAtomically(cooked_path, [&](std::ofstream& file) {
+    const char padding[16] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(vertices_.data()),
+               sizeof(float)*vertices_.size());
+    file.write(reinterpret_cast<const char*>(indices_.data()),
+               sizeof(int)*indices_.size());
+    file.write(padding, header.bvh_offset - data_end);
+    file.write(static_cast<const char*>(bvh_data), header.bvh_size);
+  });
+  btAlignedFree(bvh_data);
+
+  // The shape is already built, so this isn't fatal, just slow next time
+  if (!saved) {
+    std::cerr << "Couldn't write the cooked mesh " << cooked_path
+              << std::endl;
+  }
+}
+
+void CookedTriangleMesh::setupMesh(const float* vertices, int num_vertices,
+                                   const int* indices, int num_indices) {
+  btIndexedMesh mesh;
+  mesh.m_numVertices = num_vertices;
+  mesh.m_vertexBase = reinterpret_cast<const unsigned char*>(vertices);
+  mesh.m_vertexStride = 3*sizeof(float);
+  mesh.m_vertexType = PHY_FLOAT;
+  mesh.m_numTriangles = num_indices / 3;
+  mesh.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(indices);
+  mesh.m_triangleIndexStride = 3*sizeof(int);
+  mesh.m_indexType = PHY_INTEGER;
+
+  mesh_ = make_unique<btTriangleIndexVertexArray>();
+  mesh_->addIndexedMesh(mesh, PHY_INTEGER);
+}
+
+}  // namespace physics
+}  // namespace engine
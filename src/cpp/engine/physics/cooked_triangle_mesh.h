@@ -0,0 +1,53 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_COOKED_TRIANGLE_MESH_H_
+#define ENGINE_PHYSICS_COOKED_TRIANGLE_MESH_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <btBulletDynamicsCommon.h>
+
+#include "../mapped_file.h"
+#include "../debug/memory_tracker.h"
+
+namespace engine {
+
+namespace physics {
+
+// A static triangle mesh collider, whose triangles and quantized BVH are
+// cooked into a binary file. Loading the cooked file is just a mapping and
+// an in-place deserialization of the BVH, nothing is parsed or built.
+// The cooked format depends on the platform (float size, pointer size,
+// endianness), it is a cache and not an asset to distribute.
+class CookedTriangleMesh {
+ public:
+  // Loads the cooked file, and if it is missing, invalid or older than the
+  // source model, cooks it first from the source (through assimp).
+  CookedTriangleMesh(const std::string& source_path,
+                     const std::string& cooked_path);
+
+  btBvhTriangleMeshShape* shape() { return shape_.get(); }
+
+ private:
+  // The storage of the triangles, either the mapped cooked file, or the
+  // vectors if the mesh has been just cooked.
+  MappedFile file_;
+  std::vector<float> vertices_;
+  std::vector<int> indices_;
+  debug::MemoryTracker::Allocation memory_;
+
+  std::unique_ptr<btTriangleIndexVertexArray> mesh_;
+  std::unique_ptr<btBvhTriangleMeshShape> shape_;
+
+  bool load(const std::string& cooked_path);
+  void cook(const std::string& source_path, const std::string& cooked_path);
+  void setupMesh(const float* vertices, int num_vertices,
+                 const int* indices, int num_indices);
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
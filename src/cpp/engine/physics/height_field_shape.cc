@@ -0,0 +1,67 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./height_field_shape.h"
+#include "../misc.h"
+
+namespace engine {
+namespace physics {
+
+template<typename T>
+static std::unique_ptr<btHeightfieldTerrainShape> CreateShape(
+    const HeightMapInterface& height_map, const glm::ivec2& offset,
+    const glm::ivec2& size, glm::vec3* center) {
+  int stride = height_map.w();
+  const T* data = static_cast<const T*>(height_map.data()) +
+                  offset.y*stride + offset.x;
+  double scale = height_map.height_scale();
+
+  T min = std::numeric_limits<T>::max(), max = std::numeric_limits<T>::lowest();
+  for (int y = 0; y < size.y; ++y) {
+    const T* row = data + y*stride;
+    auto minmax = std::minmax_element(row, row + size.x);
+    min = std::min(min, *minmax.first);
+    max = std::max(max, *minmax.second);
+  }
+  btScalar min_height = min * scale, max_height = max * scale;
+
+  // Bullet centers the shape around the middle of its bounding box
+  *center = glm::vec3(offset.x + (size.x - 1) / 2.0f,
+                      (min_height + max_height) / 2.0f,
+                      offset.y + (size.y - 1) / 2.0f);
+
+  return std::unique_ptr<btHeightfieldTerrainShape>{new HeightFieldShape<T>{
+      data, size.x, size.y, stride, scale, min_height, max_height}};
+}
+
+std::unique_ptr<btHeightfieldTerrainShape> CreateHeightFieldShape(
+    const HeightMapInterface& height_map, const glm::ivec2& offset,
+    const glm::ivec2& size, glm::vec3* center) {
+  switch (height_map.type()) {
+    case gl::kByte:
+      return CreateShape<GLbyte>(height_map, offset, size, center);
+    case gl::kUnsignedByte:
+      return CreateShape<GLubyte>(height_map, offset, size, center);
+    case gl::kShort:
+      return CreateShape<GLshort>(height_map, offset, size, center);
+    case gl::kUnsignedShort:
+      return CreateShape<GLushort>(height_map, offset, size, center);
+    case gl::kFloat:
+      return CreateShape<GLfloat>(height_map, offset, size, center);
+    default:
+      throw std::invalid_argument("Unsupported heightmap type for physics.");
+  }
+}
+
+std::unique_ptr<btHeightfieldTerrainShape> CreateHeightFieldShape(
+    const HeightMapInterface& height_map, glm::vec3* center) {
+  return CreateHeightFieldShape(height_map, glm::ivec2(),
+                                glm::ivec2(height_map.w(), height_map.h()),
+                                center);
+}
+
+}  // namespace physics
+}  // namespace engine
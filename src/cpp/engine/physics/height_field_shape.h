@@ -0,0 +1,68 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_HEIGHT_FIELD_SHAPE_H_
+#define ENGINE_PHYSICS_HEIGHT_FIELD_SHAPE_H_
+
+#include <memory>
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+
+#include "../height_map_interface.h"
+
+namespace engine {
+
+namespace physics {
+
+// A heightfield shape that reads the heightmap's storage directly, in its
+// native type and precision, instead of working on a converted copy of it.
+// It can also cover just a part of the heightmap (see stride).
+// As the storage is shared, modifications of the heightmap are immediately
+// visible to the physics too. A modification that leaves the [min_height,
+// max_height] range needs a new shape, which is cheap, as nothing is copied.
+template<typename T>
+class HeightFieldShape : public btHeightfieldTerrainShape {
+ public:
+  // data points to the first texel of the covered area, the rows of the
+  // area are stride texels apart.
+  HeightFieldShape(const T* data, int width, int length, int stride,
+                   double height_scale, btScalar min_height,
+                   btScalar max_height)
+      : btHeightfieldTerrainShape(width, length, data, height_scale,
+                                  min_height, max_height, 1,
+                                  ScalarType(), true)
+      , data_(data), stride_(stride), height_scale_(height_scale) {}
+
+ protected:
+  virtual btScalar getRawHeightFieldValue(int x, int y) const override {
+    return data_[y*stride_ + x] * height_scale_;
+  }
+
+ private:
+  const T* data_;
+  int stride_;
+  btScalar height_scale_;
+
+  // The base class doesn't read the data (as the value getter is overridden)
+  // but let it know about the type anyway, where it has a matching one.
+  static PHY_ScalarType ScalarType() {
+    return std::is_same<T, unsigned char>::value ? PHY_UCHAR :
+           std::is_same<T, short>::value ? PHY_SHORT : PHY_FLOAT;
+  }
+};
+
+// Creates a shape for the heightmap's area starting at the texel 'offset'
+// with 'size' texels, that shares the storage with the heightmap.
+// 'center' is set to the position the rigid body should be placed at.
+std::unique_ptr<btHeightfieldTerrainShape> CreateHeightFieldShape(
+    const HeightMapInterface& height_map, const glm::ivec2& offset,
+    const glm::ivec2& size, glm::vec3* center);
+
+// Creates a shape for the whole heightmap.
+std::unique_ptr<btHeightfieldTerrainShape> CreateHeightFieldShape(
+    const HeightMapInterface& height_map, glm::vec3* center);
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,250 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <cmath>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <algorithm>
+
+#include "./height_field_tiles.h"
+#include "./activators.h"
+#include "../misc.h"
+#include "../game_engine.h"
+
+namespace engine {
+namespace physics {
+
+HeightFieldTiles::HeightFieldTiles(GameObject* parent,
+                                   const HeightMapInterface& height_map,
+                                   int tile_size, float radius,
+                                   size_t max_tiles)
+    : Behaviour(parent), height_map_(height_map), tile_size_(tile_size)
+    , radius_(radius), max_tiles_(max_tiles)
+    // Neighbouring tiles share their border texels
+    , num_tiles_((height_map.w() - 2) / tile_size + 1,
+                 (height_map.h() - 2) / tile_size + 1) {}
+
+void HeightFieldTiles::clear() {
+  for (auto& pair : tiles_) {
+    destroyTile(&pair.second);
+  }
+  tiles_.clear();
+  for (auto& job : abandoned_jobs_) {
+    job.wait();
+  }
+  abandoned_jobs_.clear();
+  pending_tiles_.clear();
+  activator_tiles_.clear();
+  prev_activator_tiles_.clear();
+}
+
+void HeightFieldTiles::update() {
+  if (!scene_->world()) { return; }
+
+  std::swap(prev_activator_tiles_, activator_tiles_);
+  activator_tiles_.clear();
+
+  ForEachActivator(scene_, [this](const glm::vec3& pos) {
+    activator_tiles_.push_back(Key(tileOf(pos)));
+  });
+  std::sort(activator_tiles_.begin(), activator_tiles_.end());
+  activator_tiles_.erase(
+      std::unique(activator_tiles_.begin(), activator_tiles_.end()),
+      activator_tiles_.end());
+
+  // The set of tiles only changes when an activator crosses a tile border.
+  // Like with the ActivationGrid, tiles are created in the radius, but only
+  // destroyed if they get further than that plus a tile.
+  if (activator_tiles_ != prev_activator_tiles_) {
+    tiles_to_create_.clear();
+    tiles_to_keep_.clear();
+    for (TileKey key : activator_tiles_) {
+      gatherTilesAround(Coords(key), radius_, &tiles_to_create_);
+      gatherTilesAround(Coords(key), radius_ + tile_size_, &tiles_to_keep_);
+    }
+    for (auto tiles : {&tiles_to_create_, &tiles_to_keep_}) {
+      std::sort(tiles->begin(), tiles->end());
+      tiles->erase(std::unique(tiles->begin(), tiles->end()), tiles->end());
+    }
+
+    for (auto iter = tiles_.begin(); iter != tiles_.end();) {
+      if (std::binary_search(tiles_to_keep_.begin(), tiles_to_keep_.end(),
+                             iter->first)) {
+        ++iter;
+      } else {
+        destroyTile(&iter->second);
+        iter = tiles_.erase(iter);
+      }
+    }
+    pending_tiles_.erase(
+        std::remove_if(pending_tiles_.begin(), pending_tiles_.end(),
+                       [this](TileKey key) { return !tiles_.count(key); }),
+        pending_tiles_.end());
+
+    // The nearest tiles are the most important ones if we hit the limit
+    std::sort(tiles_to_create_.begin(), tiles_to_create_.end(),
+              [this](TileKey a, TileKey b) {
+      return distanceToActivators(a) < distanceToActivators(b);
+    });
+    for (TileKey key : tiles_to_create_) {
+      if (tiles_.count(key)) { continue; }
+      if (tiles_.size() >= max_tiles_ &&
+          !evictFartherThan(distanceToActivators(key))) {
+        if (!limit_logged_) {
+          std::cerr << "HeightFieldTiles: more than " << max_tiles_
+                    << " tiles would be needed, the farthest ones are "
+                       "skipped. Bodies there will fall through the terrain."
+                    << std::endl;
+          limit_logged_ = true;
+        }
+        break;
+      }
+      createTile(key);
+    }
+  }
+
+  // A body mustn't fall through a tile that isn't ready yet, so the tiles
+  // under the activators are waited for, the rest are only polled.
+  for (TileKey key : activator_tiles_) {
+    auto iter = tiles_.find(key);
+    if (iter != tiles_.end() && iter->second.pending.valid()) {
+      finishTile(&iter->second);
+    }
+  }
+  pending_tiles_.erase(
+      std::remove_if(pending_tiles_.begin(), pending_tiles_.end(),
+                     [this](TileKey key) {
+    Tile& tile = tiles_.at(key);
+    if (!tile.pending.valid()) { return true; }
+    if (tile.pending.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      finishTile(&tile);
+      return true;
+    }
+    return false;
+  }), pending_tiles_.end());
+
+  abandoned_jobs_.erase(
+      std::remove_if(abandoned_jobs_.begin(), abandoned_jobs_.end(),
+                     [](const std::future<TileShape>& job) {
+    return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }), abandoned_jobs_.end());
+}
+
+glm::ivec2 HeightFieldTiles::tileOf(const glm::vec3& pos) const {
+  return glm::ivec2(std::floor(pos.x / tile_size_),
+                    std::floor(pos.z / tile_size_));
+}
+
+HeightFieldTiles::TileKey HeightFieldTiles::Key(const glm::ivec2& tile) {
+  return static_cast<TileKey>(
+      (static_cast<std::uint64_t>(static_cast<std::uint32_t>(tile.x)) << 32) |
+      static_cast<std::uint32_t>(tile.y));
+}
+
+glm::ivec2 HeightFieldTiles::Coords(TileKey key) {
+  return glm::ivec2(static_cast<std::int32_t>(key >> 32),
+                    static_cast<std::int32_t>(key & 0xFFFFFFFF));
+}
+
+void HeightFieldTiles::gatherTilesAround(const glm::ivec2& center,
+                                         float radius,
+                                         std::vector<TileKey>* tiles) const {
+  int range = std::ceil(radius / tile_size_);
+  float max_dist = radius / tile_size_;
+  for (int dx = -range; dx <= range; ++dx) {
+    for (int dy = -range; dy <= range; ++dy) {
+      glm::ivec2 tile = center + glm::ivec2(dx, dy);
+      if (tile.x < 0 || num_tiles_.x <= tile.x ||
+          tile.y < 0 || num_tiles_.y <= tile.y) {
+        continue;
+      }
+      float x = std::max(std::abs(dx) - 1, 0);
+      float y = std::max(std::abs(dy) - 1, 0);
+      if (x*x + y*y <= max_dist*max_dist) {
+        tiles->push_back(Key(tile));
+      }
+    }
+  }
+}
+
+int HeightFieldTiles::distanceToActivators(TileKey key) const {
+  glm::ivec2 tile = Coords(key);
+  int min_dist = INT_MAX;
+  for (TileKey activator : activator_tiles_) {
+    glm::ivec2 diff = tile - Coords(activator);
+    min_dist = std::min(min_dist, diff.x*diff.x + diff.y*diff.y);
+  }
+  return min_dist;
+}
+
+bool HeightFieldTiles::evictFartherThan(int distance) {
+  auto farthest = tiles_.end();
+  int max_dist = distance;
+  for (auto iter = tiles_.begin(); iter != tiles_.end(); ++iter) {
+    int dist = distanceToActivators(iter->first);
+    if (dist > max_dist) {
+      farthest = iter;
+      max_dist = dist;
+    }
+  }
+  if (farthest == tiles_.end()) { return false; }
+
+  TileKey key = farthest->first;
+  destroyTile(&farthest->second);
+  tiles_.erase(farthest);
+  pending_tiles_.erase(
+      std::remove(pending_tiles_.begin(), pending_tiles_.end(), key),
+      pending_tiles_.end());
+  return true;
+}
+
+void HeightFieldTiles::createTile(TileKey key) {
+  glm::ivec2 offset = Coords(key) * tile_size_;
+  glm::ivec2 size = glm::min(glm::ivec2(tile_size_ + 1),
+                             glm::ivec2(height_map_.w(), height_map_.h())
+                               - offset);
+
+  // The shape only reads the heightmap, which doesn't change meanwhile
+  const HeightMapInterface* height_map = &height_map_;
+  Tile& tile = tiles_[key];
+  tile.pending = GameEngine::thread_pool()->enqueue(
+      [height_map, offset, size]() {
+    TileShape result;
+    result.shape = CreateHeightFieldShape(*height_map, offset, size,
+                                          &result.center);
+    return result;
+  });
+  pending_tiles_.push_back(key);
+}
+
+void HeightFieldTiles::finishTile(Tile* tile) {
+  TileShape result = tile->pending.get();
+  tile->shape = std::move(result.shape);
+
+  btRigidBody::btRigidBodyConstructionInfo info{0, nullptr, tile->shape.get()};
+  info.m_startWorldTransform.setOrigin(
+      btVector3(result.center.x, result.center.y, result.center.z));
+  info.m_restitution = 1.0f;
+  tile->body = make_unique<btRigidBody>(info);
+  tile->body->setUserPointer(parent_);
+  scene_->world()->addRigidBody(tile->body.get());
+}
+
+void HeightFieldTiles::destroyTile(Tile* tile) {
+  if (tile->pending.valid()) {
+    // A job can't be cancelled, but its result isn't needed anymore.
+    abandoned_jobs_.push_back(std::move(tile->pending));
+  }
+  if (tile->body) {
+    scene_->contact_events().bodyRemoved(tile->body.get());
+    if (scene_->world()) {
+      scene_->world()->removeRigidBody(tile->body.get());
+    }
+    tile->body.reset();
+  }
+  tile->shape.reset();
+}
+
+}  // namespace physics
+}  // namespace engine
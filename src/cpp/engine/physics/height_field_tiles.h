@@ -0,0 +1,92 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_HEIGHT_FIELD_TILES_H_
+#define ENGINE_PHYSICS_HEIGHT_FIELD_TILES_H_
+
+#include <future>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <btBulletDynamicsCommon.h>
+
+#include "../behaviour.h"
+#include "../height_map_interface.h"
+#include "./height_field_shape.h"
+
+namespace engine {
+
+namespace physics {
+
+// Streams the collision of a heightmap in square tiles. Only the tiles
+// around the camera and the active dynamic bodies exist, the others are
+// destroyed, so the number of collision shapes and bodies in the world
+// doesn't depend on its size (but the heightmap itself stays in memory).
+// At most max_tiles exist: if more are needed, the ones farthest from the
+// activators are evicted.
+// The tile shapes are created on the engine's thread pool, only the world
+// insertion happens on the main thread. The tile size should match the
+// terrain's CDLOD leaf node dimension, so that the tiles line up with them.
+class HeightFieldTiles : public Behaviour {
+ public:
+  HeightFieldTiles(GameObject* parent, const HeightMapInterface& height_map,
+                   int tile_size = 128, float radius = 256.0f,
+                   size_t max_tiles = 256);
+  virtual ~HeightFieldTiles() { clear(); }
+
+  // Waits for the jobs in flight, and destroys every tile. It has to be
+  // called before the heightmap dies, if it might die earlier than this.
+  void clear();
+
+  size_t num_tiles() const { return tiles_.size(); }
+
+ private:
+  using TileKey = std::int64_t;
+
+  struct TileShape {
+    std::unique_ptr<btHeightfieldTerrainShape> shape;
+    glm::vec3 center;
+  };
+
+  struct Tile {
+    std::future<TileShape> pending;
+    std::unique_ptr<btHeightfieldTerrainShape> shape;
+    std::unique_ptr<btRigidBody> body;
+  };
+
+  const HeightMapInterface& height_map_;
+  const int tile_size_;
+  const float radius_;
+  const size_t max_tiles_;
+  const glm::ivec2 num_tiles_;
+
+  std::unordered_map<TileKey, Tile> tiles_;
+  // These are kept sorted
+  std::vector<TileKey> activator_tiles_, prev_activator_tiles_;
+  std::vector<TileKey> tiles_to_create_, tiles_to_keep_;
+  std::vector<TileKey> pending_tiles_;
+  // The jobs of the tiles that got out of range, while they were created
+  std::vector<std::future<TileShape>> abandoned_jobs_;
+  bool limit_logged_ = false;
+
+  virtual void update() override;
+
+  glm::ivec2 tileOf(const glm::vec3& pos) const;
+  static TileKey Key(const glm::ivec2& tile);
+  static glm::ivec2 Coords(TileKey key);
+  void gatherTilesAround(const glm::ivec2& center, float radius,
+                         std::vector<TileKey>* tiles) const;
+  // The squared distance (in tiles) to the nearest activator's tile.
+  int distanceToActivators(TileKey key) const;
+  // Destroys the farthest tile if it is farther than the given distance.
+  bool evictFartherThan(int distance);
+  void createTile(TileKey key);
+  void finishTile(Tile* tile);
+  void destroyTile(Tile* tile);
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,218 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <algorithm>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+
+#include "./scene_queries.h"
+#include "../game_object.h"
+#include "../game_engine.h"
+
+namespace engine {
+namespace physics {
+
+namespace {
+
+// The number of queries per parallelFor iteration
+const size_t kQueriesPerJob = 32;
+
+btVector3 ToBullet(const glm::vec3& v) {
+  return btVector3{v.x, v.y, v.z};
+}
+
+glm::vec3 ToGlm(const btVector3& v) {
+  return glm::vec3{v.x(), v.y(), v.z()};
+}
+
+// btDbvtBroadphase::rayTest uses a shared stack, so it can't run on several
+// threads. These policies walk the broadphase trees with btDbvt's stateless
+// functions instead, and test the leaves directly against the shapes.
+struct RayPolicy : public btDbvt::ICollide {
+  btTransform from, to;
+  btCollisionWorld::RayResultCallback* callback;
+
+  virtual void Process(const btDbvtNode* leaf) override {
+    auto proxy = static_cast<btBroadphaseProxy*>(leaf->data);
+    if (!callback->needsCollision(proxy)) { return; }
+    auto object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+    btCollisionWorld::rayTestSingle(from, to, object,
+                                    object->getCollisionShape(),
+                                    object->getWorldTransform(), *callback);
+  }
+};
+
+struct SweepPolicy : public btDbvt::ICollide {
+  const btConvexShape* shape;
+  btTransform from, to;
+  btCollisionWorld::ConvexResultCallback* callback;
+
+  virtual void Process(const btDbvtNode* leaf) override {
+    auto proxy = static_cast<btBroadphaseProxy*>(leaf->data);
+    if (!callback->needsCollision(proxy)) { return; }
+    auto object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+    btCollisionWorld::objectQuerySingle(shape, from, to, object,
+                                        object->getCollisionShape(),
+                                        object->getWorldTransform(),
+                                        *callback, 0.0f);
+  }
+};
+
+QueryHit ToHit(const btCollisionObject* object, const btVector3& position,
+               const btVector3& normal, btScalar fraction) {
+  QueryHit hit;
+  hit.hit = true;
+  // The object is alive now, as the world is locked during the queries
+  auto game_object = static_cast<GameObject*>(object->getUserPointer());
+  hit.object_uid = game_object ? game_object->uid() : -1;
+  hit.position = ToGlm(position);
+  hit.normal = ToGlm(normal);
+  hit.fraction = fraction;
+  return hit;
+}
+
+template<typename Query>
+QueryHit RayTest(const btDbvtBroadphase* broadphase, const Query& query) {
+  btCollisionWorld::ClosestRayResultCallback callback{query.from, query.to};
+  callback.m_collisionFilterMask = query.mask;
+
+  RayPolicy policy;
+  policy.from.setIdentity();
+  policy.from.setOrigin(query.from);
+  policy.to.setIdentity();
+  policy.to.setOrigin(query.to);
+  policy.callback = &callback;
+  for (const btDbvt& tree : broadphase->m_sets) {
+    btDbvt::rayTest(tree.m_root, query.from, query.to, policy);
+  }
+
+  if (!callback.hasHit()) { return QueryHit{}; }
+  return ToHit(callback.m_collisionObject, callback.m_hitPointWorld,
+               callback.m_hitNormalWorld, callback.m_closestHitFraction);
+}
+
+template<typename Query>
+QueryHit SweepTest(const btDbvtBroadphase* broadphase, const Query& query) {
+  btCollisionWorld::ClosestConvexResultCallback callback{query.from,
+                                                         query.to};
+  callback.m_collisionFilterMask = query.mask;
+
+  SweepPolicy policy;
+  policy.shape = query.shape;
+  policy.from.setIdentity();
+  policy.from.setOrigin(query.from);
+  policy.to.setIdentity();
+  policy.to.setOrigin(query.to);
+  policy.callback = &callback;
+
+  btVector3 from_min, from_max, to_min, to_max;
+  query.shape->getAabb(policy.from, from_min, from_max);
+  query.shape->getAabb(policy.to, to_min, to_max);
+  from_min.setMin(to_min);
+  from_max.setMax(to_max);
+  btDbvtVolume volume = btDbvtVolume::FromMM(from_min, from_max);
+  for (const btDbvt& tree : broadphase->m_sets) {
+    tree.collideTV(tree.m_root, volume, policy);
+  }
+
+  if (!callback.hasHit()) { return QueryHit{}; }
+  return ToHit(callback.m_hitCollisionObject, callback.m_hitPointWorld,
+               callback.m_hitNormalWorld, callback.m_closestHitFraction);
+}
+
+// The fallback for the other broadphases, through the world's interface.
+template<typename Query>
+QueryHit WorldTest(const btCollisionWorld* world, const Query& query) {
+  if (query.shape) {
+    btCollisionWorld::ClosestConvexResultCallback callback{query.from,
+                                                           query.to};
+    callback.m_collisionFilterMask = query.mask;
+    btTransform from, to;
+    from.setIdentity();
+    from.setOrigin(query.from);
+    to.setIdentity();
+    to.setOrigin(query.to);
+    world->convexSweepTest(query.shape, from, to, callback);
+    if (!callback.hasHit()) { return QueryHit{}; }
+    return ToHit(callback.m_hitCollisionObject, callback.m_hitPointWorld,
+                 callback.m_hitNormalWorld, callback.m_closestHitFraction);
+  } else {
+    btCollisionWorld::ClosestRayResultCallback callback{query.from, query.to};
+    callback.m_collisionFilterMask = query.mask;
+    world->rayTest(query.from, query.to, callback);
+    if (!callback.hasHit()) { return QueryHit{}; }
+    return ToHit(callback.m_collisionObject, callback.m_hitPointWorld,
+                 callback.m_hitNormalWorld, callback.m_closestHitFraction);
+  }
+}
+
+}  // namespace
+
+size_t QueryBatch::addRay(const glm::vec3& from, const glm::vec3& to,
+                          short mask) {
+  queries_.push_back(Query{nullptr, ToBullet(from), ToBullet(to), mask});
+  return queries_.size() - 1;
+}
+
+size_t QueryBatch::addSweep(const btConvexShape* shape, const glm::vec3& from,
+                            const glm::vec3& to, short mask) {
+  queries_.push_back(Query{shape, ToBullet(from), ToBullet(to), mask});
+  return queries_.size() - 1;
+}
+
+void QueryBatch::clear() {
+  queries_.clear();
+  results_.clear();
+  ready_ = false;
+}
+
+void SceneQueries::submit(const std::shared_ptr<QueryBatch>& batch) {
+  batch->ready_ = false;
+  batch->results_.resize(batch->queries_.size());
+  pending_.push_back(batch);
+}
+
+void SceneQueries::execute(btCollisionWorld* world) {
+  if (pending_.empty()) { return; }
+
+  auto broadphase = dynamic_cast<const btDbvtBroadphase*>(
+      world->getBroadphase());
+  if (!broadphase) {
+    for (const auto& batch : pending_) {
+      for (size_t i = 0; i < batch->queries_.size(); ++i) {
+        batch->results_[i] = WorldTest(world, batch->queries_[i]);
+      }
+      batch->ready_ = true;
+    }
+    pending_.clear();
+    return;
+  }
+
+  chunks_.clear();
+  for (const auto& batch : pending_) {
+    for (size_t begin = 0; begin < batch->queries_.size();
+         begin += kQueriesPerJob) {
+      size_t end = std::min(begin + kQueriesPerJob, batch->queries_.size());
+      chunks_.push_back(Chunk{batch.get(), begin, end});
+    }
+  }
+
+  // This thread takes every chunk that the workers haven't started, so it
+  // never waits behind long jobs, and it doesn't deadlock when it is a pool
+  // thread itself (like the simulations' threads).
+  GameEngine::thread_pool()->parallelFor(chunks_.size(),
+                                         [this, broadphase](size_t c) {
+    const Chunk& chunk = chunks_[c];
+    for (size_t i = chunk.begin; i < chunk.end; ++i) {
+      const auto& query = chunk.batch->queries_[i];
+      chunk.batch->results_[i] = query.shape ? SweepTest(broadphase, query)
+                                             : RayTest(broadphase, query);
+    }
+  });
+
+  for (const auto& batch : pending_) {
+    batch->ready_ = true;
+  }
+  pending_.clear();
+}
+
+}  // namespace physics
+}  // namespace engine
@@ -0,0 +1,93 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_SCENE_QUERIES_H_
+#define ENGINE_PHYSICS_SCENE_QUERIES_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <btBulletDynamicsCommon.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace engine {
+
+namespace physics {
+
+struct QueryHit {
+  bool hit = false;
+  // The uid of the GameObject whose body was hit (-1 if it has none). The
+  // object might be destroyed by the time the result is read, so it has to
+  // be looked up with Scene::findObject, which checks that.
+  int object_uid = -1;
+  glm::vec3 position, normal;
+  // The hit position is at from + fraction * (to - from)
+  float fraction = 1.0f;
+};
+
+// A set of raycasts and convex sweeps, that are executed together, after
+// the physics step that follows the submission. Each query returns the
+// closest hit. The results are usually available in the next frame.
+class QueryBatch {
+ public:
+  // Return the index of the query's result.
+  size_t addRay(const glm::vec3& from, const glm::vec3& to,
+                short mask = btBroadphaseProxy::AllFilter);
+  // The shape must outlive the batch (see ShapeCache).
+  size_t addSweep(const btConvexShape* shape, const glm::vec3& from,
+                  const glm::vec3& to,
+                  short mask = btBroadphaseProxy::AllFilter);
+
+  size_t size() const { return queries_.size(); }
+
+  bool ready() const { return ready_; }
+  const QueryHit& result(size_t i) const { return results_[i]; }
+  const std::vector<QueryHit>& results() const { return results_; }
+
+  // Removes the queries, so the batch can be reused (keeping its memory).
+  // The batch mustn't be in flight (it has to be ready, or not submitted).
+  void clear();
+
+ private:
+  struct Query {
+    const btConvexShape* shape;  // nullptr for rays
+    btVector3 from, to;
+    short mask;
+  };
+
+  std::vector<Query> queries_;
+  std::vector<QueryHit> results_;
+  std::atomic<bool> ready_{false};
+
+  friend class SceneQueries;
+};
+
+// Executes the query batches of a scene. The behaviours submit them during
+// update, and the physics thread runs them after it has stepped the world,
+// so the queries never see (or race with) a half stepped world. The idle
+// workers of the thread pool help, but the physics thread doesn't wait for
+// busy ones, as it holds the world lock meanwhile.
+class SceneQueries {
+ public:
+  // Main thread, with the physics lock held (i.e. from update).
+  void submit(const std::shared_ptr<QueryBatch>& batch);
+
+  // Physics thread, with the physics lock held.
+  void execute(btCollisionWorld* world);
+
+ private:
+  struct Chunk {
+    QueryBatch* batch;
+    size_t begin, end;
+  };
+
+  std::vector<std::shared_ptr<QueryBatch>> pending_;
+  std::vector<Chunk> chunks_;
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
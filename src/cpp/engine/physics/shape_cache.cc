@@ -0,0 +1,40 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./shape_cache.h"
+
+namespace engine {
+namespace physics {
+
+template<typename Shape, typename... Args>
+Shape* ShapeCache::get(const Key& key, Args&&... args) {
+  std::unique_ptr<btCollisionShape>& shape = shapes_[key];
+  if (!shape) {
+    shape.reset(new Shape(std::forward<Args>(args)...));
+  }
+  return static_cast<Shape*>(shape.get());
+}
+
+btBoxShape* ShapeCache::box(const glm::vec3& half_extents) {
+  return get<btBoxShape>(
+      Key{ShapeType::kBox, half_extents.x, half_extents.y, half_extents.z},
+      btVector3{half_extents.x, half_extents.y, half_extents.z});
+}
+
+btSphereShape* ShapeCache::sphere(float radius) {
+  return get<btSphereShape>(Key{ShapeType::kSphere, radius, 0.0f, 0.0f},
+                            radius);
+}
+
+btCapsuleShape* ShapeCache::capsule(float radius, float height) {
+  return get<btCapsuleShape>(Key{ShapeType::kCapsule, radius, height, 0.0f},
+                             radius, height);
+}
+
+btCylinderShape* ShapeCache::cylinder(const glm::vec3& half_extents) {
+  return get<btCylinderShape>(
+      Key{ShapeType::kCylinder, half_extents.x, half_extents.y, half_extents.z},
+      btVector3{half_extents.x, half_extents.y, half_extents.z});
+}
+
+}  // namespace physics
+}  // namespace engine
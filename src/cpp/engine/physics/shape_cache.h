@@ -0,0 +1,44 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_SHAPE_CACHE_H_
+#define ENGINE_PHYSICS_SHAPE_CACHE_H_
+
+#include <map>
+#include <tuple>
+#include <memory>
+#include <btBulletDynamicsCommon.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace engine {
+
+namespace physics {
+
+// Owns the primitive collision shapes, one for every set of parameters.
+// Bullet never modifies a shape, so any number of bodies can share them.
+// The shapes live as long as the cache (the scene), don't delete them.
+class ShapeCache {
+ public:
+  btBoxShape* box(const glm::vec3& half_extents);
+  btSphereShape* sphere(float radius);
+  btCapsuleShape* capsule(float radius, float height);
+  btCylinderShape* cylinder(const glm::vec3& half_extents);
+
+  size_t size() const { return shapes_.size(); }
+
+ private:
+  enum class ShapeType { kBox, kSphere, kCapsule, kCylinder };
+  using Key = std::tuple<ShapeType, float, float, float>;
+
+  std::map<Key, std::unique_ptr<btCollisionShape>> shapes_;
+
+  template<typename Shape, typename... Args>
+  Shape* get(const Key& key, Args&&... args);
+};
+
+}  // namespace physics
+
+}  // namespace engine
+
+#endif
@@ -1,23 +1,132 @@
 // Copyright (c) 2014, Tamas Csala
 
+#include <cassert>
+#include <algorithm>
 #include "./scene.h"
 #include "./game_engine.h"
 
 namespace engine {
 
-Scene::Scene()
+Scene::Scene() : Scene(false) {}
+
+Scene::Scene(SimulationOnly) : Scene(true) {}
+
+Scene::Scene(bool simulation_only)
     : Behaviour(nullptr)
+    , physics_time_step_(1.0 / 60.0)
+    , physics_time_(0.0)
+    , physics_render_time_(0.0)
+    , physics_target_time_(0.0)
+    , physics_published_time_(0.0)
     , physics_thread_should_quit_(false)
-    , physics_thread_{[this](){
-      while (true) {
-        physics_can_run_.waitOne();
-        if (physics_thread_should_quit_) { return; }
-        updatePhysics();
-        physics_finished_.set();
-      }
-    }}
-    , camera_(nullptr), shadow_(nullptr), window_(GameEngine::window()) {
+    , simulation_only_(simulation_only)
+    , camera_(nullptr), shadow_(nullptr)
+    , window_(simulation_only ? nullptr : GameEngine::window()) {
   set_scene(this);
+  if (!simulation_only_) {
+    physics_thread_ = std::thread{&Scene::physicsThread, this};
+  }
+}
+
+void Scene::shutdown() {
+  if (physics_thread_.joinable()) {
+    physics_thread_should_quit_ = true;
+    physics_can_run_.set();
+    physics_thread_.join();
+  }
+}
+
+void Scene::simulate(double dt) {
+  assert(simulation_only_);
+  // This might run on a pooled thread, that only owns a part of its arena
+  FrameArena::Scope frame_arena_scope;
+  game_time_.advance(dt);
+  environment_time_.advance(dt);
+  camera_time_.advance(dt);
+  syncPhysics();
+  {
+    std::lock_guard<std::mutex> lock{physics_mutex_};
+    updateAll();
+  }
+  physics_target_time_ = game_time_.current;
+  stepPhysics(game_time_.current);
+}
+
+void Scene::syncPhysics() {
+  // simulate() advances the timers itself
+  if (!simulation_only_) {
+    if (Clock::simulated()) {
+      // Sum up the same steps as the physics time does, instead of
+      // differencing the clock, so that with dt == physics_time_step_ every
+      // frame gets exactly one physics step.
+      double dt = Clock::simulated_dt();
+      game_time_.advance(dt);
+      environment_time_.advance(dt);
+      camera_time_.advance(dt);
+    } else {
+      game_time_.tick();
+      environment_time_.tick();
+      camera_time_.tick();
+    }
+  }
+  physics_render_time_ = std::min(game_time_.current - physics_time_step_,
+                                  physics_published_time_.load());
+  ENGINE_PROFILE("sync bodies");
+  active_bodies_.sync();
+}
+
+void Scene::startPhysics() {
+  physics_target_time_ = game_time_.current;
+  if (GameEngine::deterministic()) {
+    // The physics thread takes the lock once per step, so how many steps the
+    // next update sees would depend on the scheduling.
+    ENGINE_PROFILE("physics");
+    stepPhysics(physics_target_time_);
+  } else {
+    physics_can_run_.set();
+  }
+}
+
+void Scene::physicsThread() {
+  debug::Profiler::SetThreadName("physics");
+  while (true) {
+    physics_can_run_.waitOne();
+    if (physics_thread_should_quit_) { return; }
+    stepPhysics(physics_target_time_);
+  }
+}
+
+void Scene::stepPhysics(double target_time) {
+  FrameArena::Scope frame_arena_scope;
+  int steps = 0;
+  while (physics_time_ + physics_time_step_ <= target_time) {
+    // If the simulation can't keep up with the game time, then drop the
+    // time it lags behind, as catching up would only make the lag worse.
+    // The main thread reads physics_time_ under the lock (see
+    // BulletRigidBody::resetState), so both writes are done holding it.
+    std::lock_guard<std::mutex> lock{physics_mutex_};
+    if (steps++ == kMaxPhysicsStepsPerFrame) {
+      physics_time_ = target_time;
+      break;
+    }
+
+    ENGINE_PROFILE("physics step");
+    physics_time_ += physics_time_step_;
+    updatePhysics(physics_time_step_);
+    if (world_) {
+      ENGINE_PROFILE("contact events");
+      contact_events_.collect(world_->getDispatcher());
+    }
+    active_bodies_.publish();
+    physics_published_time_ = physics_time_;
+  }
+
+  // The queries of this frame see the world after all of its steps
+  if (world_) {
+    std::lock_guard<std::mutex> lock{physics_mutex_};
+    ENGINE_PROFILE("scene queries");
+    queries_.execute(world_.get());
+  }
 }
 
 ShaderManager* Scene::shader_manager() {
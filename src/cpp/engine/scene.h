@@ -3,19 +3,31 @@
 #ifndef ENGINE_SCENE_H_
 #define ENGINE_SCENE_H_
 
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include <btBulletDynamicsCommon.h>
 
 #include "./oglwrap_config.h"
 #include "../oglwrap/oglwrap.h"
+#include <GLFW/glfw3.h>
 
 #include "./timer.h"
 #include "./camera.h"
 #include "./game_object.h"
 #include "./behaviour.h"
+#include "./frame_arena.h"
+#include "./upload_queue.h"
 #include "./shader_manager.h"
 #include "./auto_reset_event.h"
+#include "./debug/profiler.h"
+#include "./physics/active_bodies.h"
+#include "./physics/contact_event_queue.h"
+#include "./physics/scene_queries.h"
+#include "./physics/shape_cache.h"
 
 #include "../shadow.h"
 
@@ -25,25 +37,78 @@ class GameObject;
 
 class Scene : public Behaviour {
  public:
+  // A simulation-only scene doesn't need a window or a GL context, so every
+  // component of it has to be GL free. It is advanced by simulate() on the
+  // calling thread (there is no physics thread), and its render callbacks are
+  // never called, so many of them can run in parallel.
+  struct SimulationOnly {};
+
   Scene();
+  explicit Scene(SimulationOnly);
   virtual ~Scene() {
+    // Should have been called before the derived scene's members died
+    shutdown();
+
     // The GameObject's destructor have to run here
-    // as they might use the scene ptr in their destructor
-    for (auto& comp_ptr : components_) {
-      comp_ptr.reset();
+    // as they might use the scene ptr in their destructor.
+    // The later components might use the earlier ones (like the trees
+    // unregister from the activation grid), so they die first.
+    for (auto iter = components_.rbegin(); iter != components_.rend(); ++iter) {
+      iter->reset();
     }
-
-    // close the physics thread
-    physics_thread_should_quit_ = true;
-    physics_can_run_.set();
-    physics_thread_.join();
   }
 
+  // Stops the physics thread. It has to be called before the scene is
+  // deleted (GameEngine does so), as the steps might use the members of the
+  // derived scenes, which die before ~Scene runs.
+  void shutdown();
+
   virtual float gravity() const { return 9.81f; }
 
   const btDynamicsWorld* world() const { return world_.get(); }
   btDynamicsWorld* world() { return world_.get(); }
 
+  // The physics is always stepped with this fixed timestep (in seconds),
+  // independently from the framerate.
+  double physics_time_step() const { return physics_time_step_; }
+
+  // The game time that the simulation has reached. Should only be used from
+  // the physics thread (i.e. from a btMotionState), or while holding the
+  // physics lock (i.e. from update()).
+  double physics_time() const { return physics_time_; }
+
+  // The time that the rendered state of the rigid bodies should represent.
+  // It is one step behind the game time, so the bodies have two simulated
+  // states to interpolate between, but never later than the last state that
+  // the physics thread has published.
+  double physics_render_time() const { return physics_render_time_; }
+
+  physics::ContactEventQueue& contact_events() { return contact_events_; }
+
+  // Raycasts and sweeps, executed asynchronously after the physics step.
+  physics::SceneQueries& queries() { return queries_; }
+
+  // Returns the living GameObject of the scene with the given uid, or nullptr
+  // if it has been destroyed since (or there wasn't any). For the handles
+  // that might outlive the objects, like the scene queries' results.
+  GameObject* findObject(int uid) const {
+    auto iter = objects_.find(uid);
+    return iter != objects_.end() ? iter->second : nullptr;
+  }
+
+  // The rigid bodies that moved recently.
+  physics::ActiveBodies& active_bodies() { return active_bodies_; }
+
+  // The primitive collision shapes, shared by every body in the scene.
+  physics::ShapeCache& shape_cache() { return shape_cache_; }
+
+  // The world is only modified by the physics thread while this lock is held.
+  // update() is called with it, but the world should be locked too, when it
+  // is modified from anywhere else (i.e. from an input callback).
+  std::unique_lock<std::mutex> lockPhysics() {
+    return std::unique_lock<std::mutex>{physics_mutex_};
+  }
+
   const Timer& game_time() const { return game_time_; }
   Timer& game_time() { return game_time_; }
 
@@ -66,6 +131,16 @@ class Scene : public Behaviour {
   GLFWwindow* window() const { return window_; }
   void set_window(GLFWwindow* window) { window_ = window; }
 
+  bool simulation_only() const { return simulation_only_; }
+
+  // The GL work that is left from the scene's construction, if it has been
+  // built on a worker thread (see GameEngine::LoadSceneAsync).
+  UploadQueue& upload_queue() { return upload_queue_; }
+
+  // Advances a simulation-only scene by dt seconds of game time: updates the
+  // behaviours, then steps the physics up to the new game time.
+  void simulate(double dt);
+
   virtual void keyAction(int key, int scancode, int action, int mods) override {
     if (action == GLFW_PRESS) {
       switch (key) {
@@ -82,12 +157,39 @@ class Scene : public Behaviour {
   }
 
   virtual void turn() {
-    physics_finished_.waitOne();
-    updateAll();
-    physics_can_run_.set();
-    shadowRenderAll();
-    renderAll();
-    render2DAll();
+    if (simulation_only_) {
+      simulate(physics_time_step_);
+      return;
+    }
+
+    syncPhysics();
+    {
+      std::unique_lock<std::mutex> lock{physics_mutex_, std::defer_lock};
+      {
+        ENGINE_PROFILE("wait for physics");
+        lock.lock();
+      }
+      ENGINE_PROFILE("update");
+      updateAll();
+    }
+    // let the physics catch up with the game time, while we are rendering
+    startPhysics();
+
+    {
+      ENGINE_PROFILE("shadow");
+      shadowRenderAll();
+    }
+    {
+      ENGINE_PROFILE("render");
+      renderAll();
+    }
+    {
+      ENGINE_PROFILE("render2D");
+      render2DAll();
+    }
+
+    // Frees the transient data of the frame
+    FrameArena::ThisThread().reset();
   }
 
  protected:
@@ -97,28 +199,40 @@ class Scene : public Behaviour {
   std::unique_ptr<btBroadphaseInterface> broadphase_;
   std::unique_ptr<btConstraintSolver> solver_;
   std::unique_ptr<btDynamicsWorld> world_;
+  physics::ContactEventQueue contact_events_;
+  physics::ActiveBodies active_bodies_;
+  physics::SceneQueries queries_;
+  physics::ShapeCache shape_cache_;
 
   // physics thread data
-  AutoResetEvent physics_can_run_{false}, physics_finished_{true};
-  bool physics_thread_should_quit_;
+  static const int kMaxPhysicsStepsPerFrame = 8;
+  const double physics_time_step_;
+  double physics_time_, physics_render_time_;
+  std::atomic<double> physics_target_time_;
+  // The time of the last states that the bodies have published.
+  std::atomic<double> physics_published_time_;
+  std::mutex physics_mutex_;
+  AutoResetEvent physics_can_run_{false};
+  std::atomic<bool> physics_thread_should_quit_;
   std::thread physics_thread_;
 
   // Own data
+  const bool simulation_only_;
   Camera* camera_;
   Shadow* shadow_;
   Timer game_time_, environment_time_, camera_time_;
   GLFWwindow* window_;
+  UploadQueue upload_queue_;
+  std::unordered_map<int, GameObject*> objects_;
 
   virtual void updateAll() override {
-    game_time_.tick();
-    environment_time_.tick();
-    camera_time_.tick();
+    contact_events_.dispatch();
 
     Behaviour::updateAll();
   }
 
   virtual void shadowRenderAll() override {
-    if (camera_ && shadow_) {
+    if (camera_ && shadow_ && !simulation_only_) {
       shadow_->begin(); {
         Behaviour::shadowRenderAll();
       } shadow_->end();
@@ -126,10 +240,11 @@ class Scene : public Behaviour {
   }
 
   virtual void renderAll() override {
-    if (camera_) { Behaviour::renderAll(); }
+    if (camera_ && !simulation_only_) { Behaviour::renderAll(); }
   }
 
   virtual void render2DAll() override {
+    if (simulation_only_) { return; }
     gl::TemporarySet capabilities{{{gl::kBlend, true},
                                    {gl::kCullFace, false},
                                    {gl::kDepthTest, false}}};
@@ -138,11 +253,33 @@ class Scene : public Behaviour {
     Behaviour::render2DAll();
   }
 
-  virtual void updatePhysics() {
+  // Advances the simulation by exactly time_step. Called from the physics
+  // thread, with the world locked.
+  virtual void updatePhysics(float time_step) {
     if (world_) {
-      world_->stepSimulation(game_time().dt, 0);
+      world_->stepSimulation(time_step, 0);
     }
   }
+
+ private:
+  explicit Scene(bool simulation_only);
+
+  // GameObject keeps objects_ up-to-date
+  friend class GameObject;
+
+  // Ticks the timers, and interpolates the rigid bodies to the new render
+  // time. It doesn't need the physics lock: the bodies hand over their states
+  // through triple buffers, and the list of the moved ones is swapped under
+  // ActiveBodies' own lock.
+  void syncPhysics();
+
+  // Lets the physics thread step until the game time, or steps the physics
+  // on this thread if the engine is in its deterministic mode.
+  void startPhysics();
+
+  void physicsThread();
+  // Steps the physics until it reaches the target time, then runs the queries.
+  void stepPhysics(double target_time);
 };
 
 }  // namespace engine
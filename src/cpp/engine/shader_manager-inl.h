@@ -25,6 +25,11 @@ inline ShaderFile* ShaderManager::get(const std::string& filename) {
   }
 }
 
+inline ShaderFile* ShaderManager::find(const std::string& filename) {
+  auto iter = shaders_.find(filename);
+  return iter != shaders_.end() ? iter->second.get() : nullptr;
+}
+
 inline ShaderFile* ShaderManager::publish(const std::string& filename,
                                           const gl::ShaderSource& src) {
   return load(filename, src);
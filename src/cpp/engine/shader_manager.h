@@ -41,6 +41,8 @@ class ShaderManager {
  public:
   ShaderFile* publish(const std::string& filename, const gl::ShaderSource& src);
   ShaderFile* get(const std::string& filename);
+  // Returns nullptr if the file hasn't been loaded or published yet.
+  ShaderFile* find(const std::string& filename);
 };
 
 class ShaderFile : public gl::Shader {
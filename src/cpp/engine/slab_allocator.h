@@ -0,0 +1,137 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_SLAB_ALLOCATOR_H_
+#define ENGINE_SLAB_ALLOCATOR_H_
+
+#include <new>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace engine {
+
+// Allocates the small objects from slabs, grouped by their size (rounded up
+// to kGranularity), so the objects of the same type sit together in memory.
+// A freed slot goes to the free list of its size class, and the next
+// allocation of that size reuses it, so both allocate() and deallocate() are
+// O(1), and they only call malloc when a size class runs out of free slots.
+// The slabs are kept until the end of the program. Thread safe.
+class SlabAllocator {
+ public:
+  static const size_t kGranularity = 16;
+  static const size_t kMaxSize = 1024;  // the bigger ones use operator new
+  static const size_t kSlabSize = 64 * 1024;
+
+  static SlabAllocator& Instance() {
+    // It's never destroyed, as static objects might be freed after it.
+    static SlabAllocator* instance = new SlabAllocator{};
+    return *instance;
+  }
+
+  // The size has to be the same for the allocation and the deallocation.
+  void* allocate(size_t size) {
+    if (size > kMaxSize) { return ::operator new(size); }
+
+    SizeClass& size_class = size_classes_[Index(size)];
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+    if (!size_class.free_list) {
+      size_class.grow((Index(size) + 1) * kGranularity);
+    }
+    FreeSlot* slot = size_class.free_list;
+    size_class.free_list = slot->next;
+    ++size_class.used;
+    return slot;
+  }
+
+  void deallocate(void* ptr, size_t size) {
+    if (!ptr) { return; }
+    if (size > kMaxSize) { ::operator delete(ptr); return; }
+
+    SizeClass& size_class = size_classes_[Index(size)];
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+    FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+    slot->next = size_class.free_list;
+    size_class.free_list = slot;
+    --size_class.used;
+  }
+
+  // The number of live objects in the size class of 'size'.
+  size_t used(size_t size) {
+    if (size > kMaxSize) { return 0; }
+    SizeClass& size_class = size_classes_[Index(size)];
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+    return size_class.used;
+  }
+
+  // The memory taken by the slabs of every size class.
+  size_t reserved_bytes() {
+    size_t sum = 0;
+    for (SizeClass& size_class : size_classes_) {
+      std::lock_guard<std::mutex> lock{size_class.mutex};
+      sum += size_class.slabs.size() * kSlabSize;
+    }
+    return sum;
+  }
+
+ private:
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  struct SizeClass {
+    std::mutex mutex;
+    FreeSlot* free_list = nullptr;
+    size_t used = 0;
+    std::vector<std::unique_ptr<char[]>> slabs;
+
+    // Adds a new slab, and puts its slots on the free list, so that they are
+    // handed out in the order of their addresses.
+    void grow(size_t slot_size) {
+      slabs.emplace_back(new char[kSlabSize]);
+      char* slab = slabs.back().get();
+      for (size_t i = kSlabSize / slot_size; i-- > 0;) {
+        FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab + i*slot_size);
+        slot->next = free_list;
+        free_list = slot;
+      }
+    }
+  };
+
+  SizeClass size_classes_[kMaxSize / kGranularity];
+
+  static size_t Index(size_t size) {
+    return size ? (size - 1) / kGranularity : 0;
+  }
+
+  SlabAllocator() = default;
+};
+
+// Allocates the nodes of the standard containers from the SlabAllocator,
+// like for std::set<T, Compare, SlabStlAllocator<T>>.
+template<typename T>
+struct SlabStlAllocator {
+  using value_type = T;
+  template<typename U>
+  struct rebind { using other = SlabStlAllocator<U>; };
+
+  SlabStlAllocator() = default;
+  template<typename U>
+  SlabStlAllocator(const SlabStlAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(SlabAllocator::Instance().allocate(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    SlabAllocator::Instance().deallocate(ptr, n * sizeof(T));
+  }
+
+  template<typename U>
+  bool operator==(const SlabStlAllocator<U>&) const { return true; }
+  template<typename U>
+  bool operator!=(const SlabStlAllocator<U>&) const { return false; }
+};
+
+}  // namespace engine
+
+#endif
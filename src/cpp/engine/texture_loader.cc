@@ -0,0 +1,109 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./texture_loader.h"
+#include "./cooked_texture.h"
+#include "./texture_source.h"
+#include "./misc.h"
+#include "./game_engine.h"
+#include "./debug/memory_tracker.h"
+
+namespace engine {
+
+namespace {
+
+// Throws std::invalid_argument if the texture can't be compressed.
+void ParseFormatString(const std::string& format_string, bool* srgb,
+                       bool* alpha) {
+  std::string channels = format_string;
+  *srgb = channels.find('S') != std::string::npos;
+  channels.erase(std::remove(channels.begin(), channels.end(), 'S'),
+                 channels.end());
+  channels.erase(std::remove(channels.begin(), channels.end(), 'C'),
+                 channels.end());
+  if (channels != "RGB" && channels != "RGBA") {
+    throw std::invalid_argument("LoadTexture: unsupported format '" +
+                                format_string + "'");
+  }
+  *alpha = channels == "RGBA";
+}
+
+// The texture that GetTexture shares, with the record of its memory.
+struct TrackedTexture {
+  gl::Texture2D texture;
+  debug::MemoryTracker::Allocation memory;
+};
+
+}  // namespace
+
+std::string CookedTexturePath(const std::string& filename, bool srgb,
+                              bool alpha) {
+  return filename + (alpha ? ".bc3" : ".bc1") + (srgb ? "_srgb" : "") +
+         ".cooked";
+}
+
+size_t LoadTexture(const std::string& filename,
+                   const std::string& format_string) {
+  bool srgb, alpha;
+  ParseFormatString(format_string, &srgb, &alpha);
+
+  std::string cooked_path = CookedTexturePath(filename, srgb, alpha);
+  std::unique_ptr<CookedTexture> texture;
+  if (MappedFile::ModificationTime(filename) <=
+      MappedFile::ModificationTime(cooked_path)) {
+    texture = CookedTexture::Load(cooked_path);
+  }
+  if (!texture || texture->srgb() != srgb || texture->alpha() != alpha) {
+    TextureSource<unsigned char, 4> image{filename, "RGBA"};
+    texture = make_unique<CookedTexture>(image.w(), image.h(), image.data(),
+                                         srgb, alpha,
+                                         GameEngine::thread_pool());
+    // The texture is already cooked, so this isn't fatal, just slow next time
+    if (!texture->save(cooked_path)) {
+      std::cerr << "Couldn't write the cooked texture " << cooked_path
+                << std::endl;
+    }
+  }
+
+  GLenum internal_format;
+  if (alpha) {
+    internal_format = srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                           : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  } else {
+    internal_format = srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                           : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  }
+  const auto& levels = texture->levels();
+  for (size_t i = 0; i < levels.size(); ++i) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format,
+                           levels[i].w, levels[i].h, 0, levels[i].size,
+                           levels[i].data);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+
+  return texture->size();
+}
+
+std::shared_ptr<gl::Texture2D> GetTexture(const std::string& filename,
+                                          const std::string& format_string) {
+  bool srgb, alpha;
+  ParseFormatString(format_string, &srgb, &alpha);
+  // The cooked file is unique for the image, and what it is loaded as
+  auto tracked = GameEngine::asset_cache()->get<TrackedTexture>(
+      CookedTexturePath(filename, srgb, alpha), [&]() {
+    auto loaded = make_unique<TrackedTexture>();
+    gl::Bind(loaded->texture);
+    size_t size = LoadTexture(filename, format_string);
+    loaded->memory = debug::MemoryTracker::Allocation{"texture", filename,
+        debug::MemoryTracker::Category::kGpuTexture, size};
+    return loaded;
+  });
+  // Shares the ownership of the whole TrackedTexture
+  return std::shared_ptr<gl::Texture2D>{tracked, &tracked->texture};
+}
+
+}  // namespace engine
@@ -0,0 +1,38 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_TEXTURE_LOADER_H_
+#define ENGINE_TEXTURE_LOADER_H_
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+#include "./oglwrap_config.h"
+#include "../oglwrap/textures/texture_2D.h"
+
+namespace engine {
+
+// The cooked file that belongs to an image (see LoadTexture).
+std::string CookedTexturePath(const std::string& filename, bool srgb,
+                              bool alpha);
+
+// Loads an image with its whole mipmap chain, compressed, into the texture
+// bound to GL_TEXTURE_2D. The cooked version (see CookedTexture) is uploaded
+// as it is, if it's up to date, otherwise the image is decoded with Magick++,
+// and cooked for the next time. The texture doesn't need generateMipmap.
+// The format string is "RGB" or "RGBA", with an 'S' if the image is in sRGB
+// colorspace (like in TextureSource, 'C' is allowed, but it is implied).
+// Returns the size of the uploaded data. Throws std::invalid_argument for
+// other formats.
+size_t LoadTexture(const std::string& filename,
+                   const std::string& format_string = "CSRGBA");
+
+// Loads an image into a new texture with LoadTexture, or returns the texture
+// that it has been loaded into with the same format already (see
+// AssetCache). Changes the Texture2D binding.
+std::shared_ptr<gl::Texture2D> GetTexture(
+    const std::string& filename, const std::string& format_string = "CSRGBA");
+
+}  // namespace engine
+
+#endif
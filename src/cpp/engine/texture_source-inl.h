@@ -10,8 +10,8 @@
 namespace engine {
 
 template<typename T, char NUM_COMPONENTS>
-TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
-                                                std::string format_string) {
+void TextureSource<T, NUM_COMPONENTS>::parseFormatString(
+    std::string format_string) {
   // Preprocess format_string: 'S', 'C' and 'I' have special meaning
   size_t s_pos = format_string.find('S');
   if(s_pos != std::string::npos) {
@@ -42,11 +42,19 @@ TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
 
   assert(NUM_COMPONENTS <= 4);
   assert(format_string.length() == NUM_COMPONENTS);
+}
+
+template<typename T, char NUM_COMPONENTS>
+TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
+                                                std::string format_string) {
+  parseFormatString(format_string);
 
   Magick::Image image(file_name);
   w_ = image.columns();
   h_ = image.rows();
   data_.resize(w_ * h_);
+  memory_ = debug::MemoryTracker::Allocation{"texture source", file_name,
+      debug::MemoryTracker::Category::kCpu, data_.size() * sizeof(data_[0])};
 
   MagickCore::StorageType type = MagickCore::UndefinedPixel;
   if (std::is_same<T, char>::value ||
@@ -72,6 +80,17 @@ TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
   image.write(0, 0, w_, h_, format_string_, type, data_.data());
 }
 
+template<typename T, char NUM_COMPONENTS>
+TextureSource<T, NUM_COMPONENTS>::TextureSource(
+    int w, int h, std::vector<std::array<T, NUM_COMPONENTS>> data,
+    std::string format_string)
+    : data_(std::move(data)), w_(w), h_(h) {
+  parseFormatString(format_string);
+  assert(data_.size() == size_t(w_) * h_);
+  memory_ = debug::MemoryTracker::Allocation{"texture source", "raw data",
+      debug::MemoryTracker::Category::kCpu, data_.size() * sizeof(data_[0])};
+}
+
 template<typename T, char NUM_COMPONENTS>
 gl::PixelDataFormat TextureSource<T, NUM_COMPONENTS>::format() const {
   if (integer_) {
@@ -10,6 +10,7 @@
 #include "./oglwrap_config.h"
 #include "../oglwrap/textures/texture_2D.h"
 #include "../oglwrap/context.h"
+#include "./debug/memory_tracker.h"
 
 namespace engine {
 
@@ -19,6 +20,7 @@ class TextureSource {
   std::string format_string_;
   std::vector<std::array<T, NUM_COMPONENTS>> data_;
   int w_, h_;
+  debug::MemoryTracker::Allocation memory_;
 
  public:
   // Loads in a texture from a file
@@ -29,6 +31,10 @@ class TextureSource {
   TextureSource(const std::string& file_name,
                 std::string format_string = "CSRGBA");
 
+  // Uses the given pixels, row by row (it doesn't need an image file).
+  TextureSource(int w, int h, std::vector<std::array<T, NUM_COMPONENTS>> data,
+                std::string format_string = "CSRGBA");
+
   virtual ~TextureSource() {}
 
   // getters
@@ -78,6 +84,9 @@ class TextureSource {
   virtual void upload(gl::Texture2D& tex) const;
   virtual void upload(gl::Texture2D& tex,
                       gl::PixelDataInternalFormat internal_format) const;
+
+ private:
+  void parseFormatString(std::string format_string);
 };
 
 }  // namespace engine
@@ -0,0 +1,151 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_THREAD_POOL_H_
+#define ENGINE_THREAD_POOL_H_
+
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+#include "./frame_arena.h"
+#include "./debug/profiler.h"
+
+namespace engine {
+
+// A fixed number of worker threads, executing the enqueued jobs
+// in FIFO order. The result of a job can be get through a future.
+class ThreadPool {
+ public:
+  explicit ThreadPool(unsigned num_threads = DefaultNumThreads())
+      : should_quit_(false) {
+    for (unsigned i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      should_quit_ = true;
+    }
+    has_job_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  template<typename Function>
+  auto enqueue(Function&& function) -> std::future<decltype(function())> {
+    using Result = decltype(function());
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      jobs_.emplace([task]() { (*task)(); });
+    }
+    has_job_.notify_one();
+    return result;
+  }
+
+  // Calls function(i) for every i in [0, count) on the workers and on the
+  // calling thread, and returns when every call has finished. The calling
+  // thread takes the calls that the workers haven't started yet, so it
+  // doesn't deadlock if it is a worker itself. Rethrows the first exception
+  // that a call has thrown.
+  void parallelFor(size_t count, const std::function<void(size_t)>& function) {
+    // Nothing to share, and it doesn't touch the heap
+    if (count <= 1) {
+      if (count == 1) { function(0); }
+      return;
+    }
+
+    struct State {
+      std::atomic<size_t> next{0}, finished{0};
+      std::mutex mutex;
+      std::condition_variable all_finished;
+      std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    // The function is only called before parallelFor returns
+    auto work = [state, count, &function]() {
+      size_t i;
+      while ((i = state->next++) < count) {
+        try {
+          function(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock{state->mutex};
+          if (!state->error) { state->error = std::current_exception(); }
+        }
+        if (++state->finished == count) {
+          std::lock_guard<std::mutex> lock{state->mutex};
+          state->all_finished.notify_all();
+        }
+      }
+    };
+
+    size_t num_helpers = count > 1 ? std::min(count - 1, workers_.size()) : 0;
+    for (size_t i = 0; i < num_helpers; ++i) {
+      enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->all_finished.wait(lock, [&]() {
+      return state->finished == count;
+    });
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+
+  size_t size() const { return workers_.size(); }
+
+  // Leaves one core for the main thread
+  static unsigned DefaultNumThreads() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+  }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> jobs_;
+  std::mutex mutex_;
+  std::condition_variable has_job_;
+  bool should_quit_;
+
+  void work() {
+    debug::Profiler::SetThreadName("worker");
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        while (!should_quit_ && jobs_.empty()) {
+          has_job_.wait(lock);
+        }
+        if (jobs_.empty()) { return; }
+        job = std::move(jobs_.front());
+        jobs_.pop();
+      }
+      ENGINE_PROFILE("job");
+      // Nothing resets a worker's arena, so a job frees what it has used
+      FrameArena::Scope frame_arena_scope;
+      job();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+}  // namespace engine
+
+#endif
@@ -3,8 +3,7 @@
 #ifndef ENGINE_TIMER_H_
 #define ENGINE_TIMER_H_
 
-#include "./oglwrap_config.h"
-#include <GLFW/glfw3.h>
+#include "./clock.h"
 
 namespace engine {
 
@@ -19,7 +18,7 @@ class Timer {
 
   double tick() {
     if (!stopped_) {
-      double time = glfwGetTime();
+      double time = Clock::now();
       if (last_time_ != 0) {
         dt = time - last_time_;
         // we don't want to take really big bursts into account.
@@ -33,6 +32,15 @@ class Timer {
     return current;
   }
 
+  // Advances the time by a fixed amount, instead of reading the Clock.
+  double advance(double delta) {
+    if (!stopped_) {
+      dt = delta;
+      current += dt;
+    }
+    return current;
+  }
+
   void stop() {
     stopped_ = true;
     dt = 0;
@@ -40,7 +48,7 @@ class Timer {
 
   void start() {
     stopped_ = false;
-    last_time_ = glfwGetTime();
+    last_time_ = Clock::now();
   }
 
   void toggle() {
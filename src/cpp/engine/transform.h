@@ -12,6 +12,8 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "./slab_allocator.h"
+
 #ifndef M_PI
   #define M_PI 3.14159265359f
 #endif
@@ -41,6 +43,14 @@ class Transformation {
 
   virtual ~Transformation() {}
 
+  // Allocated like the GameObjects (see SlabAllocator).
+  static void* operator new(size_t size) {
+    return SlabAllocator::Instance().allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    SlabAllocator::Instance().deallocate(ptr, size);
+  }
+
   void set_parent(Transformation* parent) { parent_ = parent; }
   Transformation* parent() const { return parent_; }
 
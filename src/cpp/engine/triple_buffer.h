@@ -0,0 +1,63 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_TRIPLE_BUFFER_H_
+#define ENGINE_TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace engine {
+
+// A lock-free, single producer - single consumer triple buffer.
+// The producer fills back(), and publishes it, the consumer picks up the
+// latest published value with acquire(), and reads it through front().
+// Neither side ever waits for the other, the consumer might just skip
+// some values, if the producer is faster.
+template<typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() : back_(0), front_(1), middle_(2) {}
+
+  // Overwrites all three buffers. Only call it when the producer
+  // can't be running (i.e. at initialization).
+  void reset(const T& value) {
+    for (T& buffer : buffers_) {
+      buffer = value;
+    }
+  }
+
+  // The buffer that the producer can write.
+  T& back() { return buffers_[back_]; }
+
+  // Hands over back() to the consumer.
+  void publish() {
+    back_ = middle_.exchange(back_ | kDirtyBit,
+                             std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  // Makes the latest published value available through front().
+  // Returns false if nothing was published since the last call.
+  bool acquire() {
+    if (!(middle_.load(std::memory_order_relaxed) & kDirtyBit)) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  // The buffer that the consumer can read.
+  const T& front() const { return buffers_[front_]; }
+
+ private:
+  static const int kIndexMask = 3, kDirtyBit = 4;
+
+  T buffers_[3];
+  int back_, front_;
+  std::atomic<int> middle_;
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+};
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_UPLOAD_QUEUE_H_
+#define ENGINE_UPLOAD_QUEUE_H_
+
+#include <deque>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <utility>
+#include <functional>
+
+namespace engine {
+
+// The GL work of a scene that is built on a worker thread (see
+// GameEngine::LoadSceneAsync). The scene's constructor can't use the context,
+// so it records the creation of its GL resources (and the components that
+// have them) as steps, and the main thread runs them in the recorded order,
+// between the frames of the running scene. It isn't thread safe: only the
+// constructor records steps, and only the main thread uses it after that.
+class UploadQueue {
+ public:
+  using Step = std::function<void()>;
+
+  void push(const std::string& name, Step step) {
+    steps_.push_back(NamedStep{name, std::move(step)});
+  }
+
+  // Runs the steps until budget_ms is used up (but at least one step, so that
+  // a step longer than the budget can't stall the loading). A step can't be
+  // interrupted, so the budget might be overrun by the last step. Returns
+  // true if every step has been run.
+  bool run(double budget_ms) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point begin = Clock::now();
+    while (!steps_.empty()) {
+      // It is removed first, so a step that throws isn't retried
+      NamedStep step = std::move(steps_.front());
+      steps_.pop_front();
+      step.function();
+      ++steps_done_;
+
+      double elapsed_ms = std::chrono::duration<double, std::milli>(
+          Clock::now() - begin).count();
+      if (elapsed_ms >= budget_ms) { break; }
+    }
+    return steps_.empty();
+  }
+
+  void runAll() { run(std::numeric_limits<double>::infinity()); }
+
+  bool empty() const { return steps_.empty(); }
+  size_t steps_done() const { return steps_done_; }
+  size_t steps_total() const { return steps_done_ + steps_.size(); }
+
+  // The ratio of the steps that have been run, in [0, 1].
+  float progress() const {
+    return steps_.empty() ? 1.0f : float(steps_done_) / steps_total();
+  }
+
+  // The name of the step that runs next (empty if there is none).
+  std::string next_step() const {
+    return steps_.empty() ? std::string{} : steps_.front().name;
+  }
+
+ private:
+  struct NamedStep {
+    std::string name;
+    Step function;
+  };
+
+  std::deque<NamedStep> steps_;
+  size_t steps_done_ = 0;
+};
+
+}  // namespace engine
+
+#endif
@@ -40,8 +40,12 @@ public:
     (prog_ | "aTexCoord").bindLocation(rect_.kTexCoord);
   }
 
-  void render() {
+  // Draws a progress bar too, if progress is in [0, 1]. The bar is animated
+  // by the time (in seconds).
+  void render(float progress = -1.0f, float time = 0.0f) {
     gl::Use(prog_);
+    gl::Uniform<float>(prog_, "uProgress") = progress;
+    gl::Uniform<float>(prog_, "uTime") = time;
     gl::BindToTexUnit(tex_, 0);
 
     gl::TemporarySet capabilies{{{gl::kCullFace, false},
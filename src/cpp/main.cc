@@ -8,20 +8,185 @@
  */
 
 
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <cstdlib>
+
+#include "./ayumi.h"
+#include "./tree.h"
+#include "engine/input.h"
 #include "engine/game_engine.h"
 #include "scenes/main_scene.h"
+#include "scenes/loading_scene.h"
 #include "scenes/gui_test_scene.h"
 #include "scenes/bullet_height_field_scene.h"
+#include "scenes/falling_cubes_simulation.h"
+#include "scenes/stress_profile.h"
 
+using engine::Input;
 using engine::GameEngine;
 
+// Usage: LoD [--scene=bullet|main|gui] [--profile=default|medium|large]
+//            [--cubes=<n>] [--trees=<n>] [--tree_spacing=<n>] [--ayumis=<n>]
+//            [--terrain_size=<n>] [--record=<file> | --replay=<file>]
+//            [--dt=<seconds>]
+//            [--headless=<width>x<height> [--frames=<n> | --duration=<s>]
+//            [--timings=<csv file>] [--summary=<json file>]
+//            [--dump=<path prefix>] [--dump_interval=<n>]
+//            [--warmup_frames=<n>] [--check_allocations]]
+//        LoD --simulate=<instances> [--frames=<n> | --duration=<s>]
+//            [--dt=<seconds>]
+//        LoD --cook
+// A windowed --replay also advances the game by a fixed --dt every frame, but
+// only the headless replays are comparable frame by frame, as the window's
+// size isn't fixed.
+// --cook writes the cooked version of the stale models, which is otherwise
+// done when they are first loaded.
+// The options of the headless runs are rejected without --headless.
+// The stress options override the values of a profile given before them.
 int main(int argc, char* argv[]) {
+  bool headless = false, cook = false;
+  size_t simulations = 0;
+  double duration = 0;
+  std::string scene = "bullet", profile_name = "default";
+  StressProfile profile;
+  std::string record_path, replay_path;
+  int width = 1280, height = 720;
+  GameEngine::HeadlessRun run;
+  // The options that only RunHeadless (or --simulate) uses.
+  std::string headless_arg, headless_or_simulate_arg;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (name == "--duration" || name == "--frames") {
+      headless_or_simulate_arg = arg;
+    } else if (name == "--summary" || name == "--timings" ||
+               name == "--dump" || name == "--dump_interval" ||
+               name == "--warmup_frames" || name == "--check_allocations") {
+      headless_arg = arg;
+    }
+
+    if (name == "--headless") {
+      headless = true;
+      if (!value.empty() &&
+          std::sscanf(value.c_str(), "%dx%d", &width, &height) != 2) {
+        std::cerr << "Invalid resolution: " << value << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (name == "--scene") {
+      scene = value;
+    } else if (name == "--profile") {
+      profile_name = value;
+      if (!profile.setPreset(value)) {
+        std::cerr << "Unknown profile: " << value << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (name == "--cubes") {
+      profile.cubes = std::atoi(value.c_str());
+    } else if (name == "--trees") {
+      profile.trees = std::atoi(value.c_str());
+    } else if (name == "--tree_spacing") {
+      profile.tree_spacing = std::atoi(value.c_str());
+    } else if (name == "--ayumis") {
+      profile.ayumis = std::atoi(value.c_str());
+    } else if (name == "--terrain_size") {
+      profile.terrain_size = std::atoi(value.c_str());
+    } else if (name == "--duration") {
+      duration = std::atof(value.c_str());
+    } else if (name == "--summary") {
+      run.summary_path = value;
+    } else if (name == "--record") {
+      record_path = value;
+    } else if (name == "--replay") {
+      replay_path = value;
+    } else if (name == "--cook") {
+      cook = true;
+    } else if (name == "--simulate") {
+      simulations = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--frames") {
+      run.frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--dt") {
+      run.dt = std::atof(value.c_str());
+    } else if (name == "--timings") {
+      run.timings_path = value;
+    } else if (name == "--dump") {
+      run.dump_prefix = value;
+      if (run.dump_interval == 0) { run.dump_interval = 1; }
+    } else if (name == "--dump_interval") {
+      run.dump_interval = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--warmup_frames") {
+      run.warmup_frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--check_allocations") {
+      run.check_allocations = true;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (scene != "bullet" && scene != "main" && scene != "gui") {
+    std::cerr << "Unknown scene: " << scene << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!headless && !headless_arg.empty()) {
+    std::cerr << headless_arg << " needs --headless" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!headless && !simulations && !headless_or_simulate_arg.empty()) {
+    std::cerr << headless_or_simulate_arg << " needs --headless or --simulate"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (duration > 0) {
+    run.frames = static_cast<size_t>(std::ceil(duration / run.dt));
+  }
+  run.label = scene + '/' + profile_name;
+
   try {
-    GameEngine::InitContext();
-    // GameEngine::LoadScene<MainScene>();
-    // GameEngine::LoadScene<GuiTestScene>();
-    GameEngine::LoadScene<BulletHeightFieldScene>();
-    GameEngine::Run();
+    if (cook) {
+      // Loading a model cooks it, if it's needed
+      auto ayumi_assets = Ayumi::ImportAssets();
+      auto tree_assets = TreeAssets::Import();
+      ayumi_assets->waitAll();
+      tree_assets->waitAll();
+      return EXIT_SUCCESS;
+    }
+    if (simulations) {
+      GameEngine::RunSimulations<FallingCubesSimulation>(simulations,
+                                                         run.frames, run.dt);
+      return EXIT_SUCCESS;
+    }
+    if (!record_path.empty()) {
+      Input::Record(record_path);
+    }
+    if (!replay_path.empty()) {
+      Input::Replay(replay_path);
+    }
+    if (headless) {
+      GameEngine::InitHeadlessContext(width, height);
+    } else {
+      GameEngine::InitContext();
+    }
+    if (scene == "main" && !headless) {
+      // Shows the loading screen, until the main scene is built
+      GameEngine::LoadScene<LoadingScene>();
+      GameEngine::LoadSceneAsync<MainScene>(profile);
+    } else if (scene == "main") {
+      GameEngine::LoadScene<MainScene>(profile);
+    } else if (scene == "gui") {
+      GameEngine::LoadScene<GuiTestScene>();
+    } else {
+      GameEngine::LoadScene<BulletHeightFieldScene>(profile);
+    }
+    if (headless) {
+      GameEngine::RunHeadless(run);
+    } else {
+      // A replay runs with a fixed dt too, instead of the wall clock.
+      GameEngine::Run(replay_path.empty() ? 0 : run.dt);
+    }
   } catch(const std::exception& err) {
     std::cerr << err.what();
     GameEngine::Destroy();
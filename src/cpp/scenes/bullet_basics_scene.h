@@ -189,7 +189,7 @@ class BulletBasicsScene : public engine::Scene {
       if (key == GLFW_KEY_SPACE) {
         addSmallRedCube();
       } else if (key == GLFW_KEY_HOME) {
-        engine::GameEngine::LoadScene<MainScene>();
+        engine::GameEngine::LoadSceneAsync<MainScene>();
       }
     }
   }
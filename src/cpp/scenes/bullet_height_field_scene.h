@@ -3,6 +3,9 @@
 #ifndef LOD_SCENES_BULLET_HEIGHT_FIELD_SCENE_H_
 #define LOD_SCENES_BULLET_HEIGHT_FIELD_SCENE_H_
 
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include <algorithm>
 #include <btBulletDynamicsCommon.h>
@@ -13,148 +16,45 @@
 #undef max
 
 #include "../engine/misc.h"
+#include "../engine/input.h"
 #include "../engine/scene.h"
 #include "../engine/camera.h"
 #include "../engine/behaviour.h"
+#include "../engine/import_graph.h"
 #include "../engine/debug/debug_shape.h"
+#include "../engine/debug/profiler_overlay.h"
+#include "../engine/debug/gl_stats_overlay.h"
+#include "../engine/physics/actor_pool.h"
+#include "../engine/physics/bullet_rigid_body.h"
+#include "../engine/physics/activation_grid.h"
+#include "../engine/physics/cooked_triangle_mesh.h"
+#include "../engine/physics/height_field_tiles.h"
+#include "../engine/physics/scene_queries.h"
 #include "../engine/gui/label.h"
 
+#include "../tree.h"
 #include "../terrain.h"
 #include "../after_effects.h"
 #include "../fps_display.h"
 #include "../loading_screen.h"
 #include "./main_scene.h"
-
-class BulletRigidBody : public engine::Behaviour, public btMotionState {
- public:
-  BulletRigidBody(GameObject* parent, float mass,
-                  std::unique_ptr<btCollisionShape>&& shape,
-                  bool ignore_rotation = false)
-      : Behaviour(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    init(mass, shape_.get());
-  }
-
-  BulletRigidBody(GameObject* parent, float mass,
-                  btCollisionShape* shape, bool ignore_rotation = false)
-      : Behaviour(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    init(mass, shape);
-  }
-
-  BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
-                  const glm::vec3& pos, bool ignore_rotation = false)
-      : Behaviour(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    transform()->set_pos(pos);
-    init(mass, shape);
-  }
-
-  BulletRigidBody(GameObject* parent, float mass,
-                  std::unique_ptr<btCollisionShape>&& shape,
-                  const glm::vec3& pos, bool ignore_rotation = false)
-      : Behaviour(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    transform()->set_pos(pos);
-    init(mass, shape_.get());
-  }
-
-  BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
-                  const glm::vec3& pos, const glm::fquat& rot,
-                  bool ignore_rotation = false)
-      : Behaviour(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    transform()->set_pos(pos);
-    transform()->set_rot(rot);
-    init(mass, shape);
-  }
-
-  BulletRigidBody(GameObject* parent, float mass,
-                  std::unique_ptr<btCollisionShape>&& shape,
-                  const glm::vec3& pos, const glm::fquat& rot,
-                  bool ignore_rotation = false)
-      : Behaviour(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
-    transform()->set_pos(pos);
-    transform()->set_rot(rot);
-    init(mass, shape.get());
-  }
-
-  virtual ~BulletRigidBody() {
-    scene_->world()->removeCollisionObject(bt_rigid_body_.get());
-  }
-
-  btRigidBody* bt_rigid_body() { return bt_rigid_body_.get(); }
-  const btRigidBody* bt_rigid_body() const { return bt_rigid_body_.get(); }
-
- private:
-  std::unique_ptr<btCollisionShape> shape_;
-  std::unique_ptr<btRigidBody> bt_rigid_body_;
-  bool ignore_rotation_, up_to_date_;
-  btTransform new_transform_;
-
-  void init(float mass, btCollisionShape* shape) {
-    btVector3 inertia(0, 0, 0);
-    shape->calculateLocalInertia(mass, inertia);
-    btRigidBody::btRigidBodyConstructionInfo info{mass, this, shape, inertia};
-    bt_rigid_body_ = engine::make_unique<btRigidBody>(info);
-    bt_rigid_body_->setUserPointer(parent_);
-    if (mass == 0.0f) { bt_rigid_body_->setRestitution(1.0f); }
-    scene_->world()->addRigidBody(bt_rigid_body_.get());
-  }
-
-  virtual void getWorldTransform(btTransform &t) const override {
-    if (up_to_date_) {
-      const glm::vec3& pos = transform()->pos();
-      t.setOrigin(btVector3{pos.x, pos.y, pos.z});
-      if (!ignore_rotation_) {
-        const glm::fquat& rot = transform()->rot();
-        t.setRotation(btQuaternion{rot.x, rot.y, rot.z, rot.w});
-      }
-    } else {
-      t = new_transform_;
-    }
-  }
-
-  virtual void setWorldTransform(const btTransform &t) override {
-    new_transform_ = t;
-    up_to_date_ = false;
-  }
-
-  virtual void update() override {
-    if (!up_to_date_) {
-      const btVector3& o = new_transform_.getOrigin();
-      parent_->transform()->set_pos(glm::vec3(o.x(), o.y(), o.z()));
-      if (!ignore_rotation_) {
-        const btQuaternion& r = new_transform_.getRotation();
-        parent_->transform()->set_rot(glm::quat(r.getW(), r.getX(),
-                                                r.getY(), r.getZ()));
-      }
-      up_to_date_ = true;
-    }
-  }
-};
+#include "./stress_profile.h"
 
 class HeightField : public engine::GameObject {
  public:
-  explicit HeightField(GameObject* parent) : GameObject(parent) {
-    terrain_ = addComponent<Terrain>();
-    const auto& height_map = terrain_->height_map();
-    int w = height_map.w(), h = height_map.h();
-    GLubyte *data = new GLubyte[w*h];
-    for (int x = 0; x < w; ++x) {
-      for (int y = 0; y < h; ++y) {
-        data[y*w + x] = height_map.heightAt(x, y);
-      }
-    }
-
-    btCollisionShape* shape = new btHeightfieldTerrainShape{
-        height_map.w(), height_map.h(), data,
-        1, 0, 256, 1, PHY_UCHAR, true};
-
-    glm::vec3 pos{height_map.w()/2.0f, 128, height_map.h()/2.0f};
-    addComponent<BulletRigidBody>(
-        0.0f, std::unique_ptr<btCollisionShape>{shape}, pos);
+  explicit HeightField(GameObject* parent, int terrain_size = 0)
+      : GameObject(parent) {
+    terrain_ = addComponent<Terrain>(terrain_size);
+    // The collision is only created around the camera and the moving bodies
+    tiles_ = addComponent<engine::physics::HeightFieldTiles>(
+        terrain_->height_map());
   }
 
+  // The tiles use the terrain's heightmap, that might die earlier
+  ~HeightField() { tiles_->clear(); }
+
   Terrain* terrain_;
+  engine::physics::HeightFieldTiles* tiles_;
 };
 
 class BulletCube : public engine::Behaviour {
@@ -164,11 +64,10 @@ class BulletCube : public engine::Behaviour {
       : Behaviour(parent) {
     transform()->set_pos(pos);
     transform()->set_rot(rot);
-    btVector3 half_extents(0.5f, 0.5f, 0.5f);
-    btCollisionShape* shape = new btBoxShape(half_extents);
-    auto rbody = addComponent<BulletRigidBody>(
-        1.0f, std::unique_ptr<btCollisionShape>{shape});
-    auto bt_rigid_body = rbody->bt_rigid_body();
+    btCollisionShape* shape =
+        scene_->shape_cache().box(glm::vec3(0.5f, 0.5f, 0.5f));
+    rbody_ = addComponent<engine::physics::BulletRigidBody>(1.0f, shape);
+    auto bt_rigid_body = rbody_->bt_rigid_body();
     bt_rigid_body->setLinearVelocity(btVector3(v.x, v.y, v.z));
     bt_rigid_body->setRestitution(0.3f);
     // Continous Collision Detection (CCD) is needed, when the cubes move more
@@ -177,13 +76,35 @@ class BulletCube : public engine::Behaviour {
     bt_rigid_body->setCcdMotionThreshold(0.5f);
     bt_rigid_body->setCcdSweptSphereRadius(0.2f);
     mesh_ = addComponent<engine::debug::Cube>(glm::vec3(0.5, 0.0, 0.0));
+    scene_->contact_events().subscribe(bt_rigid_body, this);
+  }
+
+  // Called by the ActorPool, instead of creating a new cube
+  void respawn(const glm::vec3& pos, const glm::vec3& v,
+               const glm::quat& rot = glm::quat{}) {
+    rbody_->set_simulated(true);
+    rbody_->teleport(pos, rot, v);
+    mesh_->set_color(glm::vec3(0.5, 0.0, 0.0));
   }
 
-  virtual void collision(const GameObject* other) override {
-    addColor(glm::vec3{0.0f, 0.02f, 0.0f});
+  void despawn() { rbody_->set_simulated(false); }
+
+  void addColor(const glm::vec3& color) {
+    mesh_->set_color(glm::clamp(mesh_->color() + color,
+                                glm::vec3{}, glm::vec3{1}));
+  }
+
+  virtual void contacts(
+      const std::vector<engine::physics::ContactEvent>& events) override {
+    for (const auto& event : events) {
+      if (event.type == engine::physics::ContactEvent::Type::kBegin) {
+        addColor(glm::vec3{0.0f, 0.3f, 0.0f});
+      }
+    }
   }
 
  private:
+  engine::physics::BulletRigidBody* rbody_;
   engine::debug::Cube* mesh_;
 
   virtual void update() override {
@@ -192,11 +113,6 @@ class BulletCube : public engine::Behaviour {
                                std::min(0.98f*color.b, 0.9f));
     mesh_->set_color(color);
   }
-
-  void addColor(const glm::vec3& color) {
-    mesh_->set_color(glm::clamp(mesh_->color() + color,
-                                glm::vec3{}, glm::vec3{1}));
-  }
 };
 
 class BulletSphere : public engine::Behaviour {
@@ -205,22 +121,42 @@ class BulletSphere : public engine::Behaviour {
                         const glm::vec3& v)
       : Behaviour(parent) {
     transform()->set_pos(pos);
-    btCollisionShape* shape = new btSphereShape(0.5f);
-    auto rbody = addComponent<BulletRigidBody>(
-        1.0f, std::unique_ptr<btCollisionShape>{shape});
-    auto bt_rigid_body = rbody->bt_rigid_body();
+    btCollisionShape* shape = scene_->shape_cache().sphere(0.5f);
+    rbody_ = addComponent<engine::physics::BulletRigidBody>(1.0f, shape);
+    auto bt_rigid_body = rbody_->bt_rigid_body();
     bt_rigid_body->setLinearVelocity(btVector3(v.x, v.y, v.z));
     bt_rigid_body->setRestitution(0.5f);
     bt_rigid_body->setCcdMotionThreshold(0.5f);
     bt_rigid_body->setCcdSweptSphereRadius(0.2f);
     mesh_ = addComponent<engine::debug::Sphere>(glm::vec3(0.5, 0.0, 0.0));
+    scene_->contact_events().subscribe(bt_rigid_body, this);
+  }
+
+  // Called by the ActorPool, instead of creating a new sphere
+  void respawn(const glm::vec3& pos, const glm::vec3& v) {
+    rbody_->set_simulated(true);
+    rbody_->teleport(pos, glm::quat{}, v);
+    mesh_->set_color(glm::vec3(0.5, 0.0, 0.0));
+  }
+
+  void despawn() { rbody_->set_simulated(false); }
+
+  void addColor(const glm::vec3& color) {
+    mesh_->set_color(glm::clamp(mesh_->color() + color,
+                                glm::vec3{}, glm::vec3{1}));
   }
 
-  virtual void collision(const GameObject* other) override {
-    addColor(glm::vec3{0.0f, 0.02f, 0.0f});
+  virtual void contacts(
+      const std::vector<engine::physics::ContactEvent>& events) override {
+    for (const auto& event : events) {
+      if (event.type == engine::physics::ContactEvent::Type::kBegin) {
+        addColor(glm::vec3{0.0f, 0.3f, 0.0f});
+      }
+    }
   }
 
  private:
+  engine::physics::BulletRigidBody* rbody_;
   engine::debug::Sphere* mesh_;
 
   virtual void update() override {
@@ -229,11 +165,6 @@ class BulletSphere : public engine::Behaviour {
                                std::min(0.98f*color.b, 0.9f));
     mesh_->set_color(color);
   }
-
-  void addColor(const glm::vec3& color) {
-    mesh_->set_color(glm::clamp(mesh_->color() + color,
-                                glm::vec3{}, glm::vec3{1}));
-  }
 };
 
 class BulletFreeFlyCamera : public engine::FreeFlyCamera {
@@ -247,7 +178,7 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
                       speed_per_sec, mouse_sensitivity) {
     float radius = 2.0f * z_near;
     btCollisionShape* shape = new btSphereShape(radius);
-    auto rbody = addComponent<BulletRigidBody>(
+    auto rbody = addComponent<engine::physics::BulletRigidBody>(
       0.001f, std::unique_ptr<btCollisionShape>{shape}, true);
     bt_rigid_body_ = rbody->bt_rigid_body();
     bt_rigid_body_->setGravity(btVector3{0, 0, 0});
@@ -264,9 +195,7 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
   btRigidBody* bt_rigid_body_;
 
   virtual void update() override {
-    glm::dvec2 cursor_pos;
-    GLFWwindow* window = scene_->window();
-    glfwGetCursorPos(window, &cursor_pos.x, &cursor_pos.y);
+    glm::dvec2 cursor_pos = engine::Input::cursor_pos();
     static glm::dvec2 prev_cursor_pos;
     glm::dvec2 diff = cursor_pos - prev_cursor_pos;
     prev_cursor_pos = cursor_pos;
@@ -301,16 +230,16 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
 
     // Calculate the offset
     glm::vec3 offset;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    if (engine::Input::key_pressed(GLFW_KEY_W)) {
       offset += transform()->forward();
     }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    if (engine::Input::key_pressed(GLFW_KEY_S)) {
       offset -= transform()->forward();
     }
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    if (engine::Input::key_pressed(GLFW_KEY_D)) {
       offset += transform()->right();
     }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    if (engine::Input::key_pressed(GLFW_KEY_A)) {
       offset -= transform()->right();
     }
     offset *= speed_per_sec_;
@@ -325,18 +254,13 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
 class BulletForest : public engine::GameObject {
  public:
   struct TreeInfo {
-    engine::MeshRenderer mesh_, collision_mesh_;
-    std::vector<int> indices_;
-    std::unique_ptr<btTriangleIndexVertexArray> triangles_;
-    std::unique_ptr<btCollisionShape> shape_;
+    engine::MeshRenderer* mesh_;  // kept alive by the TreeAssets
+    std::unique_ptr<engine::physics::CookedTriangleMesh> collider_;
     glm::vec4 bsphere_;
 
-    explicit TreeInfo(const std::string& file_base_name)
-      : mesh_(file_base_name + ".obj",
-              aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs |
-              aiProcess_PreTransformVertices)
-      , collision_mesh_(file_base_name + "_collider.obj",
-                        aiProcess_PreTransformVertices) {}
+    TreeInfo(engine::MeshRenderer* mesh,
+             std::unique_ptr<engine::physics::CookedTriangleMesh> collider)
+      : mesh_(mesh), collider_(std::move(collider)) {}
   };
 
  private:
@@ -347,39 +271,35 @@ class BulletForest : public engine::GameObject {
                TreeInfo* tree_info,
                const engine::BoundingBox& bbox,
                const engine::ShaderProgram& prog,
-               const engine::ShaderProgram& shadow_prog)
+               const engine::ShaderProgram& shadow_prog,
+               engine::physics::ActivationGrid* activation_grid)
         : Behaviour(parent, transform)
         , model_matrix_(transform.matrix())
         , tree_info_(tree_info)
         , bbox_(bbox)
         , uModelCameraMatrix_(prog, "uModelCameraMatrix")
         , shadow_uMCP_(shadow_prog, "uMCP")
-        , uNormalMatrix_(prog, "uNormalMatrix") {
-      rbody_ = addComponent<BulletRigidBody>(0, tree_info->shape_.get());
+        , uNormalMatrix_(prog, "uNormalMatrix")
+        , activation_grid_(activation_grid) {
+      rbody_ = addComponent<engine::physics::BulletRigidBody>(
+          0, tree_info->collider_->shape());
+      // The trees are only added to the world near the camera or moving bodies
+      activation_grid_->addStatic(rbody_->bt_rigid_body());
+    }
+
+    // The rigid body component is still alive here
+    ~BulletTree() {
+      activation_grid_->removeStatic(rbody_->bt_rigid_body());
     }
 
    private:
     const glm::mat4 model_matrix_;
     TreeInfo *tree_info_;
-    BulletRigidBody *rbody_;
+    engine::physics::BulletRigidBody *rbody_;
     const engine::BoundingBox bbox_;
     gl::LazyUniform<glm::mat4> uModelCameraMatrix_, shadow_uMCP_;
     gl::LazyUniform<glm::mat3> uNormalMatrix_;
-
-    virtual void update() override {
-      auto cam = scene_->camera();
-      const auto& campos = cam->transform()->pos();
-
-      if (glm::length(transform()->pos() - campos) < 1000) {
-        if (!enabled()) {
-          set_enabled(true);
-          scene_->world()->addRigidBody(rbody_->bt_rigid_body());
-        }
-      } else if (enabled()) {
-        set_enabled(false);
-        scene_->world()->removeCollisionObject(rbody_->bt_rigid_body());
-      }
-    }
+    engine::physics::ActivationGrid *activation_grid_;
 
     virtual void shadowRender() override {
       auto shadow = scene_->shadow();
@@ -390,7 +310,7 @@ class BulletForest : public engine::GameObject {
         shadow_uMCP_ = shadow->modelCamProjMat(
             tree_info_->bsphere_, model_matrix_, glm::mat4{});
         gl::TemporaryDisable cullface{gl::kCullFace};
-        tree_info_->mesh_.render();
+        tree_info_->mesh_->render();
         shadow->push();
       }
     }
@@ -408,53 +328,71 @@ class BulletForest : public engine::GameObject {
 
       uModelCameraMatrix_.set(cam_mx * model_matrix_);
       uNormalMatrix_.set(glm::inverse(glm::mat3(model_matrix_)));
-      tree_info_->mesh_.render();
+      tree_info_->mesh_->render();
     }
   };
 
-  engine::ShaderProgram prog_, shadow_prog_;
+  // The colliders of the tree types, cooked on the thread pool.
+  struct Colliders {
+    std::unique_ptr<engine::physics::CookedTriangleMesh> meshes[3];
+    engine::ImportGraph jobs;  // has to die before the meshes
+  };
+
+  TreeAssets assets_;  // the same meshes and programs as Tree's
   gl::LazyUniform<glm::mat4> uProjectionMatrix_;
   std::array<std::unique_ptr<TreeInfo>, 3> tree_infos_;
 
+  static std::unique_ptr<Colliders> CookColliders() {
+    const char* kTreeNames[] = {"massive_swamptree_01_a",
+                                "massive_swamptree_01_b",
+                                "cedar_01_a_source"};
+    auto colliders = engine::make_unique<Colliders>();
+    for (size_t i = 0; i != 3; ++i) {
+      std::string base_name =
+          std::string{"src/resources/models/trees/"} + kTreeNames[i];
+      std::unique_ptr<engine::physics::CookedTriangleMesh>* collider =
+          &colliders->meshes[i];
+      colliders->jobs.addJob([collider, base_name]() {
+        *collider = engine::make_unique<engine::physics::CookedTriangleMesh>(
+            base_name + "_collider.obj", base_name + "_collider.bvh");
+      });
+    }
+    return colliders;
+  }
+
  public:
-  BulletForest(GameObject *parent, const engine::HeightMapInterface& hmap)
+  // Places the trees like Tree does.
+  BulletForest(GameObject *parent, const engine::HeightMapInterface& hmap,
+               engine::physics::ActivationGrid* activation_grid,
+               int max_trees = -1, int spacing = 150)
+      : BulletForest(parent, hmap, activation_grid, max_trees, spacing,
+                     CookColliders()) {}
+
+ private:
+  // The colliders are cooked in parallel, while the meshes are loaded (or
+  // taken from the AssetCache).
+  BulletForest(GameObject *parent, const engine::HeightMapInterface& hmap,
+               engine::physics::ActivationGrid* activation_grid,
+               int max_trees, int spacing,
+               std::unique_ptr<Colliders> colliders)
       : GameObject(parent)
-      , prog_(scene_->shader_manager()->get("tree.vert"),
-              scene_->shader_manager()->get("tree.frag"))
-      , shadow_prog_(scene_->shader_manager()->get("tree_shadow.vert"),
-                   scene_->shader_manager()->get("tree_shadow.frag"))
-      , uProjectionMatrix_(prog_, "uProjectionMatrix") {
-    gl::Use(prog_);
-    gl::UniformSampler(prog_, "uDiffuseTexture").set(0);
-
-    tree_infos_[0] = engine::make_unique<TreeInfo>(
-        "src/resources/models/trees/massive_swamptree_01_a");
-    tree_infos_[1] = engine::make_unique<TreeInfo>(
-        "src/resources/models/trees/massive_swamptree_01_b");
-    tree_infos_[2] = engine::make_unique<TreeInfo>(
-        "src/resources/models/trees/cedar_01_a_source");
+      , assets_(scene_->shader_manager())
+      , uProjectionMatrix_(*assets_.prog, "uProjectionMatrix") {
+    colliders->jobs.waitAll();
     for (size_t i = 0; i != tree_infos_.size(); ++i) {
-      tree_infos_[i]->mesh_.setupPositions(prog_ | "aPosition");
-      tree_infos_[i]->mesh_.setupTexCoords(prog_ | "aTexCoord");
-      tree_infos_[i]->mesh_.setupNormals(prog_ | "aNormal");
-      tree_infos_[i]->mesh_.setupDiffuseTextures(0);
-
-      tree_infos_[i]->triangles_ = engine::make_unique<btTriangleIndexVertexArray>();
-      tree_infos_[i]->indices_ =
-        tree_infos_[i]->collision_mesh_.btTriangles(tree_infos_[i]->triangles_.get());
-
-      tree_infos_[i]->shape_ = engine::make_unique<btBvhTriangleMeshShape>(
-          tree_infos_[i]->triangles_.get(), true);
-
-      tree_infos_[i]->bsphere_ = tree_infos_[i]->mesh_.bSphere();
+      tree_infos_[i] = engine::make_unique<TreeInfo>(
+          assets_.meshes[i].get(), std::move(colliders->meshes[i]));
+      tree_infos_[i]->bsphere_ = tree_infos_[i]->mesh_->bSphere();
       // removes peter panning (but decreases shadow quality)
       tree_infos_[i]->bsphere_.w *= 1.2;
     }
 
-    const int kTreeDist = 150;
+    const int kTreeDist = std::max(spacing, 4);
     glm::vec2 extent = hmap.extent();
+    int tree_count = 0;
     for (int i = kTreeDist; i + kTreeDist < extent.x; i += kTreeDist) {
       for (int j = kTreeDist; j + kTreeDist < extent.y; j += kTreeDist) {
+        if (max_trees >= 0 && tree_count++ >= max_trees) { return; }
         glm::ivec2 coord = glm::ivec2(i + rand()%(kTreeDist/2) - kTreeDist/4,
                                       j + rand()%(kTreeDist/2) - kTreeDist/4);
         glm::vec3 pos =
@@ -468,20 +406,24 @@ class BulletForest : public engine::GameObject {
         engine::Transform t;
         t.set_pos(pos);
         t.set_rot(rot);
-        engine::BoundingBox bbox = tree_infos_[type]->mesh_.boundingBox(t.matrix());
+        engine::BoundingBox bbox = tree_infos_[type]->mesh_->boundingBox(
+            t.matrix());
 
-        addComponent<BulletTree>(t, tree_infos_[type].get(), bbox, prog_, shadow_prog_);
+        addComponent<BulletTree>(t, tree_infos_[type].get(), bbox,
+                                 *assets_.prog, *assets_.shadow_prog,
+                                 activation_grid);
       }
     }
   }
 
+ public:
   virtual void shadowRender() override {
-    gl::Use(shadow_prog_);
+    gl::Use(*assets_.shadow_prog);
   }
 
   virtual void render() override {
-    gl::Use(prog_);
-    prog_.update();
+    gl::Use(*assets_.prog);
+    assets_.prog->update();
     uProjectionMatrix_ = scene_->camera()->projectionMatrix();
 
     gl::BlendFunc(gl::kSrcAlpha, gl::kOneMinusSrcAlpha);
@@ -491,10 +433,45 @@ class BulletForest : public engine::GameObject {
 };
 
 class BulletHeightFieldScene : public engine::Scene {
+  engine::physics::ActorPool<BulletSphere>* spheres_;
+  engine::physics::ActorPool<BulletCube>* cubes_;
+  std::shared_ptr<engine::physics::QueryBatch> aim_query_ =
+      std::make_shared<engine::physics::QueryBatch>();
+
+  // Highlights the cube or sphere in the center of the screen. The ray is
+  // cast asynchronously, its result is used a frame later.
+  virtual void update() override {
+    if (aim_query_->size() != 0) {
+      if (!aim_query_->ready()) { return; }
+      engine::GameObject* object =
+          findObject(aim_query_->result(0).object_uid);
+      if (auto cube = dynamic_cast<BulletCube*>(object)) {
+        cube->addColor(glm::vec3{0.0f, 0.0f, 0.2f});
+      } else if (auto sphere = dynamic_cast<BulletSphere*>(object)) {
+        sphere->addColor(glm::vec3{0.0f, 0.0f, 0.2f});
+      }
+    }
+
+    auto cam = camera()->transform();
+    aim_query_->clear();
+    aim_query_->addRay(cam->pos() + 3.0f*cam->forward(),
+                       cam->pos() + 500.0f*cam->forward());
+    queries().submit(aim_query_);
+  }
+
   void shootSphere(float speed = 20.0f) {
     auto cam = camera();
     glm::vec3 pos = cam->transform()->pos() + 3.0f*cam->transform()->forward();
-    addComponent<BulletSphere>(pos, speed*cam->transform()->forward());
+    spheres_->spawn(pos, speed*cam->transform()->forward());
+  }
+
+  // Drops 'count' cubes in layers of 32 x 32 above the given point.
+  void dropCubes(const glm::vec3& center, int count) {
+    for (int i = 0; i < count; ++i) {
+      int x = i % 32, z = i / 32 % 32, y = i / 1024;
+      cubes_->spawn(center + glm::vec3(1.5f*(x - 16), 2.0f*y, 1.5f*(z - 16)),
+                    glm::vec3());
+    }
   }
 
   void dropCubes() {
@@ -502,13 +479,13 @@ class BulletHeightFieldScene : public engine::Scene {
     glm::vec3 base_pos = cam->transform()->pos() - 3.0f*cam->transform()->up();
     for (int x = -2; x <= 2; ++x) {
       for (int y = -2; y <= 2; ++y) {
-        addComponent<BulletCube>(base_pos + 1.02f*glm::vec3(x, 0, y), glm::vec3());
+        cubes_->spawn(base_pos + 1.02f*glm::vec3(x, 0, y), glm::vec3());
       }
     }
   }
 
  public:
-  BulletHeightFieldScene() {
+  explicit BulletHeightFieldScene(const StressProfile& profile = {}) {
 #if !ENGINE_NO_FULLSCREEN
     glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 #endif
@@ -536,15 +513,27 @@ class BulletHeightFieldScene : public engine::Scene {
     Shadow *shadow = addComponent<Shadow>(skybox, 2048, 2, 2);
     set_shadow(shadow);
 
-    auto hf = addComponent<HeightField>();
-    addComponent<BulletForest>(hf->terrain_->height_map());
+    auto hf = addComponent<HeightField>(profile.terrain_size);
+    const engine::HeightMapInterface& height_map = hf->terrain_->height_map();
+    auto activation_grid =
+        addComponent<engine::physics::ActivationGrid>(256.0f, 1000.0f);
+    addComponent<BulletForest>(height_map, activation_grid,
+                               profile.trees, profile.tree_spacing);
+
+    spheres_ = addComponent<engine::physics::ActorPool<BulletSphere>>(256);
+    cubes_ = addComponent<engine::physics::ActorPool<BulletCube>>(
+        std::max(1000, profile.cubes));
+    glm::vec2 center = height_map.center();
+    dropCubes(glm::vec3(center.x, height_map.heightAt(center.x, center.y) + 20,
+                        center.y), profile.cubes);
 
     auto after_effects = addComponent<AfterEffects>(skybox);
     shadow->set_default_fbo(after_effects->fbo());
     after_effects->set_group(1);
 
     auto cam = addComponent<BulletFreeFlyCamera>(M_PI/3, 1, 3000,
-        glm::vec3(1030, 200, 1030), glm::vec3(1024, 200, 1024), 20, 2);
+        glm::vec3(center.x + 6, 200, center.y + 6),
+        glm::vec3(center.x, 200, center.y), 20, 2);
     set_camera(cam);
 
     auto label = addComponent<engine::gui::Label>(
@@ -568,39 +557,11 @@ class BulletHeightFieldScene : public engine::Scene {
 
     auto fps = addComponent<FpsDisplay>();
     fps->set_group(2);
-  }
-
-  void findCollisions() {
-    int num_manifolds = world_->getDispatcher()->getNumManifolds();
-    for (int i = 0; i < num_manifolds; ++i) {
-      btPersistentManifold* contact_manifold =
-         world_->getDispatcher()->getManifoldByIndexInternal(i);
-      const btCollisionObject* obA = contact_manifold->getBody0();
-      const btCollisionObject* obB = contact_manifold->getBody1();
-
-      int num_contacts = contact_manifold->getNumContacts();
-      for (int j = 0; j < num_contacts; ++j) {
-        btManifoldPoint& pt = contact_manifold->getContactPoint(j);
-        if (pt.getDistance() < 1e-3f) {
-          // const btVector3& ptA = pt.getPositionWorldOnA();
-          // const btVector3& ptB = pt.getPositionWorldOnB();
-          // const btVector3& normalOnB = pt.m_normalWorldOnB;
-          auto go1 = (engine::GameObject*)obA->getUserPointer();
-          auto go2 = (engine::GameObject*)obB->getUserPointer();
-          if (go1) { go1->collisionAll(go2); }
-          if (go2) { go2->collisionAll(go1); }
-        }
-      }
-    }
-  }
-
-  virtual void update() override {
-    Scene::update();
-    findCollisions();
-  }
 
-  virtual void updatePhysics() override {
-    world_->stepSimulation(game_time().dt, 4);
+    auto profiler_overlay = addComponent<engine::debug::ProfilerOverlay>();
+    profiler_overlay->set_group(2);
+    auto gl_stats_overlay = addComponent<engine::debug::GlStatsOverlay>();
+    gl_stats_overlay->set_group(2);
   }
 
   virtual void keyAction(int key, int scancode, int action, int mods) override {
@@ -608,12 +569,10 @@ class BulletHeightFieldScene : public engine::Scene {
       if (key == GLFW_KEY_SPACE) {
         dropCubes();
       } else if (key == GLFW_KEY_HOME) {
-        engine::GameEngine::LoadScene<MainScene>();
+        engine::GameEngine::LoadSceneAsync<MainScene>();
       } else if (key == GLFW_KEY_DELETE) {
-        auto v0 = findComponents<BulletSphere>();
-        removeComponents(v0.begin(), v0.end());
-        auto v1 = findComponents<BulletCube>();
-        removeComponents(v1.begin(), v1.end());
+        spheres_->releaseAll();
+        cubes_->releaseAll();
       }
     }
   }
@@ -0,0 +1,68 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef LOD_SCENES_FALLING_CUBES_SIMULATION_H_
+#define LOD_SCENES_FALLING_CUBES_SIMULATION_H_
+
+#include <btBulletDynamicsCommon.h>
+
+#include "../engine/misc.h"
+#include "../engine/scene.h"
+#include "../engine/behaviour.h"
+#include "../engine/physics/bullet_rigid_body.h"
+
+// A cube, that is dropped again from above, when it comes to rest.
+class FallingCube : public engine::Behaviour {
+ public:
+  FallingCube(GameObject* parent, const glm::vec3& pos)
+      : Behaviour(parent), spawn_pos_(pos) {
+    transform()->set_pos(pos);
+    btCollisionShape* shape =
+        scene_->shape_cache().box(glm::vec3(0.5f, 0.5f, 0.5f));
+    rbody_ = addComponent<engine::physics::BulletRigidBody>(1.0f, shape);
+    rbody_->bt_rigid_body()->setRestitution(0.3f);
+  }
+
+ private:
+  glm::vec3 spawn_pos_;
+  engine::physics::BulletRigidBody* rbody_;
+
+  virtual void update() override {
+    if (!rbody_->bt_rigid_body()->isActive()) {
+      rbody_->teleport(spawn_pos_);
+    }
+  }
+};
+
+// A GL free scene for the simulation-only mode: a grid of cubes keeps
+// falling onto a plane (see GameEngine::RunSimulations).
+class FallingCubesSimulation : public engine::Scene {
+ public:
+  explicit FallingCubesSimulation(int grid_size = 16)
+      : Scene(SimulationOnly{}) {
+    collision_config_ = engine::make_unique<btDefaultCollisionConfiguration>();
+    dispatcher_ =
+        engine::make_unique<btCollisionDispatcher>(collision_config_.get());
+    broadphase_ = engine::make_unique<btDbvtBroadphase>();
+    solver_ = engine::make_unique<btSequentialImpulseConstraintSolver>();
+    world_ = engine::make_unique<btDiscreteDynamicsWorld>(
+        dispatcher_.get(), broadphase_.get(),
+        solver_.get(), collision_config_.get());
+    world_->setGravity(btVector3(0, -gravity(), 0));
+
+    auto ground = addComponent<engine::GameObject>();
+    ground->addComponent<engine::physics::BulletRigidBody>(0.0f,
+        engine::make_unique<btStaticPlaneShape>(btVector3(0, 1, 0), 0));
+
+    for (int x = 0; x < grid_size; ++x) {
+      for (int z = 0; z < grid_size; ++z) {
+        // Stacked in two layers, so that they collide with each other too
+        for (int y = 0; y < 2; ++y) {
+          addComponent<FallingCube>(glm::vec3(1.5f*x, 5.0f + 2.0f*y + 0.1f*x,
+                                              1.5f*z));
+        }
+      }
+    }
+  }
+};
+
+#endif
@@ -59,7 +59,7 @@ struct GuiTestScene : public engine::Scene {
                                               L"dis one?",
                                               glm::vec4{1, 0.05f, 0.05f, 1},
                                               glm::vec4{1, 1, 1, 1}, 20);
-      blue_pill->addPressCallback([](){engine::GameEngine::LoadScene<MainScene>();});
+      blue_pill->addPressCallback([](){engine::GameEngine::LoadSceneAsync<MainScene>();});
 
     Button *orange_pill = box->addComponent<Button>(glm::vec2{0.2f, -0.2f},
                                                 glm::vec2{0.08f, 0.04f},
@@ -0,0 +1,24 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef LOD_SCENES_LOADING_SCENE_H_
+#define LOD_SCENES_LOADING_SCENE_H_
+
+#include "../engine/scene.h"
+#include "../engine/game_engine.h"
+#include "../loading_screen.h"
+
+// Shows the loading screen, with the progress of the scene that is being
+// loaded in the background (see GameEngine::LoadSceneAsync), when there is no
+// other scene to run meanwhile.
+class LoadingScene : public engine::Scene {
+ private:
+  LoadingScreen loading_screen_;
+
+  // It has no camera, so it only has a 2D pass.
+  virtual void render2D() override {
+    loading_screen_.render(engine::GameEngine::loading_progress(),
+                           game_time().current);
+  }
+};
+
+#endif
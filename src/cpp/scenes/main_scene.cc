@@ -4,6 +4,8 @@
 
 #include <iostream>
 #include <string>
+#include <memory>
+#include <utility>
 
 #include "../engine/rigid_body.h"
 #include "../engine/game_engine.h"
@@ -17,13 +19,15 @@
 #include "../tree.h"
 #include "../shadow.h"
 #include "../fps_display.h"
-
-#include "../loading_screen.h"
+#include "../engine/debug/profiler_overlay.h"
+#include "../engine/debug/gl_stats_overlay.h"
 
 static double last_debug_time = 0;
 
+// The steps might run in different frames, so each of them is timed alone.
 static void PrintDebugText(const std::string& str) {
   std::cout << str << ": ";
+  last_debug_time = glfwGetTime();
 }
 
 static void PrintDebugTime() {
@@ -32,79 +36,162 @@ static void PrintDebugTime() {
   last_debug_time = curr_time;
 }
 
-MainScene::MainScene() {
-  GLFWwindow* window = this->window();
-
-  // Disable cursor
-#if !ENGINE_NO_FULLSCREEN
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-#endif
-
-  // The scene builds quite slow, put some picture for the user.
-  last_debug_time = glfwGetTime();
-  PrintDebugText("Drawing the loading screen");
-    LoadingScreen().render();
-    glfwSwapBuffers(window);
+namespace {
+
+// The components that the later loading steps need.
+struct LoadedParts {
+  Skybox* skybox = nullptr;
+  Shadow* shadow = nullptr;
+  Terrain* terrain = nullptr;
+  Ayumi* ayumi = nullptr;
+  CharacterMovement* charmove = nullptr;
+  engine::ThirdPersonalCamera* cam = nullptr;
+};
+
+}  // namespace
+
+MainScene::MainScene(const StressProfile& profile) {
+  // This might run on a worker thread (see GameEngine::LoadSceneAsync), so
+  // the height map and the models are loaded here, and only the work that
+  // needs the context is recorded into the upload queue.
+  std::shared_ptr<engine::ImportGraph> ayumi_assets = Ayumi::ImportAssets();
+  std::shared_ptr<engine::ImportGraph> tree_assets = TreeAssets::Import();
+  // The height map, then the imports
+  size_t steps_total = 1 + ayumi_assets->size() + tree_assets->size();
+  size_t steps_done = 0;
+
+  PrintDebugText("Loading the height map");
+    auto height_map = Terrain::LoadHeightMap(profile.terrain_size);
   PrintDebugTime();
-
-  PrintDebugText("Initializing the skybox");
-    Skybox *skybox = addComponent<Skybox>();
-    skybox->set_group(-1);
+  engine::GameEngine::ReportLoadingProgress(float(++steps_done) / steps_total);
+
+  PrintDebugText("Importing the models");
+    for (engine::ImportGraph* assets : {ayumi_assets.get(),
+                                        tree_assets.get()}) {
+      for (engine::ImportGraph::Id id = 0; id < assets->size(); ++id) {
+        assets->wait(id);
+        engine::GameEngine::ReportLoadingProgress(
+            float(++steps_done) / steps_total);
+      }
+    }
   PrintDebugTime();
 
-  PrintDebugText("Initializing the shadow maps");
-    Shadow *shadow = addComponent<Shadow>(skybox, 2048, 4, 4);
-    set_shadow(shadow);
-  PrintDebugTime();
+  auto parts = std::make_shared<LoadedParts>();
+  engine::UploadQueue& queue = upload_queue();
 
-  Terrain *terrain = engine::GameEngine::scene()->findComponent<Terrain>();
-  if (!stealComponent(terrain)) {
-    PrintDebugText("Initializing the terrain");
-     terrain = addComponent<Terrain>();
+  queue.push("skybox", [this, parts]() {
+    PrintDebugText("Initializing the skybox");
+      parts->skybox = addComponent<Skybox>();
+      parts->skybox->set_group(-1);
     PrintDebugTime();
-  }
-  const engine::HeightMapInterface& height_map = terrain->height_map();
-
-  PrintDebugText("Initializing Ayumi");
-    Ayumi *ayumi = addComponent<Ayumi>();
-    ayumi->addComponent<engine::RigidBody>(ayumi->transform(), height_map, 0);
-
-    CharacterMovement *charmove = ayumi->addComponent<CharacterMovement>();
-    ayumi->charmove(charmove);
-    charmove->setAnimation(&ayumi->getAnimation());
-  PrintDebugTime();
-
-  PrintDebugText("Initializing the camera");
-    GameObject* cam_offset_go = ayumi->addComponent<GameObject>();
-    engine::Transform *cam_offset = cam_offset_go->transform();
-
-    glm::vec2 center = height_map.center();
-    ayumi->transform()->set_local_pos(
-        glm::vec3{center.x, height_map.heightAt(center.x, center.y), center.y});
-    cam_offset->set_local_pos(ayumi->getMesh().bSphereCenter());
+  });
 
-    engine::ThirdPersonalCamera *cam =
-      cam_offset_go->addComponent<engine::ThirdPersonalCamera>(
-        M_PI/3.0f, 1.0f, 3000.0f,
-        cam_offset->pos() + glm::vec3(ayumi->getMesh().bSphereRadius() * 2),
-        height_map, 1.5f);
+  queue.push("shadow maps", [this, parts]() {
+    PrintDebugText("Initializing the shadow maps");
+      parts->shadow = addComponent<Shadow>(parts->skybox, 2048, 4, 4);
+      set_shadow(parts->shadow);
+    PrintDebugTime();
+  });
 
-    set_camera(cam);
-    charmove->setCamera(cam);
-  PrintDebugTime();
+  queue.push("terrain", [this, parts, height_map]() {
+    PrintDebugText("Initializing the terrain");
+      parts->terrain = addComponent<Terrain>(height_map);
+    PrintDebugTime();
+  });
+
+  queue.push("Ayumi", [this, parts, ayumi_assets]() {
+    PrintDebugText("Initializing Ayumi");
+      const engine::HeightMapInterface& height_map =
+          parts->terrain->height_map();
+      Ayumi *ayumi = addComponent<Ayumi>(ayumi_assets.get());
+      ayumi->addComponent<engine::RigidBody>(ayumi->transform(), height_map, 0);
+
+      CharacterMovement *charmove = ayumi->addComponent<CharacterMovement>();
+      ayumi->charmove(charmove);
+      charmove->setAnimation(&ayumi->getAnimation());
+      parts->ayumi = ayumi;
+      parts->charmove = charmove;
+    PrintDebugTime();
+  });
+
+  queue.push("camera", [this, parts]() {
+    PrintDebugText("Initializing the camera");
+      const engine::HeightMapInterface& height_map =
+          parts->terrain->height_map();
+      Ayumi *ayumi = parts->ayumi;
+      GameObject* cam_offset_go = ayumi->addComponent<GameObject>();
+      engine::Transform *cam_offset = cam_offset_go->transform();
+
+      glm::vec2 center = height_map.center();
+      ayumi->transform()->set_local_pos(
+          glm::vec3{center.x, height_map.heightAt(center.x, center.y),
+                    center.y});
+      cam_offset->set_local_pos(ayumi->getMesh().bSphereCenter());
+
+      engine::ThirdPersonalCamera *cam =
+        cam_offset_go->addComponent<engine::ThirdPersonalCamera>(
+          M_PI/3.0f, 1.0f, 3000.0f,
+          cam_offset->pos() + glm::vec3(ayumi->getMesh().bSphereRadius() * 2),
+          height_map, 1.5f);
+
+      set_camera(cam);
+      parts->charmove->setCamera(cam);
+      parts->cam = cam;
+    PrintDebugTime();
+  });
+
+  // They stand in rows behind the player, and they copy her moves. Every one
+  // of them is a separate step, so that they can be spread over more frames.
+  for (int i = 1; i < profile.ayumis; ++i) {
+    queue.push("other Ayumis", [this, parts, ayumi_assets, i]() {
+      const engine::HeightMapInterface& height_map =
+          parts->terrain->height_map();
+      Ayumi *other = addComponent<Ayumi>(ayumi_assets.get());
+      other->addComponent<engine::RigidBody>(
+          other->transform(), height_map, 0);
+      CharacterMovement *other_charmove =
+          other->addComponent<CharacterMovement>();
+      other->charmove(other_charmove);
+      other_charmove->setAnimation(&other->getAnimation());
+      other_charmove->setCamera(parts->cam);
+
+      glm::vec2 pos = height_map.center() +
+                      3.0f * glm::vec2(i % 8 - 4, -(i / 8 + 1));
+      other->transform()->set_local_pos(
+          glm::vec3{pos.x, height_map.heightAt(pos.x, pos.y), pos.y});
+    });
+  }
 
-  PrintDebugText("Initializing the trees");
-    addComponent<Tree>(height_map);
-  PrintDebugTime();
+  queue.push("trees", [this, parts, profile, tree_assets]() {
+    PrintDebugText("Initializing the trees");
+      addComponent<Tree>(parts->terrain->height_map(), profile.trees,
+                         profile.tree_spacing, tree_assets.get());
+    PrintDebugTime();
+  });
 
-  PrintDebugText("Initializing the resources for the after effects");
-    AfterEffects *after_effects = addComponent<AfterEffects>(skybox);
-    shadow->set_default_fbo(after_effects->fbo());
-    after_effects->set_group(1);
-  PrintDebugTime();
+  queue.push("after effects", [this, parts]() {
+    PrintDebugText("Initializing the resources for the after effects");
+      AfterEffects *after_effects = addComponent<AfterEffects>(parts->skybox);
+      parts->shadow->set_default_fbo(after_effects->fbo());
+      after_effects->set_group(1);
+    PrintDebugTime();
+  });
+
+  queue.push("overlays", [this]() {
+    PrintDebugText("Initializing the FPS display");
+      auto fps = addComponent<FpsDisplay>();
+      fps->set_group(2);
+      auto profiler_overlay = addComponent<engine::debug::ProfilerOverlay>();
+      profiler_overlay->set_group(2);
+      auto gl_stats_overlay = addComponent<engine::debug::GlStatsOverlay>();
+      gl_stats_overlay->set_group(2);
+    PrintDebugTime();
+  });
 
-  PrintDebugText("Initializing the FPS display");
-    auto fps = addComponent<FpsDisplay>();
-    fps->set_group(2);
-  PrintDebugTime();
+  queue.push("input mode", [this]() {
+    // Disable cursor
+#if !ENGINE_NO_FULLSCREEN
+    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+#endif
+  });
 }
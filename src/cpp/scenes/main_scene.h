@@ -5,10 +5,11 @@
 
 #include "../engine/scene.h"
 #include "../charmove.h"
+#include "./stress_profile.h"
 
 class MainScene : public engine::Scene {
  public:
-  MainScene();
+  explicit MainScene(const StressProfile& profile = {});
   virtual float gravity() const override { return 18.0f; }
 };
 
@@ -0,0 +1,40 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef LOD_SCENES_STRESS_PROFILE_H_
+#define LOD_SCENES_STRESS_PROFILE_H_
+
+#include <string>
+
+// The amount of content in the scenes, so that they can be scaled up for the
+// capacity tests (see main.cc). The defaults give the original scenes.
+struct StressProfile {
+  int terrain_size = 0;  // generated hills of this size, or terrain.png if 0
+  int trees = -1;  // at most this many trees, or as many as fit if negative
+  int tree_spacing = 150;
+  int cubes = 0;  // dropped at the start (BulletHeightFieldScene)
+  int ayumis = 1;  // all of them follow the player's input (MainScene)
+
+  // Sets one of the standard profiles: "default", "medium" or "large".
+  // Returns false if there is no such profile.
+  bool setPreset(const std::string& name) {
+    if (name == "default") {
+      *this = StressProfile{};
+    } else if (name == "medium") {
+      trees = 400;
+      tree_spacing = 75;
+      cubes = 500;
+      ayumis = 8;
+    } else if (name == "large") {
+      terrain_size = 4096;
+      trees = 2000;
+      tree_spacing = 60;
+      cubes = 2000;
+      ayumis = 32;
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "./skybox.h"
 #include "oglwrap/context.h"
 #include "oglwrap/smart_enums.h"
+#include "engine/debug/gl_memory.h"
 
 Shadow::Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
                int atlas_x_size, int atlas_y_size)
@@ -21,6 +22,9 @@ Shadow::Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
   gl::Bind(tex_);
   tex_.upload(gl::kDepthComponent, size_*xsize_, size_*ysize_,
               gl::kDepthComponent, gl::kFloat, nullptr);
+  tex_memory_ = engine::debug::MemoryTracker::Allocation{"shadow", "atlas",
+      engine::debug::MemoryTracker::Category::kGpuTexture,
+      engine::debug::BoundTexture2DSize()};
   tex_.maxAnisotropy();
   tex_.minFilter(gl::kLinear);
   tex_.magFilter(gl::kLinear);
@@ -9,6 +9,7 @@
 #include "oglwrap/uniform.h"
 #include "oglwrap/framebuffer.h"
 #include "engine/game_object.h"
+#include "engine/debug/memory_tracker.h"
 
 class Skybox;
 
@@ -41,6 +42,7 @@ class Shadow : public engine::GameObject {
 
  private:
   gl::Texture2D tex_;
+  engine::debug::MemoryTracker::Allocation tex_memory_;
   gl::Framebuffer fbo_, *default_fbo_;
 
   size_t w_, h_, size_;
@@ -1,14 +1,49 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include "./terrain.h"
+#include <cmath>
 #include <string>
+#include <vector>
+#include <utility>
 
+#include "engine/misc.h"
 #include "engine/scene.h"
+#include "engine/game_engine.h"
+#include "engine/texture_loader.h"
 
-Terrain::Terrain(engine::GameObject* parent)
+std::shared_ptr<const engine::HeightMap<GLubyte>> Terrain::LoadHeightMap(
+    int size) {
+  using HeightMap = engine::HeightMap<GLubyte>;
+  if (size <= 0) {
+    return engine::GameEngine::asset_cache()->get<HeightMap>("terrain.png",
+        []() {
+      return engine::make_unique<HeightMap>(
+          "src/resources/terrain/terrain.png");
+    });
+  }
+
+  return engine::GameEngine::asset_cache()->get<HeightMap>(
+      "hills:" + std::to_string(size), [size]() {
+    // Rolling hills, so that the level of detail varies like on terrain.png
+    std::vector<GLubyte> heights(size_t(size) * size);
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        heights[size_t(y)*size + x] = 127.5 + 64 * std::sin(x * 0.01) +
+                                      63 * std::cos(y * 0.013);
+      }
+    }
+    return engine::make_unique<HeightMap>(size, size, heights);
+  });
+}
+
+Terrain::Terrain(engine::GameObject* parent, int size)
+    : Terrain(parent, LoadHeightMap(size)) {}
+
+Terrain::Terrain(engine::GameObject* parent,
+                 std::shared_ptr<const engine::HeightMap<GLubyte>> height_map)
     : engine::GameObject(parent)
-    , height_map_("src/resources/terrain/terrain.png")
-    , mesh_(scene_->shader_manager(), height_map_)
+    , height_map_(std::move(height_map))
+    , mesh_(scene_->shader_manager(), *height_map_)
     , prog_(scene_->shader_manager()->get("terrain.vert"),
             scene_->shader_manager()->get("terrain.frag"))
     , uProjectionMatrix_(prog_, "uProjectionMatrix")
@@ -22,28 +57,26 @@ Terrain::Terrain(engine::GameObject* parent)
   gl::UniformSampler(prog_, "uGrassMap0").set(2);
   gl::UniformSampler(prog_, "uGrassMap1").set(3);
   for (int i = 0; i < 2; ++i) {
-    gl::Bind(grassMaps_[i]);
     // no alpha channel here
-    grassMaps_[i].loadTexture(std::string{"src/resources/textures/"} +
+    grassMaps_[i] = engine::GetTexture(
+        std::string{"src/resources/textures/"} +
         (i == 0 ? "grass.jpg" : "grass_2.jpg"), "CSRGB");
-    grassMaps_[i].generateMipmap();
-    grassMaps_[i].maxAnisotropy();
-    grassMaps_[i].minFilter(gl::kLinearMipmapLinear);
-    grassMaps_[i].magFilter(gl::kLinear);
-    grassMaps_[i].wrapS(gl::kRepeat);
-    grassMaps_[i].wrapT(gl::kRepeat);
+    grassMaps_[i]->maxAnisotropy();
+    grassMaps_[i]->minFilter(gl::kLinearMipmapLinear);
+    grassMaps_[i]->magFilter(gl::kLinear);
+    grassMaps_[i]->wrapS(gl::kRepeat);
+    grassMaps_[i]->wrapT(gl::kRepeat);
   }
 
   gl::UniformSampler(prog_, "uGrassNormalMap").set(4);
-  gl::Bind(grassNormalMap_);
   {
     // the normal map doesn't have an alpha channel, and is not is srgb space
-    grassNormalMap_.loadTexture("src/resources/textures/grass_normal.jpg", "CRGB");
-    grassNormalMap_.generateMipmap();
-    grassNormalMap_.minFilter(gl::kLinearMipmapLinear);
-    grassNormalMap_.magFilter(gl::kLinear);
-    grassNormalMap_.wrapS(gl::kRepeat);
-    grassNormalMap_.wrapT(gl::kRepeat);
+    grassNormalMap_ = engine::GetTexture(
+        "src/resources/textures/grass_normal.jpg", "CRGB");
+    grassNormalMap_->minFilter(gl::kLinearMipmapLinear);
+    grassNormalMap_->magFilter(gl::kLinear);
+    grassNormalMap_->wrapS(gl::kRepeat);
+    grassNormalMap_->wrapT(gl::kRepeat);
   }
 
   gl::UniformSampler(prog_, "uShadowMap").set(5);
@@ -68,9 +101,9 @@ void Terrain::render() {
     uShadowAtlasSize_ = shadow->getAtlasDimensions();
   }
 
-  gl::BindToTexUnit(grassMaps_[0], 2);
-  gl::BindToTexUnit(grassMaps_[1], 3);
-  gl::BindToTexUnit(grassNormalMap_, 4);
+  gl::BindToTexUnit(*grassMaps_[0], 2);
+  gl::BindToTexUnit(*grassMaps_[1], 3);
+  gl::BindToTexUnit(*grassNormalMap_, 4);
   if (shadow) {
     gl::BindToTexUnit(shadow->shadowTex(), 5);
   }
@@ -80,9 +113,9 @@ void Terrain::render() {
   if (shadow) {
     gl::UnbindFromTexUnit(shadow->shadowTex(), 5);
   }
-  gl::UnbindFromTexUnit(grassNormalMap_, 4);
-  gl::UnbindFromTexUnit(grassMaps_[1], 3);
-  gl::UnbindFromTexUnit(grassMaps_[0], 2);
+  gl::UnbindFromTexUnit(*grassNormalMap_, 4);
+  gl::UnbindFromTexUnit(*grassMaps_[1], 3);
+  gl::UnbindFromTexUnit(*grassMaps_[0], 2);
 }
 
 
@@ -3,6 +3,8 @@
 #ifndef LOD_TERRAIN_H_
 #define LOD_TERRAIN_H_
 
+#include <memory>
+
 #include "./skybox.h"
 #include "./shadow.h"
 #include "engine/oglwrap_config.h"
@@ -14,17 +16,27 @@
 
 class Terrain : public engine::GameObject {
  public:
-  explicit Terrain(engine::GameObject* parent);
+  // Uses terrain.png, or generated hills of size x size texels, if size > 0.
+  explicit Terrain(engine::GameObject* parent, int size = 0);
+  // Uses a height map that has been loaded already (i.e. on a worker thread).
+  Terrain(engine::GameObject* parent,
+          std::shared_ptr<const engine::HeightMap<GLubyte>> height_map);
   virtual ~Terrain() {}
 
-  const engine::HeightMapInterface& height_map() { return height_map_; }
+  const engine::HeightMapInterface& height_map() { return *height_map_; }
+
+  // Loads terrain.png, or generates hills of size x size texels, if size > 0,
+  // or returns the one that a scene has loaded already (see AssetCache).
+  // It doesn't need the context.
+  static std::shared_ptr<const engine::HeightMap<GLubyte>> LoadHeightMap(
+      int size);
 
  private:
-  engine::HeightMap<GLubyte> height_map_;
+  std::shared_ptr<const engine::HeightMap<GLubyte>> height_map_;
   engine::cdlod::TerrainMesh mesh_;
   engine::ShaderProgram prog_;  // has to be inited after mesh_
 
-  gl::Texture2D grassMaps_[2], grassNormalMap_;
+  std::shared_ptr<gl::Texture2D> grassMaps_[2], grassNormalMap_;
   gl::LazyUniform<glm::mat4> uProjectionMatrix_, uCameraMatrix_,
                              uModelMatrix_, uShadowCP_;
   gl::LazyUniform<int> uNumUsedShadowMaps_;
@@ -1,54 +1,100 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include "./tree.h"
+#include <algorithm>
 #include "engine/scene.h"
+#include "engine/game_engine.h"
 #include "oglwrap/debug/insertion.h"
 
-Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
-    : GameObject(parent)
-    , prog_(scene_->shader_manager()->get("tree.vert"),
-            scene_->shader_manager()->get("tree.frag"))
-    , shadow_prog_(scene_->shader_manager()->get("tree_shadow.vert"),
-                   scene_->shader_manager()->get("tree_shadow.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uModelCameraMatrix_(prog_, "uModelCameraMatrix")
-    , uNormalMatrix_(prog_, "uNormalMatrix")
-    , shadow_uMCP_(shadow_prog_, "uMCP") {
-  gl::Use(shadow_prog_);
-  gl::UniformSampler(shadow_prog_, "uDiffuseTexture").set(0);
-  shadow_prog_.validate();
-
-  gl::Use(prog_);
-
-  meshes_[0] = engine::make_unique<engine::MeshRenderer>(
-    "src/resources/models/trees/massive_swamptree_01_a.obj",
-    aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs |
-    aiProcess_PreTransformVertices);
-  meshes_[1] = engine::make_unique<engine::MeshRenderer>(
-    "src/resources/models/trees/massive_swamptree_01_b.obj",
-    aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs |
-    aiProcess_PreTransformVertices);
-  meshes_[2] = engine::make_unique<engine::MeshRenderer>(
-    "src/resources/models/trees/cedar_01_a_source.obj",
-    aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs |
-    aiProcess_PreTransformVertices);
-
-  for (unsigned i = 0; i < meshes_.size(); ++i) {
-    meshes_[i]->setupPositions(prog_ | "aPosition");
-    meshes_[i]->setupTexCoords(prog_ | "aTexCoord");
-    meshes_[i]->setupNormals(prog_ | "aNormal");
-    meshes_[i]->setupDiffuseTextures(0);
+namespace {
+
+const char* kTreeModels[] = {
+  "src/resources/models/trees/massive_swamptree_01_a.obj",
+  "src/resources/models/trees/massive_swamptree_01_b.obj",
+  "src/resources/models/trees/cedar_01_a_source.obj"
+};
+const unsigned kImportFlags = aiProcessPreset_TargetRealtime_Quality |
+    aiProcess_FlipUVs | aiProcess_PreTransformVertices;
+
+}  // namespace
+
+std::unique_ptr<engine::ImportGraph> TreeAssets::Import() {
+  auto assets = engine::make_unique<engine::ImportGraph>();
+  for (const char* model : kTreeModels) {
+    assets->addMesh(model, kImportFlags);
   }
+  return assets;
+}
 
-  gl::UniformSampler(prog_, "uDiffuseTexture").set(0);
+TreeAssets::TreeAssets(engine::ShaderManager* shader_manager,
+                       engine::ImportGraph* assets) {
+  engine::AssetCache* cache = engine::GameEngine::asset_cache();
+  // The models are imported in parallel, while the shaders are set up
+  std::unique_ptr<engine::ImportGraph> own_assets;
+  auto imports = [&]() {
+    if (!assets) {
+      own_assets = Import();
+      assets = own_assets.get();
+    }
+    return assets;
+  };
+  for (const char* model : kTreeModels) {
+    std::string key = engine::ModelKey(model, kImportFlags);
+    if (!cache->find<engine::MeshRenderer>(key)) {
+      imports();
+      break;
+    }
+  }
 
-  prog_.validate();
+  shadow_prog = cache->get<engine::ShaderProgram>(
+      "tree_shadow.vert|tree_shadow.frag", [shader_manager]() {
+    auto prog = engine::make_unique<engine::ShaderProgram>(
+        shader_manager->get("tree_shadow.vert"),
+        shader_manager->get("tree_shadow.frag"));
+    gl::Use(*prog);
+    gl::UniformSampler(*prog, "uDiffuseTexture").set(0);
+    prog->validate();
+    return prog;
+  });
+
+  prog = cache->get<engine::ShaderProgram>(
+      "tree.vert|tree.frag", [shader_manager]() {
+    auto prog = engine::make_unique<engine::ShaderProgram>(
+        shader_manager->get("tree.vert"), shader_manager->get("tree.frag"));
+    gl::Use(*prog);
+    gl::UniformSampler(*prog, "uDiffuseTexture").set(0);
+    prog->validate();
+    return prog;
+  });
+
+  for (unsigned i = 0; i < meshes.size(); ++i) {
+    meshes[i] = cache->get<engine::MeshRenderer>(
+        engine::ModelKey(kTreeModels[i], kImportFlags), [&]() {
+      auto mesh = engine::make_unique<engine::MeshRenderer>(imports()->get(i));
+      gl::Use(*prog);
+      mesh->setupPositions(*prog | "aPosition");
+      mesh->setupTexCoords(*prog | "aTexCoord");
+      mesh->setupNormals(*prog | "aNormal");
+      mesh->setupDiffuseTextures(0);
+      return mesh;
+    });
+  }
+}
 
+Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map,
+           int max_trees, int spacing, engine::ImportGraph* assets)
+    : GameObject(parent)
+    , assets_(scene_->shader_manager(), assets)
+    , uProjectionMatrix_(*assets_.prog, "uProjectionMatrix")
+    , uModelCameraMatrix_(*assets_.prog, "uModelCameraMatrix")
+    , uNormalMatrix_(*assets_.prog, "uNormalMatrix")
+    , shadow_uMCP_(*assets_.shadow_prog, "uMCP") {
   // Get the trees' positions.
-  const int kTreeDist = 150;
+  const int kTreeDist = std::max(spacing, 4);
   glm::vec2 extent = height_map.extent();
   for (int i = kTreeDist; i + kTreeDist < extent.x; i += kTreeDist) {
     for (int j = kTreeDist; j + kTreeDist < extent.y; j += kTreeDist) {
+      if (max_trees >= 0 && trees_.size() >= size_t(max_trees)) { return; }
       glm::ivec2 coord = glm::ivec2(i + rand()%(kTreeDist/2) - kTreeDist/4,
                                     j + rand()%(kTreeDist/2) - kTreeDist/4);
       glm::vec3 pos =
@@ -63,10 +109,10 @@ Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
       matrix[3] = glm::vec4(pos, 1);
       matrix = glm::scale(matrix, scale);
 
-      int type = rand() % meshes_.size();
+      int type = rand() % assets_.meshes.size();
 
-      engine::BoundingBox bbox = meshes_[type]->boundingBox(matrix);
-      glm::vec4 bsphere = meshes_[type]->bSphere();
+      engine::BoundingBox bbox = assets_.meshes[type]->boundingBox(matrix);
+      glm::vec4 bsphere = assets_.meshes[type]->bSphere();
       bsphere.w *= 1.2;  // removes peter panning (but decreases quality)
 
       trees_.push_back(TreeInfo{type, matrix, bsphere, bbox});
@@ -75,7 +121,7 @@ Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
 }
 
 void Tree::shadowRender() {
-  gl::Use(shadow_prog_);
+  gl::Use(*assets_.shadow_prog);
 
   auto shadow = scene_->shadow();
   gl::TemporaryDisable cullface{gl::kCullFace};
@@ -87,15 +133,15 @@ void Tree::shadowRender() {
     if (glm::length(glm::vec3(trees_[i].mat[3]) - campos) < 150) {
       shadow_uMCP_ = shadow->modelCamProjMat(
           trees_[i].bsphere, trees_[i].mat, glm::mat4{});
-      meshes_[trees_[i].type]->render();
+      assets_.meshes[trees_[i].type]->render();
       shadow->push();
     }
   }
 }
 
 void Tree::render() {
-  gl::Use(prog_);
-  prog_.update();
+  gl::Use(*assets_.prog);
+  assets_.prog->update();
 
   const auto& cam = *scene_->camera();
   uProjectionMatrix_ = cam.projectionMatrix();
@@ -106,7 +152,7 @@ void Tree::render() {
 
   auto campos = cam.transform()->pos();
   auto cam_mx = cam.cameraMatrix();
-  auto frustum = cam.frustum();
+  const auto& frustum = cam.frustum();
   for (size_t i = 0; i < trees_.size(); i++) {
     // Check for visibility
     if (!trees_[i].bbox.collidesWithFrustum(frustum) ||
@@ -114,7 +160,7 @@ void Tree::render() {
       continue;
     }
 
-    auto& mesh = meshes_[trees_[i].type];
+    auto& mesh = assets_.meshes[trees_[i].type];
     glm::mat4 model_mx = trees_[i].mat;
     uModelCameraMatrix_.set(cam_mx * model_mx);
     uNormalMatrix_.set(glm::inverse(glm::mat3(model_mx)));
@@ -5,26 +5,48 @@
 
 #include <vector>
 #include <array>
+#include <memory>
 
 #include "engine/oglwrap_config.h"
 #include "engine/scene.h"
 #include "engine/game_object.h"
+#include "engine/import_graph.h"
 #include "engine/shader_manager.h"
 #include "engine/mesh/mesh_renderer.h"
 #include "engine/height_map_interface.h"
 
+// The meshes and the programs of the tree types. They are taken from the
+// AssetCache (the meshes by their file and import flags), so they are shared
+// by every forest, in every scene that is alive.
+struct TreeAssets {
+  std::array<std::shared_ptr<engine::MeshRenderer>, 3> meshes;
+  // Their diffuse texture is set to texture unit 0.
+  std::shared_ptr<engine::ShaderProgram> prog, shadow_prog;
+
+  // The meshes that aren't in the cache are set up for the programs. They are
+  // taken from the given Import() graph, or imported here if it is nullptr.
+  explicit TreeAssets(engine::ShaderManager* shader_manager,
+                      engine::ImportGraph* assets = nullptr);
+
+  // Starts importing the meshes of the tree types on the thread pool.
+  static std::unique_ptr<engine::ImportGraph> Import();
+};
+
 class Tree : public engine::GameObject {
  public:
-  Tree(GameObject *parent, const engine::HeightMapInterface& height_map);
+  // Places the trees on a grid with the given spacing (with some random
+  // offset), until max_trees is reached, or the terrain is full. The meshes
+  // might come from a TreeAssets::Import() that has been started earlier.
+  Tree(GameObject *parent, const engine::HeightMapInterface& height_map,
+       int max_trees = -1, int spacing = 150,
+       engine::ImportGraph* assets = nullptr);
   virtual ~Tree() {}
+
   virtual void shadowRender() override;
   virtual void render() override;
 
  private:
-  // It should be std::array<engine::MeshRenderer, 3>, but calling its ctor
-  // in the initializer list causes sigsegv in the visual c++ compiler.
-  std::array<std::unique_ptr<engine::MeshRenderer>, 3> meshes_;
-  engine::ShaderProgram prog_, shadow_prog_;
+  TreeAssets assets_;
 
   gl::LazyUniform<glm::mat4> uProjectionMatrix_, uModelCameraMatrix_;
   gl::LazyUniform<glm::mat3> uNormalMatrix_;
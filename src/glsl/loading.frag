@@ -5,7 +5,23 @@
 varying vec2 vTexCoord;
 
 uniform sampler2D uTex;
+uniform float uProgress;  // there is no progress bar if it's negative
+uniform float uTime;
 
 void main() {
-  gl_FragColor = vec4(texture2D(uTex, vTexCoord).rgb, 1.0);
+  vec3 color = texture2D(uTex, vTexCoord).rgb;
+
+  if (uProgress >= 0.0 && 0.92 < vTexCoord.y && vTexCoord.y < 0.94 &&
+      0.1 < vTexCoord.x && vTexCoord.x < 0.9) {
+    float x = (vTexCoord.x - 0.1) / 0.8;
+    if (x < uProgress) {
+      // A light wave runs through the bar, even if the progress stalls.
+      float shine = 0.5 + 0.5 * sin(20.0 * x - 4.0 * uTime);
+      color = mix(vec3(0.7), vec3(1.0), shine);
+    } else {
+      color *= 0.4;
+    }
+  }
+
+  gl_FragColor = vec4(color, 1.0);
 }